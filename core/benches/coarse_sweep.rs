@@ -0,0 +1,104 @@
+use std::borrow::Cow;
+use std::hint::black_box;
+use std::time::Instant;
+
+use msut::utilities::calculate_eic::{CentroidScan, EicOptions, EicSweep, eic_window};
+use msut::utilities::find_peaks::find_peaks_xy;
+use msut::utilities::parse::bin1_view::Values;
+
+fn xorshift(x: &mut u32) -> f64 {
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    *x as f64 / u32::MAX as f64
+}
+
+fn scans(n_scans: usize, n_masses: usize, seed: &mut u32) -> Vec<CentroidScan<'static>> {
+    let masses: Vec<(f64, f64, f64)> = (0..n_masses)
+        .map(|_| {
+            (
+                100.0 + xorshift(seed) * 5.0,
+                xorshift(seed) * n_scans as f64,
+                1e3 + xorshift(seed) * 1e6,
+            )
+        })
+        .collect();
+    (0..n_scans)
+        .map(|i| {
+            let mut points: Vec<(f64, f64)> = masses
+                .iter()
+                .map(|&(mz, apex, height)| {
+                    let d = (i as f64 - apex) / 4.0;
+                    let jitter = (xorshift(seed) - 0.5) * 2e-6 * mz;
+                    (
+                        mz + jitter,
+                        height * (-0.5 * d * d).exp() + xorshift(seed) * 50.0,
+                    )
+                })
+                .collect();
+            points.sort_by(|a, b| a.0.total_cmp(&b.0));
+            let (mz, int): (Vec<f64>, Vec<f64>) = points.into_iter().unzip();
+            let mut s = CentroidScan {
+                rt: i as f64 * 0.05,
+                mz: Cow::Owned(mz),
+                intensity: Values::F64(Cow::Owned(int)),
+                cumulative: None,
+                skip: None,
+            };
+            s.index_intensities();
+            s.index_search();
+            s
+        })
+        .collect()
+}
+
+fn time(label: &str, mut f: impl FnMut() -> (usize, usize)) {
+    let t = Instant::now();
+    let (rows, calls) = f();
+    let ms = t.elapsed().as_secs_f64() * 1e3;
+    println!("  {label:<10} {ms:>8.1} ms  find_peaks {calls}/{rows} rows");
+}
+
+fn coarse(
+    scans: &[CentroidScan],
+    time_axis: &[f64],
+    grid: &[f64],
+    opts: EicOptions,
+    reuse: bool,
+) -> (usize, usize) {
+    let mut sweep = EicSweep::new(scans);
+    let mut calls = 0usize;
+    for m in grid {
+        let (lo, hi) = eic_window(m, opts);
+        let y = sweep.eic(lo, hi);
+        if !(reuse && sweep.unchanged()) {
+            calls += 1;
+            black_box(find_peaks_xy(time_axis, &y, None));
+        }
+    }
+    (grid.len(), calls)
+}
+
+fn main() {
+    let mut seed = 2463534242u32;
+    let opts = EicOptions {
+        ppm_tolerance: 10.0,
+        mz_tolerance: 0.0,
+    };
+    for (n_scans, n_masses, step) in [(200usize, 50usize, 0.005), (200, 500, 0.005)] {
+        let scans = scans(n_scans, n_masses, &mut seed);
+        let time_axis: Vec<f64> = scans.iter().map(|s| s.rt).collect();
+        let grid: Vec<f64> = (0..((5.0 / step) as usize))
+            .map(|k| 100.0 + k as f64 * step)
+            .collect();
+
+        println!(
+            "{n_scans} scans x {n_masses} masses, {} grid masses",
+            grid.len()
+        );
+        time("every row", || {
+            coarse(&scans, &time_axis, &grid, opts, false)
+        });
+        time("reuse", || coarse(&scans, &time_axis, &grid, opts, true));
+    }
+}
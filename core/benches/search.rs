@@ -0,0 +1,76 @@
+use std::hint::black_box;
+use std::time::Instant;
+
+use msut::utilities::calculate_eic::lower_bound;
+use msut::utilities::search::SkipTable;
+
+fn textbook_lower_bound(a: &[f64], x: f64) -> usize {
+    let mut lo = 0usize;
+    let mut hi = a.len();
+    while lo < hi {
+        let mid = (lo + hi) / 2;
+        if a[mid] < x {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    lo
+}
+
+fn xorshift(x: &mut u32) -> f64 {
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    *x as f64 / u32::MAX as f64
+}
+
+fn time(label: &str, queries: &[(usize, f64)], mut f: impl FnMut(usize, f64) -> usize) {
+    let t = Instant::now();
+    let mut acc = 0usize;
+    for _ in 0..5 {
+        for &(s, x) in queries {
+            acc = acc.wrapping_add(f(s, x));
+        }
+    }
+    let ns = t.elapsed().as_nanos() as f64 / (5 * queries.len()) as f64;
+    println!("  {label:<10} {ns:>7.1} ns/query  ({})", black_box(acc));
+}
+
+fn main() {
+    let mut seed = 2463534242u32;
+    for (points, bytes) in [
+        (5_000usize, 1 << 20),
+        (5_000, 64 << 20),
+        (20_000, 1 << 20),
+        (20_000, 64 << 20),
+        (100_000, 64 << 20),
+    ] {
+        let n_scans = (bytes / (points * 8)).max(1);
+        let scans: Vec<Vec<f64>> = (0..n_scans)
+            .map(|_| {
+                let mut m = 50.0;
+                (0..points)
+                    .map(|_| {
+                        m += xorshift(&mut seed) * 2000.0 / points as f64;
+                        m
+                    })
+                    .collect()
+            })
+            .collect();
+        let skips: Vec<SkipTable> = scans.iter().map(|a| SkipTable::new(a)).collect();
+        let queries: Vec<(usize, f64)> = (0..2_000_000)
+            .map(|_| {
+                let s = (xorshift(&mut seed) * n_scans as f64) as usize % n_scans;
+                (s, 50.0 + xorshift(&mut seed) * 2000.0)
+            })
+            .collect();
+
+        println!("{points} points x {n_scans} scans ({} MiB)", bytes >> 20);
+        time("textbook", &queries, |s, x| {
+            textbook_lower_bound(&scans[s], x)
+        });
+        time("branchless", &queries, |s, x| lower_bound(&scans[s], x));
+        time("skip", &queries, |s, x| skips[s].lower_bound(&scans[s], x));
+    }
+}
@@ -1,38 +1,54 @@
-use core::ffi::c_int;
+use core::ffi::{c_char, c_int, c_void};
 use serde_json::json;
 use std::{
+    ffi::CString,
     panic::{AssertUnwindSafe, catch_unwind},
     ptr, slice,
+    sync::atomic::{AtomicI32, Ordering},
 };
 
 pub mod utilities;
 use utilities::{
-    calculate_eic::{EicOptions, calculate_eic_from_bin1},
+    calculate_eic::{EicOptions, calculate_eic_from_bin1, calculate_eics_from_bin1},
     find_noise_level::find_noise_level as find_noise_level_rs,
     find_peaks::{FilterPeaksOptions, FindPeaksOptions, find_peaks as find_peaks_rs},
     get_boundaries::BoundariesOptions,
     get_peak::get_peak as get_peak_rs,
     get_peaks_from_chrom::get_peaks_from_chrom as get_peaks_from_chrom_rs,
     get_peaks_from_eic::get_peaks_from_eic as get_peaks_from_eic_rs,
+    mass_traces::MassTraceOptions,
     parse::{
+        bin1_view::Bin1View,
         decode::{decode, metadata_to_json},
-        encode::encode,
-        parse_mzml::parse_mzml as parse_mzml_rs,
+        mzml_to_bin1::{parse_mzml_to_bin1_filtered, parse_mzml_to_bin1_with_meta},
+        parse_mzml::{ParseFilter, parse_mzml_native_filtered},
     },
     scan_for_peaks::ScanPeaksOptions,
     structs::{DataXY, FromTo, Roi},
 };
 
+#[cfg(not(target_arch = "wasm32"))]
+use utilities::parse::{
+    map_file::map_file, stream_bin1::convert_mzml_to_bin1 as convert_mzml_to_bin1_rs,
+};
+
 use crate::utilities::{
     calculate_baseline::{BaselineOptions, calculate_baseline as calculate_baseline_rs},
-    find_features::{FindFeaturesOptions, MzScanGrid, find_features as find_features_rs},
-    structs::{ChromRoi, EicRoi},
+    find_features::{
+        FeatureEngine, FindFeaturesOptions, MzScanGrid, find_features as find_features_rs,
+    },
+    progress::Progress,
+    session::Session,
+    structs::{ChromRoi, EicRoi, Peak},
+    threads::set_threads,
 };
 
 const OK: c_int = 0;
 const ERR_INVALID_ARGS: c_int = 1;
 const ERR_PANIC: c_int = 2;
+const ERR_IO: c_int = 3;
 const ERR_PARSE: c_int = 4;
+const ERR_CANCELLED: c_int = 5;
 const EPS: f64 = 1e-5;
 
 #[repr(C)]
@@ -57,6 +73,26 @@ pub struct CPeakPOptions {
     pub sn_ratio: f64,
 }
 
+#[repr(C)]
+#[derive(Clone, Copy, Debug)]
+pub struct CParseFilter {
+    pub ms_levels: *const u8,
+    pub ms_levels_len: usize,
+    pub rt_from: f64,
+    pub rt_to: f64,
+    pub polarity: c_int,
+    pub mz_array: c_int,
+    pub intensity_array: c_int,
+    pub chromatograms: c_int,
+}
+
+#[repr(C)]
+pub struct CProgress {
+    pub report: Option<unsafe extern "C" fn(*mut c_void, f64, *const c_char)>,
+    pub user_data: *mut c_void,
+    pub cancel: *const i32,
+}
+
 #[cfg(all(target_arch = "wasm32", not(target_os = "wasi")))]
 #[link(wasm_import_module = "env")]
 unsafe extern "C" {
@@ -99,6 +135,18 @@ pub unsafe extern "C" fn free_(ptr_raw: *mut u8, len: usize) {
 pub unsafe extern "C" fn parse_mzml(
     data_ptr: *const u8,
     data_len: usize,
+    cores: usize,
+    out_data: *mut Buf,
+) -> c_int {
+    unsafe { parse_mzml_filtered(data_ptr, data_len, cores, ptr::null(), out_data) }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn parse_mzml_filtered(
+    data_ptr: *const u8,
+    data_len: usize,
+    cores: usize,
+    filter: *const CParseFilter,
     out_data: *mut Buf,
 ) -> c_int {
     if data_ptr.is_null() || out_data.is_null() {
@@ -106,10 +154,8 @@ pub unsafe extern "C" fn parse_mzml(
     }
     let res = catch_unwind(AssertUnwindSafe(|| -> Result<(), c_int> {
         let data = unsafe { slice::from_raw_parts(data_ptr, data_len) };
-        let parsed = parse_mzml_rs(data, false).map_err(|_| ERR_PARSE)?;
-        let bin = encode(&parsed);
-        write_buf(out_data, bin.into_boxed_slice());
-        Ok(())
+        let filter = parse_filter_from(filter)?;
+        parse_mzml_into(data, cores, &filter, out_data)
     }));
     match res {
         Ok(Ok(())) => OK,
@@ -118,10 +164,93 @@ pub unsafe extern "C" fn parse_mzml(
     }
 }
 
+#[cfg(not(target_arch = "wasm32"))]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn parse_mzml_path(
+    path: *const c_char,
+    cores: usize,
+    out_data: *mut Buf,
+) -> c_int {
+    unsafe { parse_mzml_path_filtered(path, cores, ptr::null(), out_data) }
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn parse_mzml_path_filtered(
+    path: *const c_char,
+    cores: usize,
+    filter: *const CParseFilter,
+    out_data: *mut Buf,
+) -> c_int {
+    if path.is_null() || out_data.is_null() {
+        return ERR_INVALID_ARGS;
+    }
+    let res = catch_unwind(AssertUnwindSafe(|| -> Result<(), c_int> {
+        let filter = parse_filter_from(filter)?;
+        let map = map_c_path(path)?;
+        parse_mzml_into(&map, cores, &filter, out_data)
+    }));
+    match res {
+        Ok(Ok(())) => OK,
+        Ok(Err(code)) => code,
+        Err(_) => ERR_PANIC,
+    }
+}
+
+fn parse_filter_from(c: *const CParseFilter) -> Result<ParseFilter, c_int> {
+    if c.is_null() {
+        return Ok(ParseFilter::ALL);
+    }
+    let c = unsafe { *c };
+    let ms_levels = if c.ms_levels_len == 0 {
+        None
+    } else if c.ms_levels.is_null() {
+        return Err(ERR_INVALID_ARGS);
+    } else {
+        Some(unsafe { slice::from_raw_parts(c.ms_levels, c.ms_levels_len) }.to_vec())
+    };
+    let rt_range = if c.rt_from.is_nan() && c.rt_to.is_nan() {
+        None
+    } else {
+        let open = |v: f64, edge: f64| if v.is_nan() { edge } else { v };
+        let from = open(c.rt_from, f64::NEG_INFINITY);
+        let to = open(c.rt_to, f64::INFINITY);
+        if from > to {
+            return Err(ERR_INVALID_ARGS);
+        }
+        Some(FromTo { from, to })
+    };
+    let polarity = match c.polarity {
+        p if p < 0 => None,
+        0 | 1 => Some(c.polarity as u8),
+        _ => return Err(ERR_INVALID_ARGS),
+    };
+    Ok(ParseFilter {
+        ms_levels,
+        rt_range,
+        polarity,
+        mz_array: c.mz_array != 0,
+        intensity_array: c.intensity_array != 0,
+        chromatograms: c.chromatograms != 0,
+    })
+}
+
+fn parse_mzml_into(
+    data: &[u8],
+    cores: usize,
+    filter: &ParseFilter,
+    out_data: *mut Buf,
+) -> Result<(), c_int> {
+    let bin = parse_mzml_to_bin1_filtered(data, cores.max(1), filter).map_err(|_| ERR_PARSE)?;
+    write_buf(out_data, bin.into_boxed_slice());
+    Ok(())
+}
+
 #[unsafe(no_mangle)]
 pub unsafe extern "C" fn parse_mzml_to_json(
     data_ptr: *const u8,
     data_len: usize,
+    cores: usize,
     out_json: *mut Buf,
     out_blob: *mut Buf,
 ) -> c_int {
@@ -130,12 +259,67 @@ pub unsafe extern "C" fn parse_mzml_to_json(
     }
     let res = catch_unwind(AssertUnwindSafe(|| -> Result<(), c_int> {
         let data = unsafe { slice::from_raw_parts(data_ptr, data_len) };
-        let parsed = parse_mzml_rs(data, true).map_err(|_| ERR_PARSE)?;
-        let meta = metadata_to_json(&parsed).map_err(|_| ERR_PARSE)?;
-        let blob = encode(&parsed);
+        parse_mzml_to_json_into(data, cores, out_json, out_blob)
+    }));
+    match res {
+        Ok(Ok(())) => OK,
+        Ok(Err(code)) => code,
+        Err(_) => ERR_PANIC,
+    }
+}
 
-        write_buf(out_json, meta.into_boxed_slice());
-        write_buf(out_blob, blob.into_boxed_slice());
+#[cfg(not(target_arch = "wasm32"))]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn parse_mzml_to_json_path(
+    path: *const c_char,
+    cores: usize,
+    out_json: *mut Buf,
+    out_blob: *mut Buf,
+) -> c_int {
+    if path.is_null() || out_json.is_null() || out_blob.is_null() {
+        return ERR_INVALID_ARGS;
+    }
+    let res = catch_unwind(AssertUnwindSafe(|| -> Result<(), c_int> {
+        let map = map_c_path(path)?;
+        parse_mzml_to_json_into(&map, cores, out_json, out_blob)
+    }));
+    match res {
+        Ok(Ok(())) => OK,
+        Ok(Err(code)) => code,
+        Err(_) => ERR_PANIC,
+    }
+}
+
+fn parse_mzml_to_json_into(
+    data: &[u8],
+    cores: usize,
+    out_json: *mut Buf,
+    out_blob: *mut Buf,
+) -> Result<(), c_int> {
+    let (parsed, blob) =
+        parse_mzml_to_bin1_with_meta(data, cores.max(1)).map_err(|_| ERR_PARSE)?;
+    let meta = metadata_to_json(&parsed).map_err(|_| ERR_PARSE)?;
+
+    write_buf(out_json, meta.into_boxed_slice());
+    write_buf(out_blob, blob.into_boxed_slice());
+    Ok(())
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn convert_mzml_to_bin1(
+    src_path: *const c_char,
+    dst_path: *const c_char,
+    window: usize,
+) -> c_int {
+    if src_path.is_null() || dst_path.is_null() {
+        return ERR_INVALID_ARGS;
+    }
+    let res = catch_unwind(AssertUnwindSafe(|| -> Result<(), c_int> {
+        let input = std::fs::File::open(c_path(src_path)?).map_err(|_| ERR_IO)?;
+        let output = std::fs::File::create(c_path(dst_path)?).map_err(|_| ERR_IO)?;
+        let output = std::io::BufWriter::with_capacity(1 << 20, output);
+        convert_mzml_to_bin1_rs(input, output, window).map_err(|_| ERR_PARSE)?;
         Ok(())
     }));
     match res {
@@ -201,6 +385,8 @@ pub unsafe extern "C" fn get_peaks_from_eic(
     rts_ptr: *const f64,
     mzs_ptr: *const f64,
     ranges_ptr: *const f64,
+    froms_ptr: *const f64,
+    tos_ptr: *const f64,
     ids_off_ptr: *const u32,
     ids_len_ptr: *const u32,
     ids_buf_ptr: *const u8,
@@ -210,6 +396,7 @@ pub unsafe extern "C" fn get_peaks_from_eic(
     to_right: f64,
     options: *const CPeakPOptions,
     cores: usize,
+    progress: *const CProgress,
     out_json: *mut Buf,
 ) -> i32 {
     if bin_ptr.is_null()
@@ -223,90 +410,35 @@ pub unsafe extern "C" fn get_peaks_from_eic(
     }
     let run = || -> Result<(), i32> {
         let bytes = unsafe { std::slice::from_raw_parts(bin_ptr, bin_len) };
-        let rts = unsafe { std::slice::from_raw_parts(rts_ptr, n_items) };
-        let mzs = unsafe { std::slice::from_raw_parts(mzs_ptr, n_items) };
-        let ranges = unsafe { std::slice::from_raw_parts(ranges_ptr, n_items) };
-
-        let has_ids = !(ids_off_ptr.is_null()
-            || ids_len_ptr.is_null()
-            || ids_buf_ptr.is_null()
-            || ids_buf_len == 0);
-        let (offs, lens, ibuf) = if has_ids {
-            (
-                unsafe { std::slice::from_raw_parts(ids_off_ptr, n_items) },
-                unsafe { std::slice::from_raw_parts(ids_len_ptr, n_items) },
-                Some(unsafe { std::slice::from_raw_parts(ids_buf_ptr, ids_buf_len) }),
+        let items = unsafe {
+            read_eic_rois(
+                rts_ptr,
+                mzs_ptr,
+                ranges_ptr,
+                froms_ptr,
+                tos_ptr,
+                ids_off_ptr,
+                ids_len_ptr,
+                ids_buf_ptr,
+                ids_buf_len,
+                n_items,
             )
-        } else {
-            (&[][..], &[][..], None)
         };
 
-        let mut items: Vec<EicRoi> = Vec::with_capacity(n_items);
-        for i in 0..n_items {
-            let rt = rts[i];
-            let mz = mzs[i];
-            let win = ranges[i];
-            let ok = rt.is_finite() && mz.is_finite() && win.is_finite() && win > 0.0;
-
-            let id = if let Some(buf) = ibuf {
-                if has_ids {
-                    let o = offs[i] as usize;
-                    let l = lens[i] as usize;
-                    if o.checked_add(l).map_or(true, |e| e > buf.len()) {
-                        String::new()
-                    } else {
-                        std::str::from_utf8(&buf[o..o + l])
-                            .unwrap_or("")
-                            .to_string()
-                    }
-                } else {
-                    String::new()
-                }
-            } else {
-                String::new()
-            };
-
-            if ok {
-                items.push(EicRoi {
-                    id,
-                    rt,
-                    mz,
-                    window: win,
-                });
-            } else {
-                items.push(EicRoi {
-                    id: String::new(),
-                    rt: 0.0,
-                    mz: 0.0,
-                    window: 0.0,
-                });
-            }
-        }
-
         let window = FromTo {
             from: from_left,
             to: to_right,
         };
         let fp = build_find_peaks_options(options);
-        let peaks = get_peaks_from_eic_rs(bytes, window, items.as_slice(), Some(fp), cores)
-            .ok_or(ERR_PARSE)?;
-
-        let mut arr = Vec::with_capacity(peaks.len());
-        for (id, ort, mz, p) in peaks {
-            arr.push(serde_json::json!({
-                "id": id,
-                "mz": mz,
-                "ort": ort,
-                "rt": p.rt,
-                "from": p.from,
-                "to": p.to,
-                "intensity": p.intensity,
-                "integral": p.integral,
-                "noise": p.noise
-            }));
+        let progress = unsafe { read_progress(progress) };
+        let peaks =
+            get_peaks_from_eic_rs(bytes, window, items.as_slice(), Some(fp), cores, &progress);
+        if progress.cancelled() {
+            return Err(ERR_CANCELLED);
         }
-        let s = serde_json::to_string(&arr).map_err(|_| ERR_PARSE)?;
-        write_buf(out_json, s.into_bytes().into_boxed_slice());
+        let peaks = peaks.ok_or(ERR_PARSE)?;
+
+        write_buf(out_json, eic_peaks_json(peaks)?);
         Ok(())
     };
     match std::panic::catch_unwind(std::panic::AssertUnwindSafe(run)) {
@@ -339,62 +471,18 @@ pub unsafe extern "C" fn get_peaks_from_chrom(
     }
     let run = || -> Result<(), i32> {
         let bin = unsafe { std::slice::from_raw_parts(bin_ptr, bin_len) };
-        let idxs = unsafe { std::slice::from_raw_parts(idxs_ptr, n_items) };
-        let rts = unsafe { std::slice::from_raw_parts(rts_ptr, n_items) };
-        let wins = unsafe { std::slice::from_raw_parts(ranges_ptr, n_items) };
-        let mzml = decode(bin).map_err(|_| ERR_PARSE)?;
-        let chroms = &mzml.run.as_ref().ok_or(ERR_PARSE)?.chromatograms;
-
-        let mut items = Vec::with_capacity(n_items);
-        for i in 0..n_items {
-            let iu = idxs[i];
-            if iu == u32::MAX {
-                items.push(ChromRoi {
-                    id: String::new(),
-                    idx: usize::MAX,
-                    rt: 0.0,
-                    window: 0.0,
-                });
-                continue;
-            }
-            let idx = iu as usize;
-            if idx >= chroms.len() {
-                items.push(ChromRoi {
-                    id: String::new(),
-                    idx,
-                    rt: 0.0,
-                    window: 0.0,
-                });
-                continue;
-            }
-            let id = chroms[idx].id.clone();
-            items.push(ChromRoi {
-                id,
-                idx,
-                rt: rts[i],
-                window: wins[i],
-            });
-        }
+        let view = Bin1View::new(bin).map_err(|_| ERR_PARSE)?;
+        let items = unsafe {
+            read_chrom_rois(idxs_ptr, rts_ptr, ranges_ptr, n_items, |i| {
+                (i < view.chromatogram_count()).then(|| view.chromatogram_id(i).to_string())
+            })
+        };
 
         let fp = build_find_peaks_options(options);
         let list =
-            get_peaks_from_chrom_rs(&mzml, items.as_slice(), Some(fp), cores).ok_or(ERR_PARSE)?;
-
-        let mut out = Vec::with_capacity(list.len());
-        for (index, id, ort, rt, from_, to_, intensity, integral) in list {
-            out.push(serde_json::json!({
-                "index": index,
-                "id": id,
-                "ort": ort,
-                "rt": rt,
-                "from": from_,
-                "to": to_,
-                "intensity": intensity,
-                "integral":  integral
-            }));
-        }
-        let s = serde_json::to_string(&out).map_err(|_| ERR_PARSE)?;
-        write_buf(out_json, s.into_bytes().into_boxed_slice());
+            get_peaks_from_chrom_rs(&view, items.as_slice(), Some(fp), cores).ok_or(ERR_PARSE)?;
+
+        write_buf(out_json, chrom_peaks_json(list)?);
         Ok(())
     };
     match std::panic::catch_unwind(std::panic::AssertUnwindSafe(run)) {
@@ -500,6 +588,7 @@ pub unsafe extern "C" fn calculate_eic(
     to_time: f64,
     ppm_tolerance: f64,
     mz_tolerance: f64,
+    cores: usize,
     out_x: *mut Buf,
     out_y: *mut Buf,
 ) -> c_int {
@@ -520,6 +609,7 @@ pub unsafe extern "C" fn calculate_eic(
                 ppm_tolerance,
                 mz_tolerance,
             },
+            cores,
         )
         .map_err(|_| ERR_PARSE)?;
 
@@ -536,6 +626,44 @@ pub unsafe extern "C" fn calculate_eic(
     }
 }
 
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn calculate_eics(
+    bin_ptr: *const u8,
+    bin_len: usize,
+    targets_ptr: *const f64,
+    n_targets: usize,
+    ppm_ptr: *const f64,
+    mz_tol_ptr: *const f64,
+    n_tols: usize,
+    from_time: f64,
+    to_time: f64,
+    out_x: *mut Buf,
+    out_y: *mut Buf,
+) -> c_int {
+    if bin_ptr.is_null() || out_x.is_null() || out_y.is_null() {
+        return ERR_INVALID_ARGS;
+    }
+    let res = catch_unwind(AssertUnwindSafe(|| -> Result<(), c_int> {
+        let bin = unsafe { slice::from_raw_parts(bin_ptr, bin_len) };
+        let (targets, options) =
+            unsafe { read_eic_targets(targets_ptr, n_targets, ppm_ptr, mz_tol_ptr, n_tols)? };
+        let window = FromTo {
+            from: from_time,
+            to: to_time,
+        };
+        let eics =
+            calculate_eics_from_bin1(bin, targets, &options, window).map_err(|_| ERR_PARSE)?;
+        write_buf(out_x, f64_slice_to_u8_box(&eics.x));
+        write_buf(out_y, f64_slice_to_u8_box(&eics.y));
+        Ok(())
+    }));
+    match res {
+        Ok(Ok(())) => OK,
+        Ok(Err(code)) => code,
+        Err(_) => ERR_PANIC,
+    }
+}
+
 #[unsafe(no_mangle)]
 pub unsafe extern "C" fn find_features(
     data_ptr: *const u8,
@@ -547,8 +675,11 @@ pub unsafe extern "C" fn find_features(
     grid_start: f64,
     grid_end: f64,
     grid_step: f64,
+    engine: c_int,
+    trace_ppm_tolerance: f64,
     peak_opts: *const CPeakPOptions,
     cores: c_int,
+    progress: *const CProgress,
     out_json: *mut Buf,
 ) -> c_int {
     if data_ptr.is_null() || out_json.is_null() || !from_time.is_finite() || !to_time.is_finite() {
@@ -558,60 +689,78 @@ pub unsafe extern "C" fn find_features(
         return ERR_INVALID_ARGS;
     }
 
+    let cores = if cores > 0 { cores as usize } else { 1 };
     let run = || -> Result<(), c_int> {
         let bytes = unsafe { slice::from_raw_parts(data_ptr, data_len) };
+        find_features_into(
+            bytes,
+            from_time,
+            to_time,
+            eic_ppm_tolerance,
+            eic_mz_tolerance,
+            grid_start,
+            grid_end,
+            grid_step,
+            engine,
+            trace_ppm_tolerance,
+            peak_opts,
+            cores,
+            progress,
+            out_json,
+        )
+    };
 
-        let mzml = parse_mzml_rs(bytes, true).map_err(|_| ERR_PARSE)?;
-
-        let mut eic_opts = EicOptions::default();
-        if eic_ppm_tolerance.is_finite() && eic_ppm_tolerance >= 0.0 {
-            eic_opts.ppm_tolerance = eic_ppm_tolerance;
-        }
-        if eic_mz_tolerance.is_finite() && eic_mz_tolerance >= 0.0 {
-            eic_opts.mz_tolerance = eic_mz_tolerance;
-        }
-
-        let mut mzr = MzScanGrid::default();
-        if grid_start.is_finite() {
-            mzr.mz_min = grid_start;
-        }
-        if grid_end.is_finite() {
-            mzr.mz_max = grid_end;
-        }
-        if grid_step > 0.0 {
-            mzr.step_size = grid_step as f64;
-        }
+    match catch_unwind(AssertUnwindSafe(run)) {
+        Ok(Ok(())) => OK,
+        Ok(Err(code)) => code,
+        Err(_) => ERR_PANIC,
+    }
+}
 
-        let fp_opts = build_find_peaks_options(peak_opts);
+#[cfg(not(target_arch = "wasm32"))]
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn find_features_path(
+    path: *const c_char,
+    from_time: f64,
+    to_time: f64,
+    eic_ppm_tolerance: f64,
+    eic_mz_tolerance: f64,
+    grid_start: f64,
+    grid_end: f64,
+    grid_step: f64,
+    engine: c_int,
+    trace_ppm_tolerance: f64,
+    peak_opts: *const CPeakPOptions,
+    cores: c_int,
+    progress: *const CProgress,
+    out_json: *mut Buf,
+) -> c_int {
+    if path.is_null() || out_json.is_null() || !from_time.is_finite() || !to_time.is_finite() {
+        return ERR_INVALID_ARGS;
+    }
+    if !(to_time > from_time) {
+        return ERR_INVALID_ARGS;
+    }
 
-        let feats = find_features_rs(
-            &mzml,
-            FromTo {
-                from: from_time,
-                to: to_time,
-            },
-            Some(FindFeaturesOptions {
-                eic_options: Some(eic_opts),
-                find_peaks: Some(fp_opts),
-                mz_scan_grid: Some(mzr),
-                ..Default::default()
-            }),
-            if cores > 0 { cores as usize } else { 1 },
-        );
-
-        let mut arr = Vec::with_capacity(feats.len());
-        for f in feats {
-            arr.push(serde_json::json!({
-                "mz":        f64_ok(f.mz),
-                "rt":        f64_ok(f.rt),
-                "intensity": f64_ok(f.intensity),
-                "from": f64_ok(f.from),
-                "to": f64_ok(f.to),
-            }));
-        }
-        let s = serde_json::to_string(&arr).map_err(|_| ERR_PARSE)?;
-        write_buf(out_json, s.into_bytes().into_boxed_slice());
-        Ok(())
+    let cores = if cores > 0 { cores as usize } else { 1 };
+    let run = || -> Result<(), c_int> {
+        let map = map_c_path(path)?;
+        find_features_into(
+            &map,
+            from_time,
+            to_time,
+            eic_ppm_tolerance,
+            eic_mz_tolerance,
+            grid_start,
+            grid_end,
+            grid_step,
+            engine,
+            trace_ppm_tolerance,
+            peak_opts,
+            cores,
+            progress,
+            out_json,
+        )
     };
 
     match catch_unwind(AssertUnwindSafe(run)) {
@@ -621,6 +770,100 @@ pub unsafe extern "C" fn find_features(
     }
 }
 
+fn find_features_into(
+    bytes: &[u8],
+    from_time: f64,
+    to_time: f64,
+    eic_ppm_tolerance: f64,
+    eic_mz_tolerance: f64,
+    grid_start: f64,
+    grid_end: f64,
+    grid_step: f64,
+    engine: c_int,
+    trace_ppm_tolerance: f64,
+    peak_opts: *const CPeakPOptions,
+    cores: usize,
+    progress: *const CProgress,
+    out_json: *mut Buf,
+) -> Result<(), c_int> {
+    let engine = match engine {
+        0 => FeatureEngine::Grid,
+        1 => FeatureEngine::MassTrace,
+        _ => return Err(ERR_INVALID_ARGS),
+    };
+
+    let filter = ParseFilter {
+        chromatograms: false,
+        ..ParseFilter::ms1_in(FromTo {
+            from: from_time,
+            to: to_time,
+        })
+    };
+    let mzml = parse_mzml_native_filtered(bytes, true, cores, &filter).map_err(|_| ERR_PARSE)?;
+
+    let mut eic_opts = EicOptions::default();
+    if eic_ppm_tolerance.is_finite() && eic_ppm_tolerance >= 0.0 {
+        eic_opts.ppm_tolerance = eic_ppm_tolerance;
+    }
+    if eic_mz_tolerance.is_finite() && eic_mz_tolerance >= 0.0 {
+        eic_opts.mz_tolerance = eic_mz_tolerance;
+    }
+
+    let mut mzr = MzScanGrid::default();
+    if grid_start.is_finite() {
+        mzr.mz_min = grid_start;
+    }
+    if grid_end.is_finite() {
+        mzr.mz_max = grid_end;
+    }
+    if grid_step > 0.0 {
+        mzr.step_size = grid_step as f64;
+    }
+
+    let mut trace_opts = MassTraceOptions::default();
+    if trace_ppm_tolerance.is_finite() && trace_ppm_tolerance > 0.0 {
+        trace_opts.ppm_tolerance = trace_ppm_tolerance;
+    }
+
+    let fp_opts = build_find_peaks_options(peak_opts);
+    let progress = unsafe { read_progress(progress) };
+
+    let feats = find_features_rs(
+        &mzml,
+        FromTo {
+            from: from_time,
+            to: to_time,
+        },
+        Some(FindFeaturesOptions {
+            engine: Some(engine),
+            eic_options: Some(eic_opts),
+            find_peaks: Some(fp_opts),
+            mz_scan_grid: Some(mzr),
+            mass_trace: Some(trace_opts),
+            ..Default::default()
+        }),
+        cores,
+        &progress,
+    );
+    if progress.cancelled() {
+        return Err(ERR_CANCELLED);
+    }
+
+    let mut arr = Vec::with_capacity(feats.len());
+    for f in feats {
+        arr.push(serde_json::json!({
+            "mz":        f64_ok(f.mz),
+            "rt":        f64_ok(f.rt),
+            "intensity": f64_ok(f.intensity),
+            "from": f64_ok(f.from),
+            "to": f64_ok(f.to),
+        }));
+    }
+    let s = serde_json::to_string(&arr).map_err(|_| ERR_PARSE)?;
+    write_buf(out_json, s.into_bytes().into_boxed_slice());
+    Ok(())
+}
+
 fn f64_ok(v: f64) -> f64 {
     if v.is_finite() { v } else { 0.0 }
 }
@@ -664,6 +907,242 @@ pub unsafe extern "C" fn calculate_baseline(
     }
 }
 
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn msut_set_threads(
+    threads: c_int,
+    cpus_ptr: *const c_int,
+    cpus_len: usize,
+) -> c_int {
+    if threads < 0 || (cpus_ptr.is_null() && cpus_len > 0) {
+        return ERR_INVALID_ARGS;
+    }
+    let cpus: &[c_int] = if cpus_len == 0 {
+        &[]
+    } else {
+        unsafe { slice::from_raw_parts(cpus_ptr, cpus_len) }
+    };
+    if cpus.iter().any(|&c| c < 0) {
+        return ERR_INVALID_ARGS;
+    }
+    let cpus: Vec<usize> = cpus.iter().map(|&c| c as usize).collect();
+    match catch_unwind(|| set_threads(threads as usize, &cpus)) {
+        Ok(()) => OK,
+        Err(_) => ERR_PANIC,
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn msut_session_open(
+    bin_ptr: *const u8,
+    bin_len: usize,
+    out_session: *mut *mut Session,
+) -> c_int {
+    if bin_ptr.is_null() || out_session.is_null() {
+        return ERR_INVALID_ARGS;
+    }
+    let res = catch_unwind(AssertUnwindSafe(|| -> Result<(), c_int> {
+        let bin = unsafe { slice::from_raw_parts(bin_ptr, bin_len) };
+        let session = Session::open(bin).map_err(|_| ERR_PARSE)?;
+        unsafe { *out_session = Box::into_raw(Box::new(session)) };
+        Ok(())
+    }));
+    match res {
+        Ok(Ok(())) => OK,
+        Ok(Err(code)) => code,
+        Err(_) => ERR_PANIC,
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn msut_session_close(session: *mut Session) {
+    if !session.is_null() {
+        drop(unsafe { Box::from_raw(session) });
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn msut_session_calculate_eic(
+    session: *const Session,
+    target: f64,
+    from_time: f64,
+    to_time: f64,
+    ppm_tolerance: f64,
+    mz_tolerance: f64,
+    out_x: *mut Buf,
+    out_y: *mut Buf,
+) -> c_int {
+    if session.is_null() || out_x.is_null() || out_y.is_null() {
+        return ERR_INVALID_ARGS;
+    }
+    let res = catch_unwind(AssertUnwindSafe(|| -> Result<(), c_int> {
+        let session = unsafe { &*session };
+        let eic = session
+            .calculate_eic(
+                &target,
+                FromTo {
+                    from: from_time,
+                    to: to_time,
+                },
+                EicOptions {
+                    ppm_tolerance,
+                    mz_tolerance,
+                },
+            )
+            .map_err(|_| ERR_PARSE)?;
+        write_buf(out_x, f64_slice_to_u8_box(&eic.x));
+        write_buf(out_y, f64_slice_to_u8_box(&eic.y));
+        Ok(())
+    }));
+    match res {
+        Ok(Ok(())) => OK,
+        Ok(Err(code)) => code,
+        Err(_) => ERR_PANIC,
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn msut_session_calculate_eics(
+    session: *const Session,
+    targets_ptr: *const f64,
+    n_targets: usize,
+    ppm_ptr: *const f64,
+    mz_tol_ptr: *const f64,
+    n_tols: usize,
+    from_time: f64,
+    to_time: f64,
+    out_x: *mut Buf,
+    out_y: *mut Buf,
+) -> c_int {
+    if session.is_null() || out_x.is_null() || out_y.is_null() {
+        return ERR_INVALID_ARGS;
+    }
+    let res = catch_unwind(AssertUnwindSafe(|| -> Result<(), c_int> {
+        let session = unsafe { &*session };
+        let (targets, options) =
+            unsafe { read_eic_targets(targets_ptr, n_targets, ppm_ptr, mz_tol_ptr, n_tols)? };
+        let window = FromTo {
+            from: from_time,
+            to: to_time,
+        };
+        let eics = session.calculate_eics(targets, &options, window);
+        write_buf(out_x, f64_slice_to_u8_box(&eics.x));
+        write_buf(out_y, f64_slice_to_u8_box(&eics.y));
+        Ok(())
+    }));
+    match res {
+        Ok(Ok(())) => OK,
+        Ok(Err(code)) => code,
+        Err(_) => ERR_PANIC,
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn msut_session_get_peaks_from_eic(
+    session: *const Session,
+    rts_ptr: *const f64,
+    mzs_ptr: *const f64,
+    ranges_ptr: *const f64,
+    froms_ptr: *const f64,
+    tos_ptr: *const f64,
+    ids_off_ptr: *const u32,
+    ids_len_ptr: *const u32,
+    ids_buf_ptr: *const u8,
+    ids_buf_len: usize,
+    n_items: usize,
+    from_left: f64,
+    to_right: f64,
+    options: *const CPeakPOptions,
+    cores: usize,
+    progress: *const CProgress,
+    out_json: *mut Buf,
+) -> c_int {
+    if session.is_null()
+        || rts_ptr.is_null()
+        || mzs_ptr.is_null()
+        || ranges_ptr.is_null()
+        || out_json.is_null()
+        || n_items == 0
+    {
+        return ERR_INVALID_ARGS;
+    }
+    let res = catch_unwind(AssertUnwindSafe(|| -> Result<(), c_int> {
+        let session = unsafe { &*session };
+        let items = unsafe {
+            read_eic_rois(
+                rts_ptr,
+                mzs_ptr,
+                ranges_ptr,
+                froms_ptr,
+                tos_ptr,
+                ids_off_ptr,
+                ids_len_ptr,
+                ids_buf_ptr,
+                ids_buf_len,
+                n_items,
+            )
+        };
+        let window = FromTo {
+            from: from_left,
+            to: to_right,
+        };
+        let fp = build_find_peaks_options(options);
+        let progress = unsafe { read_progress(progress) };
+        let peaks = session.get_peaks_from_eic(window, &items, Some(fp), cores, &progress);
+        if progress.cancelled() {
+            return Err(ERR_CANCELLED);
+        }
+        let peaks = peaks.ok_or(ERR_PARSE)?;
+        write_buf(out_json, eic_peaks_json(peaks)?);
+        Ok(())
+    }));
+    match res {
+        Ok(Ok(())) => OK,
+        Ok(Err(code)) => code,
+        Err(_) => ERR_PANIC,
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn msut_session_get_peaks_from_chrom(
+    session: *const Session,
+    idxs_ptr: *const u32,
+    rts_ptr: *const f64,
+    ranges_ptr: *const f64,
+    n_items: usize,
+    options: *const CPeakPOptions,
+    cores: usize,
+    out_json: *mut Buf,
+) -> c_int {
+    if session.is_null()
+        || idxs_ptr.is_null()
+        || rts_ptr.is_null()
+        || ranges_ptr.is_null()
+        || out_json.is_null()
+        || n_items == 0
+    {
+        return ERR_INVALID_ARGS;
+    }
+    let res = catch_unwind(AssertUnwindSafe(|| -> Result<(), c_int> {
+        let session = unsafe { &*session };
+        let items = unsafe {
+            read_chrom_rois(idxs_ptr, rts_ptr, ranges_ptr, n_items, |i| {
+                session.chromatogram_id(i).map(str::to_string)
+            })
+        };
+        let fp = build_find_peaks_options(options);
+        let list = session
+            .get_peaks_from_chrom(&items, Some(fp), cores)
+            .ok_or(ERR_PARSE)?;
+        write_buf(out_json, chrom_peaks_json(list)?);
+        Ok(())
+    }));
+    match res {
+        Ok(Ok(())) => OK,
+        Ok(Err(code)) => code,
+        Err(_) => ERR_PANIC,
+    }
+}
+
 fn f64_slice_to_u8_box(v: &[f64]) -> Box<[u8]> {
     let n = v.len() * 8;
     let mut out = Vec::<u8>::with_capacity(n);
@@ -686,6 +1165,19 @@ fn pos_usize(raw: c_int, def_: usize) -> usize {
     if raw > 0 { raw as usize } else { def_ }
 }
 
+#[cfg(not(target_arch = "wasm32"))]
+fn c_path<'a>(path: *const c_char) -> Result<&'a std::path::Path, c_int> {
+    let path = unsafe { std::ffi::CStr::from_ptr(path) }
+        .to_str()
+        .map_err(|_| ERR_INVALID_ARGS)?;
+    Ok(std::path::Path::new(path))
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+fn map_c_path(path: *const c_char) -> Result<memmap2::Mmap, c_int> {
+    map_file(c_path(path)?).map_err(|_| ERR_IO)
+}
+
 fn write_buf(out: *mut Buf, bytes: Box<[u8]>) {
     let len = bytes.len();
     let ptr_bytes = Box::into_raw(bytes) as *mut u8;
@@ -700,6 +1192,229 @@ fn write_buf(out: *mut Buf, bytes: Box<[u8]>) {
     };
 }
 
+unsafe fn read_eic_targets<'a>(
+    targets_ptr: *const f64,
+    n_targets: usize,
+    ppm_ptr: *const f64,
+    mz_tol_ptr: *const f64,
+    n_tols: usize,
+) -> Result<(&'a [f64], Vec<EicOptions>), c_int> {
+    if targets_ptr.is_null()
+        || ppm_ptr.is_null()
+        || mz_tol_ptr.is_null()
+        || n_targets == 0
+        || !(n_tols == 1 || n_tols == n_targets)
+    {
+        return Err(ERR_INVALID_ARGS);
+    }
+    let targets = unsafe { slice::from_raw_parts(targets_ptr, n_targets) };
+    let ppm = unsafe { slice::from_raw_parts(ppm_ptr, n_tols) };
+    let mz_tol = unsafe { slice::from_raw_parts(mz_tol_ptr, n_tols) };
+    if !targets.iter().all(|m| m.is_finite()) {
+        return Err(ERR_INVALID_ARGS);
+    }
+    let options = ppm
+        .iter()
+        .zip(mz_tol)
+        .map(|(&ppm_tolerance, &mz_tolerance)| EicOptions {
+            ppm_tolerance,
+            mz_tolerance,
+        })
+        .collect();
+    Ok((targets, options))
+}
+
+unsafe fn read_eic_rois(
+    rts_ptr: *const f64,
+    mzs_ptr: *const f64,
+    ranges_ptr: *const f64,
+    froms_ptr: *const f64,
+    tos_ptr: *const f64,
+    ids_off_ptr: *const u32,
+    ids_len_ptr: *const u32,
+    ids_buf_ptr: *const u8,
+    ids_buf_len: usize,
+    n_items: usize,
+) -> Vec<EicRoi> {
+    let rts = unsafe { slice::from_raw_parts(rts_ptr, n_items) };
+    let mzs = unsafe { slice::from_raw_parts(mzs_ptr, n_items) };
+    let ranges = unsafe { slice::from_raw_parts(ranges_ptr, n_items) };
+    let bounds = (!froms_ptr.is_null() && !tos_ptr.is_null()).then(|| unsafe {
+        (
+            slice::from_raw_parts(froms_ptr, n_items),
+            slice::from_raw_parts(tos_ptr, n_items),
+        )
+    });
+
+    let has_ids = !(ids_off_ptr.is_null()
+        || ids_len_ptr.is_null()
+        || ids_buf_ptr.is_null()
+        || ids_buf_len == 0);
+    let ids = has_ids.then(|| unsafe {
+        (
+            slice::from_raw_parts(ids_off_ptr, n_items),
+            slice::from_raw_parts(ids_len_ptr, n_items),
+            slice::from_raw_parts(ids_buf_ptr, ids_buf_len),
+        )
+    });
+
+    let mut items: Vec<EicRoi> = Vec::with_capacity(n_items);
+    for i in 0..n_items {
+        let rt = rts[i];
+        let mz = mzs[i];
+        let win = ranges[i];
+        if !(rt.is_finite() && mz.is_finite() && win.is_finite() && win > 0.0) {
+            items.push(EicRoi::new("", 0.0, 0.0, 0.0));
+            continue;
+        }
+        let id = match ids {
+            Some((offs, lens, buf)) => {
+                let o = offs[i] as usize;
+                let l = lens[i] as usize;
+                if o.checked_add(l).map_or(true, |e| e > buf.len()) {
+                    String::new()
+                } else {
+                    std::str::from_utf8(&buf[o..o + l])
+                        .unwrap_or("")
+                        .to_string()
+                }
+            }
+            None => String::new(),
+        };
+        let from_to = bounds
+            .map(|(froms, tos)| (froms[i], tos[i]))
+            .filter(|(from, to)| !(from.is_nan() && to.is_nan()))
+            .map(|(from, to)| FromTo {
+                from: if from.is_nan() {
+                    f64::NEG_INFINITY
+                } else {
+                    from
+                },
+                to: if to.is_nan() { f64::INFINITY } else { to },
+            });
+        items.push(EicRoi {
+            id,
+            rt,
+            mz,
+            window: win,
+            from_to,
+        });
+    }
+    items
+}
+
+unsafe fn read_chrom_rois(
+    idxs_ptr: *const u32,
+    rts_ptr: *const f64,
+    ranges_ptr: *const f64,
+    n_items: usize,
+    chrom_id: impl Fn(usize) -> Option<String>,
+) -> Vec<ChromRoi> {
+    let idxs = unsafe { slice::from_raw_parts(idxs_ptr, n_items) };
+    let rts = unsafe { slice::from_raw_parts(rts_ptr, n_items) };
+    let wins = unsafe { slice::from_raw_parts(ranges_ptr, n_items) };
+
+    let mut items = Vec::with_capacity(n_items);
+    for i in 0..n_items {
+        let iu = idxs[i];
+        if iu == u32::MAX {
+            items.push(ChromRoi {
+                id: String::new(),
+                idx: usize::MAX,
+                rt: 0.0,
+                window: 0.0,
+            });
+            continue;
+        }
+        let idx = iu as usize;
+        let Some(id) = chrom_id(idx) else {
+            items.push(ChromRoi {
+                id: String::new(),
+                idx,
+                rt: 0.0,
+                window: 0.0,
+            });
+            continue;
+        };
+        items.push(ChromRoi {
+            id,
+            idx,
+            rt: rts[i],
+            window: wins[i],
+        });
+    }
+    items
+}
+
+struct ProgressPtr(*const CProgress);
+
+unsafe impl Send for ProgressPtr {}
+unsafe impl Sync for ProgressPtr {}
+
+impl ProgressPtr {
+    fn get(&self) -> &CProgress {
+        unsafe { &*self.0 }
+    }
+}
+
+unsafe fn read_progress(progress: *const CProgress) -> Progress {
+    if progress.is_null() {
+        return Progress::new();
+    }
+    let (report, cancel) = (ProgressPtr(progress), ProgressPtr(progress));
+    Progress::new()
+        .with_report(move |fraction, stage| {
+            let c = report.get();
+            if let (Some(f), Ok(stage)) = (c.report, CString::new(stage)) {
+                unsafe { f(c.user_data, fraction, stage.as_ptr()) };
+            }
+        })
+        .with_cancel(move || {
+            let c = cancel.get();
+            !c.cancel.is_null()
+                && unsafe { (*c.cancel.cast::<AtomicI32>()).load(Ordering::Relaxed) } != 0
+        })
+}
+
+fn eic_peaks_json(peaks: Vec<(String, f64, f64, Peak)>) -> Result<Box<[u8]>, c_int> {
+    let mut arr = Vec::with_capacity(peaks.len());
+    for (id, ort, mz, p) in peaks {
+        arr.push(serde_json::json!({
+            "id": id,
+            "mz": mz,
+            "ort": ort,
+            "rt": p.rt,
+            "from": p.from,
+            "to": p.to,
+            "intensity": p.intensity,
+            "integral": p.integral,
+            "noise": p.noise
+        }));
+    }
+    let s = serde_json::to_string(&arr).map_err(|_| ERR_PARSE)?;
+    Ok(s.into_bytes().into_boxed_slice())
+}
+
+fn chrom_peaks_json(
+    list: Vec<(usize, String, f64, f64, f64, f64, f64, f64)>,
+) -> Result<Box<[u8]>, c_int> {
+    let mut out = Vec::with_capacity(list.len());
+    for (index, id, ort, rt, from_, to_, intensity, integral) in list {
+        out.push(serde_json::json!({
+            "index": index,
+            "id": id,
+            "ort": ort,
+            "rt": rt,
+            "from": from_,
+            "to": to_,
+            "intensity": intensity,
+            "integral":  integral
+        }));
+    }
+    let s = serde_json::to_string(&out).map_err(|_| ERR_PARSE)?;
+    Ok(s.into_bytes().into_boxed_slice())
+}
+
 fn build_find_peaks_options(options: *const CPeakPOptions) -> FindPeaksOptions {
     if options.is_null() {
         let ws = odd_at_least(17, 5, 17);
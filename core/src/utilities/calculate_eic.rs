@@ -1,10 +1,21 @@
-use std::{cmp::Ordering, sync::Arc};
+use std::{borrow::Cow, cmp::Ordering, ops::Range};
+
+use rayon::prelude::*;
 
 use crate::utilities::{
-    parse::{decode::decode, parse_mzml::MzML},
+    parse::{
+        bin1_view::{Bin1View, Values},
+        parse_mzml::MzML,
+    },
+    search::{SkipTable, partition},
     structs::{FromTo, Peak},
+    threads::{WithCores, in_pool},
+    tile_index::TileIndex,
 };
 
+const PAR_MIN_SCANS: usize = 512;
+const PAR_CHUNK: usize = 128;
+
 #[derive(Clone, Copy)]
 pub struct EicOptions {
     pub ppm_tolerance: f64,
@@ -30,9 +41,36 @@ pub fn calculate_eic_from_bin1(
     target_mass: &f64,
     from_to: FromTo,
     options: EicOptions,
+    cores: usize,
+) -> Result<Eic, &'static str> {
+    let view = Bin1View::new(bin1).map_err(|_| "decode BIN1 failed")?;
+    calculate_eic_from_view(&view, target_mass, from_to, options, cores)
+}
+
+pub fn calculate_eic_from_view(
+    view: &Bin1View,
+    target_mass: &f64,
+    from_to: FromTo,
+    options: EicOptions,
+    cores: usize,
 ) -> Result<Eic, &'static str> {
-    let mzml = decode(bin1).map_err(|_| "decode BIN1 failed")?;
-    calculate_eic_from_mzml(&mzml, target_mass, from_to, options)
+    in_pool(cores, || {
+        let (times, scans) = view_ms1_scans(view, from_to, cores);
+        eic_from_scans(times, &scans, target_mass, options, cores)
+    })
+}
+
+pub fn calculate_eics_from_bin1(
+    bin1: &[u8],
+    targets: &[f64],
+    options: &[EicOptions],
+    from_to: FromTo,
+) -> Result<Eic, &'static str> {
+    let view = Bin1View::new(bin1).map_err(|_| "decode BIN1 failed")?;
+    let (rts, scans) = collect_ms1_scans_from_view(&view, from_to);
+    Ok(calculate_eics_from_scans(
+        &rts, &scans, targets, options, from_to,
+    ))
 }
 
 pub fn calculate_eic_from_mzml(
@@ -40,31 +78,157 @@ pub fn calculate_eic_from_mzml(
     target_mass: &f64,
     from_to: FromTo,
     options: EicOptions,
+    cores: usize,
+) -> Result<Eic, &'static str> {
+    in_pool(cores, || {
+        let (times, scans) = mzml_ms1_scans(mzml, from_to, cores);
+        eic_from_scans(times, &scans, target_mass, options, cores)
+    })
+}
+
+pub fn calculate_eic_from_scans(
+    rts: &[f64],
+    scans: &[CentroidScan],
+    target_mass: &f64,
+    from_to: FromTo,
+    options: EicOptions,
+) -> Result<Eic, &'static str> {
+    let i0 = lower_bound(rts, from_to.from);
+    let i1 = upper_bound(rts, from_to.to).max(i0);
+    eic_from_scans(
+        rts[i0..i1].to_vec(),
+        &scans[i0..i1],
+        target_mass,
+        options,
+        1,
+    )
+}
+
+fn eic_from_scans(
+    times: Vec<f64>,
+    scans: &[CentroidScan],
+    target_mass: &f64,
+    options: EicOptions,
+    cores: usize,
 ) -> Result<Eic, &'static str> {
-    let (times, scans) = collect_ms1_scans(mzml, from_to);
     if scans.is_empty() || times.is_empty() {
         return Ok(Eic {
             x: Vec::new(),
             y: Vec::new(),
         });
     }
-    let y = compute_eic_for_mz(&scans, times.len(), target_mass, options);
+    let y = if cores > 1 && scans.len() >= PAR_MIN_SCANS {
+        let (lo, hi) = eic_window(target_mass, options);
+        scans
+            .par_iter()
+            .with_cores(cores)
+            .with_min_len(PAR_CHUNK)
+            .map(|s| s.window_sum(lo, hi))
+            .collect()
+    } else {
+        compute_eic_for_mz(scans, times.len(), target_mass, options)
+    };
     Ok(Eic { x: times, y })
 }
 
 #[derive(Clone)]
-pub struct CentroidScan {
+pub struct CentroidScan<'a> {
     pub rt: f64,
-    pub mz: Arc<[f64]>,
-    pub intensity: Arc<[f64]>,
+    pub mz: Cow<'a, [f64]>,
+    pub intensity: Values<'a>,
+    pub cumulative: Option<Vec<f64>>,
+    pub skip: Option<SkipTable>,
 }
 
-pub fn compute_eic_for_mz(
+impl CentroidScan<'_> {
+    pub fn into_owned(self) -> CentroidScan<'static> {
+        CentroidScan {
+            rt: self.rt,
+            mz: Cow::Owned(self.mz.into_owned()),
+            intensity: self.intensity.into_owned(),
+            cumulative: self.cumulative,
+            skip: self.skip,
+        }
+    }
+
+    pub fn index_intensities(&mut self) {
+        let n = self.intensity.len();
+        let mut cumulative = Vec::with_capacity(n + 1);
+        let mut acc = 0.0f64;
+        cumulative.push(acc);
+        for i in 0..n {
+            acc += self.intensity.get(i);
+            cumulative.push(acc);
+        }
+        self.cumulative = Some(cumulative);
+    }
+
+    pub fn index_search(&mut self) {
+        self.skip = Some(SkipTable::new(&self.mz));
+    }
+
+    #[inline]
+    pub fn range_sum(&self, r: Range<usize>) -> f64 {
+        match &self.cumulative {
+            Some(cum) => cum[r.end] - cum[r.start],
+            None => span_sum(&self.intensity, r),
+        }
+    }
+
+    #[inline]
+    pub fn mz_lower_bound(&self, x: f64) -> usize {
+        match &self.skip {
+            Some(skip) => skip.lower_bound(&self.mz, x),
+            None => lower_bound(&self.mz, x),
+        }
+    }
+
+    #[inline]
+    pub fn mz_upper_bound(&self, x: f64) -> usize {
+        match &self.skip {
+            Some(skip) => skip.upper_bound(&self.mz, x),
+            None => upper_bound(&self.mz, x),
+        }
+    }
+
+    #[inline]
+    pub fn window_sum(&self, lo: f64, hi: f64) -> f64 {
+        let j = self.mz_lower_bound(lo);
+        match (&self.cumulative, &self.intensity) {
+            (Some(cum), _) => {
+                let k = self.mz_upper_bound(hi).max(j);
+                cum[k] - cum[j]
+            }
+            (None, Values::F64(ints)) => sum_in_window(&self.mz, ints, j, lo, hi),
+            (None, Values::F32(ints)) => sum_in_window(&self.mz, ints, j, lo, hi),
+        }
+    }
+}
+
+pub fn calculate_eics_from_scans(
+    rts: &[f64],
     scans: &[CentroidScan],
-    rt_len: usize,
-    center: &f64,
-    opts: EicOptions,
-) -> Vec<f64> {
+    targets: &[f64],
+    options: &[EicOptions],
+    from_to: FromTo,
+) -> Eic {
+    let i0 = lower_bound(rts, from_to.from);
+    let i1 = upper_bound(rts, from_to.to).max(i0);
+    let windows: Vec<(f64, f64)> = targets
+        .iter()
+        .enumerate()
+        .map(|(t, mz)| {
+            let opts = options.get(t).or(options.last()).copied();
+            eic_window(mz, opts.unwrap_or_default())
+        })
+        .collect();
+    Eic {
+        x: rts[i0..i1].to_vec(),
+        y: compute_eics_for_mzs(&scans[i0..i1], &windows),
+    }
+}
+
+pub fn eic_window(center: &f64, opts: EicOptions) -> (f64, f64) {
     let tol_ppm = if opts.ppm_tolerance > 0.0 {
         (opts.ppm_tolerance * 1e-6) * center
     } else {
@@ -74,77 +238,354 @@ pub fn compute_eic_for_mz(
     if !(tol.is_finite()) || tol <= 0.0 {
         panic!("[panic] invalid EIC tol for center={}", center);
     }
-    let lo = center - tol;
-    let hi = center + tol;
+    (center - tol, center + tol)
+}
 
-    let mut y = vec![0.0f64; rt_len];
+pub fn compute_eics_for_mzs(scans: &[CentroidScan], windows: &[(f64, f64)]) -> Vec<f64> {
+    if windows.is_empty() {
+        return Vec::new();
+    }
+    let mut order: Vec<usize> = (0..windows.len()).collect();
+    order.sort_by(|&a, &b| {
+        windows[a]
+            .0
+            .partial_cmp(&windows[b].0)
+            .unwrap_or(Ordering::Equal)
+    });
+    let n = scans.len();
+    let mut y = vec![0.0f64; windows.len() * n];
     for (i, s) in scans.iter().enumerate() {
-        let mzs = &s.mz;
-        let ints = &s.intensity;
-        let mut acc = 0.0f64;
-        let mut j = lower_bound(mzs, lo);
-        let mut guard = 0usize;
-        while j < mzs.len() {
-            let v = mzs[j];
-            if v > hi {
-                break;
+        match (&s.cumulative, &s.intensity) {
+            (Some(cum), _) => sweep_indexed(&s.mz, cum, windows, &order, &mut y[i..], n),
+            (None, Values::F64(ints)) => {
+                sweep_windows(&s.mz, ints, windows, &order, &mut y[i..], n)
             }
-            acc += ints[j] as f64;
-            j += 1;
-            guard += 1;
-            if guard > 5_000_000 {
-                panic!(
-                    "[panic] compute_eic_for_mz inner loop too long at rt index {}",
-                    i
-                );
+            (None, Values::F32(ints)) => {
+                sweep_windows(&s.mz, ints, windows, &order, &mut y[i..], n)
             }
         }
-        y[i] = acc;
     }
     y
 }
 
-pub fn collect_ms1_scans(mzml: &MzML, time_window: FromTo) -> (Vec<f64>, Vec<CentroidScan>) {
-    let mut scans = Vec::new();
-    let mut total_points: usize = 0;
-    let mut dropped_points: usize = 0;
+pub struct EicSweep<'a> {
+    scans: &'a [CentroidScan<'a>],
+    lo: Vec<usize>,
+    hi: Vec<usize>,
+    sum: Vec<f64>,
+    last: Option<(f64, f64)>,
+    unchanged: bool,
+}
+
+impl<'a> EicSweep<'a> {
+    pub fn new(scans: &'a [CentroidScan<'a>]) -> Self {
+        Self {
+            scans,
+            lo: vec![0; scans.len()],
+            hi: vec![0; scans.len()],
+            sum: vec![0.0; scans.len()],
+            last: None,
+            unchanged: false,
+        }
+    }
 
-    if let Some(run) = &mzml.run {
-        for s in &run.spectra {
-            let is_ms1 = matches!(s.ms_level, Some(1));
-            let ok_rt = matches!(s.retention_time, Some(rt) if rt >= time_window.from && rt <= time_window.to);
-            let has_arrays = s.mz_array.as_ref().map(|v| !v.is_empty()).unwrap_or(false)
-                && s.intensity_array
-                    .as_ref()
-                    .map(|v| !v.is_empty())
-                    .unwrap_or(false);
-            if is_ms1 && ok_rt && has_arrays {
-                let rt = s.retention_time.unwrap_or_default();
-                let mzs_src = s.mz_array.clone().unwrap_or_default();
-                let ints_src = s.intensity_array.clone().unwrap_or_default();
-                let len = mzs_src.len().min(ints_src.len());
-                let mut mzs = Vec::with_capacity(len);
-                let mut ints = Vec::with_capacity(len);
-                for i in 0..len {
-                    let m = mzs_src[i];
-                    let it = ints_src[i];
-                    total_points += 1;
-                    if m.is_finite() && it.is_finite() {
-                        mzs.push(m);
-                        ints.push(it);
-                    } else {
-                        dropped_points += 1;
-                    }
-                }
-                if !mzs.is_empty() {
-                    scans.push(CentroidScan {
-                        rt,
-                        mz: Arc::from(mzs),
-                        intensity: Arc::from(ints),
-                    });
-                }
+    pub fn unchanged(&self) -> bool {
+        self.unchanged
+    }
+
+    pub fn eic(&mut self, lo: f64, hi: f64) -> Vec<f64> {
+        let seek = self.last.is_none_or(|(l, h)| lo < l || hi < h);
+        self.unchanged = self.last.is_some();
+        self.last = Some((lo, hi));
+        let mut y = vec![0.0f64; self.scans.len()];
+        for (i, s) in self.scans.iter().enumerate() {
+            let mzs = &s.mz;
+            let (mut j, mut k) = if seek {
+                (s.mz_lower_bound(lo), s.mz_upper_bound(hi))
+            } else {
+                (self.lo[i], self.hi[i])
+            };
+            while j < mzs.len() && mzs[j] < lo {
+                j += 1;
             }
+            k = k.max(j);
+            while k < mzs.len() && mzs[k] <= hi {
+                k += 1;
+            }
+            let (old_j, old_k) = (self.lo[i], self.hi[i]);
+            self.unchanged &= (old_j, old_k) == (j, k) || (j == k && old_j == old_k);
+            self.lo[i] = j;
+            self.hi[i] = k;
+            let sum = &mut self.sum[i];
+            *sum = if s.cumulative.is_none() && !seek && j < old_k && j < k {
+                *sum - span_sum(&s.intensity, old_j..j) + span_sum(&s.intensity, old_k..k)
+            } else {
+                s.range_sum(j..k)
+            };
+            y[i] = *sum;
+        }
+        y
+    }
+}
+
+fn sweep_indexed(
+    mzs: &[f64],
+    cumulative: &[f64],
+    windows: &[(f64, f64)],
+    order: &[usize],
+    out: &mut [f64],
+    stride: usize,
+) {
+    let mut j = 0usize;
+    for &t in order {
+        let (lo, hi) = windows[t];
+        j = gallop(mzs, j, lo, false);
+        let k = gallop(mzs, j, hi, true);
+        out[t * stride] = cumulative[k] - cumulative[j];
+    }
+}
+
+fn sweep_windows<T: Copy + Into<f64>>(
+    mzs: &[f64],
+    ints: &[T],
+    windows: &[(f64, f64)],
+    order: &[usize],
+    out: &mut [f64],
+    stride: usize,
+) {
+    let mut j = 0usize;
+    for &t in order {
+        let (lo, hi) = windows[t];
+        j = gallop(mzs, j, lo, false);
+        let mut acc = 0.0f64;
+        let mut k = j;
+        while k < mzs.len() && mzs[k] <= hi {
+            acc += ints[k].into();
+            k += 1;
         }
+        out[t * stride] = acc;
+    }
+}
+
+#[inline]
+fn gallop(a: &[f64], from: usize, x: f64, inclusive: bool) -> usize {
+    let before = |v: f64| if inclusive { v <= x } else { v < x };
+    let mut lo = from;
+    let mut hi = from;
+    let mut step = 1usize;
+    while hi < a.len() && before(a[hi]) {
+        lo = hi + 1;
+        hi += step;
+        step <<= 1;
+    }
+    let rest = &a[lo..hi.min(a.len())];
+    lo + if inclusive {
+        upper_bound(rest, x)
+    } else {
+        lower_bound(rest, x)
+    }
+}
+
+pub fn compute_eic_for_mz(
+    scans: &[CentroidScan],
+    rt_len: usize,
+    center: &f64,
+    opts: EicOptions,
+) -> Vec<f64> {
+    let (lo, hi) = eic_window(center, opts);
+
+    let mut y = vec![0.0f64; rt_len];
+    for (i, s) in scans.iter().enumerate() {
+        y[i] = s.window_sum(lo, hi);
+    }
+    y
+}
+
+pub fn compute_eic_for_mz_tiled(
+    tiles: &TileIndex,
+    data: &[CentroidScan],
+    scans: Range<usize>,
+    center: &f64,
+    opts: EicOptions,
+) -> Vec<f64> {
+    let (lo, hi) = eic_window(center, opts);
+    tiles.eic(data, lo, hi, scans)
+}
+
+#[inline]
+fn span_sum(ints: &Values, r: Range<usize>) -> f64 {
+    match ints {
+        Values::F64(v) => v[r].iter().fold(0.0, |a, &x| a + x),
+        Values::F32(v) => v[r].iter().fold(0.0, |a, &x| a + x as f64),
+    }
+}
+
+#[inline]
+fn sum_in_window<T: Copy + Into<f64>>(
+    mzs: &[f64],
+    ints: &[T],
+    mut j: usize,
+    lo: f64,
+    hi: f64,
+) -> f64 {
+    let mut acc = 0.0f64;
+    let mut guard = 0usize;
+    while j < mzs.len() {
+        let v = mzs[j];
+        if v > hi {
+            break;
+        }
+        acc += ints[j].into();
+        j += 1;
+        guard += 1;
+        if guard > 5_000_000 {
+            panic!(
+                "[panic] compute_eic_for_mz inner loop too long at m/z {}",
+                lo
+            );
+        }
+    }
+    acc
+}
+
+fn finite_points<'a, T: Copy + Into<f64>>(
+    mzs_src: Cow<'a, [f64]>,
+    ints_src: Cow<'a, [T]>,
+    total_points: &mut usize,
+    dropped_points: &mut usize,
+) -> (Cow<'a, [f64]>, Cow<'a, [T]>)
+where
+    [T]: ToOwned<Owned = Vec<T>>,
+{
+    let len = mzs_src.len().min(ints_src.len());
+    *total_points += len;
+    let finite = |(m, it): (&f64, &T)| m.is_finite() && (*it).into().is_finite();
+    if mzs_src.len() == ints_src.len() && mzs_src.iter().zip(ints_src.iter()).all(finite) {
+        return (mzs_src, ints_src);
+    }
+    let mut mzs = Vec::with_capacity(len);
+    let mut ints = Vec::with_capacity(len);
+    for (&m, &it) in mzs_src.iter().zip(ints_src.iter()) {
+        if m.is_finite() && it.into().is_finite() {
+            mzs.push(m);
+            ints.push(it);
+        } else {
+            *dropped_points += 1;
+        }
+    }
+    (Cow::Owned(mzs), Cow::Owned(ints))
+}
+
+pub fn collect_ms1_scans(mzml: &MzML, time_window: FromTo) -> (Vec<f64>, Vec<CentroidScan<'_>>) {
+    mzml_ms1_scans(mzml, time_window, 1)
+}
+
+fn mzml_ms1_scans(
+    mzml: &MzML,
+    time_window: FromTo,
+    cores: usize,
+) -> (Vec<f64>, Vec<CentroidScan<'_>>) {
+    let spectra = mzml.run.as_ref().map_or(&[][..], |r| &r.spectra[..]);
+    gather_ms1_scans(
+        spectra.len(),
+        |i| (spectra[i].ms_level, spectra[i].retention_time),
+        |i| {
+            let s = &spectra[i];
+            let mz = s.mz_array.as_deref().map(Cow::Borrowed);
+            let ints = match (&s.intensity_array, &s.intensity_array_f32) {
+                (Some(v), _) => Some(Values::F64(Cow::Borrowed(&v[..]))),
+                (None, Some(v)) => Some(Values::F32(Cow::Borrowed(&v[..]))),
+                _ => None,
+            };
+            (mz, ints)
+        },
+        time_window,
+        cores,
+    )
+}
+
+pub fn collect_ms1_scans_from_view<'a>(
+    view: &Bin1View<'a>,
+    time_window: FromTo,
+) -> (Vec<f64>, Vec<CentroidScan<'a>>) {
+    view_ms1_scans(view, time_window, 1)
+}
+
+fn view_ms1_scans<'a>(
+    view: &Bin1View<'a>,
+    time_window: FromTo,
+    cores: usize,
+) -> (Vec<f64>, Vec<CentroidScan<'a>>) {
+    gather_ms1_scans(
+        view.spectrum_count(),
+        |i| (view.ms_level(i), view.retention_time(i)),
+        |i| (view.spectrum_mz(i), view.spectrum_intensity(i)),
+        time_window,
+        cores,
+    )
+}
+
+fn gather_ms1_scans<'a>(
+    n: usize,
+    header: impl Fn(usize) -> (Option<u8>, Option<f64>),
+    arrays: impl Fn(usize) -> (Option<Cow<'a, [f64]>>, Option<Values<'a>>) + Sync,
+    time_window: FromTo,
+    cores: usize,
+) -> (Vec<f64>, Vec<CentroidScan<'a>>) {
+    let picked: Vec<(usize, f64)> = (0..n)
+        .filter_map(|i| match header(i) {
+            (ms_level, Some(rt))
+                if ms_level == Some(1) && rt >= time_window.from && rt <= time_window.to =>
+            {
+                Some((i, rt))
+            }
+            _ => None,
+        })
+        .collect();
+    let load = |&(i, rt): &(usize, f64)| {
+        let mut total_points: usize = 0;
+        let mut dropped_points: usize = 0;
+        let (mzs_src, intensity) = match arrays(i) {
+            (Some(m), Some(v)) if !m.is_empty() && !v.is_empty() => (m, v),
+            _ => return (None, 0, 0),
+        };
+        let (mz, intensity) = match intensity {
+            Values::F64(v) => {
+                let (m, i) = finite_points(mzs_src, v, &mut total_points, &mut dropped_points);
+                (m, Values::F64(i))
+            }
+            Values::F32(v) => {
+                let (m, i) = finite_points(mzs_src, v, &mut total_points, &mut dropped_points);
+                (m, Values::F32(i))
+            }
+        };
+        let scan = (!mz.is_empty()).then(|| CentroidScan {
+            rt,
+            mz,
+            intensity,
+            cumulative: None,
+            skip: None,
+        });
+        (scan, total_points, dropped_points)
+    };
+    let loaded: Vec<_> = if cores > 1 && picked.len() >= PAR_MIN_SCANS {
+        picked
+            .par_iter()
+            .with_cores(cores)
+            .with_min_len(PAR_CHUNK)
+            .map(load)
+            .collect()
+    } else {
+        picked.iter().map(load).collect()
+    };
+
+    let mut scans = Vec::with_capacity(loaded.len());
+    let mut total_points: usize = 0;
+    let mut dropped_points: usize = 0;
+    for (scan, total, dropped) in loaded {
+        total_points += total;
+        dropped_points += dropped;
+        scans.extend(scan);
     }
     if dropped_points > 0 {
         eprintln!(
@@ -194,30 +635,10 @@ pub fn with_eic_apex_intensity(rt: &[f64], y: &[f64], mut p: Peak) -> Peak {
 
 #[inline]
 pub fn lower_bound(a: &[f64], x: f64) -> usize {
-    let mut lo = 0usize;
-    let mut hi = a.len();
-    while lo < hi {
-        let mid = (lo + hi) / 2;
-        if a[mid] < x {
-            lo = mid + 1;
-        } else {
-            hi = mid;
-        }
-    }
-    lo
+    partition(a, |v| v < x)
 }
 
 #[inline]
 pub fn upper_bound(a: &[f64], x: f64) -> usize {
-    let mut lo = 0usize;
-    let mut hi = a.len();
-    while lo < hi {
-        let mid = (lo + hi) / 2;
-        if a[mid] <= x {
-            lo = mid + 1;
-        } else {
-            hi = mid;
-        }
-    }
-    lo
+    partition(a, |v| v <= x)
 }
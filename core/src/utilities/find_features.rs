@@ -1,15 +1,23 @@
 use crate::utilities::calculate_eic::{
-    CentroidScan, EicOptions, collect_ms1_scans, compute_eic_for_mz, lower_bound, upper_bound,
-    with_eic_apex_intensity,
+    CentroidScan, EicOptions, EicSweep, collect_ms1_scans, compute_eics_for_mzs, eic_window,
+    lower_bound, upper_bound, with_eic_apex_intensity,
 };
-use crate::utilities::find_peaks::{FindPeaksOptions, find_peaks};
+use crate::utilities::find_peaks::{FindPeaksOptions, find_peaks_xy};
+use crate::utilities::mass_traces::{MassTraceOptions, build_mass_traces};
 use crate::utilities::parse::parse_mzml::MzML;
-use crate::utilities::structs::{DataXY, FromTo, Peak};
-use rayon::ThreadPoolBuilder;
+use crate::utilities::progress::Progress;
+use crate::utilities::structs::{FromTo, Peak};
+use crate::utilities::threads::{WithCores, in_pool};
+use crate::utilities::tile_index::TileIndex;
 use rayon::prelude::*;
 use std::cmp::Ordering;
+use std::sync::atomic::{AtomicUsize, Ordering as AtomicOrdering};
 use std::time::Instant;
 
+const EIC_BATCH: usize = 64;
+const SWEEP_CHUNK: usize = 1024;
+const TRACE_PAD: usize = 10;
+
 #[derive(Clone, Debug)]
 pub struct Feature {
     pub mz: f64,
@@ -36,17 +44,33 @@ impl Default for MzScanGrid {
     }
 }
 
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub enum FeatureEngine {
+    #[default]
+    Grid,
+    MassTrace,
+}
+
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct SweepStats {
+    pub rows: usize,
+    pub reused: usize,
+}
+
 pub struct FindFeaturesOptions {
+    pub engine: Option<FeatureEngine>,
     pub scan_eic_options: Option<EicOptions>,
     pub eic_options: Option<EicOptions>,
     pub find_peaks: Option<FindPeaksOptions>,
     pub mz_scan_grid: Option<MzScanGrid>,
     pub scan_width_threshold: Option<usize>,
+    pub mass_trace: Option<MassTraceOptions>,
 }
 
 impl Default for FindFeaturesOptions {
     fn default() -> Self {
         Self {
+            engine: Some(FeatureEngine::Grid),
             scan_eic_options: Some(EicOptions {
                 ppm_tolerance: 10.0,
                 mz_tolerance: 0.003,
@@ -58,6 +82,7 @@ impl Default for FindFeaturesOptions {
             find_peaks: Some(FindPeaksOptions::default()),
             mz_scan_grid: Some(MzScanGrid::default()),
             scan_width_threshold: Some(5),
+            mass_trace: Some(MassTraceOptions::default()),
         }
     }
 }
@@ -67,53 +92,44 @@ pub fn find_features(
     time_window: FromTo,
     options: Option<FindFeaturesOptions>,
     cores: usize,
+    progress: &Progress,
 ) -> Vec<Feature> {
+    find_features_with_stats(mzml, time_window, options, cores, progress).0
+}
+
+pub fn find_features_with_stats(
+    mzml: &MzML,
+    time_window: FromTo,
+    options: Option<FindFeaturesOptions>,
+    cores: usize,
+    progress: &Progress,
+) -> (Vec<Feature>, SweepStats) {
     let t0 = Instant::now();
     eprintln!("[find_features] start");
 
     let opts = options.unwrap_or_default();
+    let engine = opts.engine.unwrap_or_default();
     let scan_eic_options = opts.scan_eic_options.unwrap_or_default();
     let eic_options = opts.eic_options.unwrap_or_default();
     let find_peak_options = opts.find_peaks.unwrap_or_default();
     let mz_scan_grid_options = opts.mz_scan_grid.unwrap_or_default();
+    let mass_trace_options = opts.mass_trace.unwrap_or_default();
     let scan_width_threshold = opts.scan_width_threshold.unwrap_or(5);
 
-    if !(mz_scan_grid_options.step_size.is_finite()) || mz_scan_grid_options.step_size <= 0.0 {
-        panic!(
-            "[panic] step_size must be > 0 in Da, got {}",
-            mz_scan_grid_options.step_size
-        );
-    }
-
-    let grid = build_mz_grid(
-        mz_scan_grid_options.mz_min,
-        mz_scan_grid_options.mz_max,
-        mz_scan_grid_options.step_size,
-    );
-    eprintln!("[find_features] grid_len={}", grid.len());
-    let eff_step = if grid.len() > 1 {
-        (grid[grid.len() - 1] - grid[0]) / (grid.len() as f64 - 1.0)
-    } else {
-        f64::NAN
+    let grid = match engine {
+        FeatureEngine::Grid => checked_mz_grid(&mz_scan_grid_options),
+        FeatureEngine::MassTrace => Vec::new(),
     };
-    eprintln!(
-        "[find_features] grid_params start={:.6} end={:.6} step_da_in={:.9} eff_step={:.9}",
-        mz_scan_grid_options.mz_min,
-        mz_scan_grid_options.mz_max,
-        mz_scan_grid_options.step_size,
-        eff_step
-    );
-    if grid.is_empty() {
-        panic!("[panic] empty grid");
-    }
-    if grid.len() > 2_000_000 {
-        panic!("[panic] grid too large: {}", grid.len());
-    }
 
-    let (rts, scans) = collect_ms1_scans(mzml, time_window);
+    let (rts, mut scans) = collect_ms1_scans(mzml, time_window);
     if scans.is_empty() {
         panic!("[panic] no scans in time window");
     }
+    scans.iter_mut().for_each(|s| {
+        s.index_intensities();
+        s.index_search();
+    });
+    let tiles = TileIndex::new(&scans);
     let time = rts.clone();
     eprintln!(
         "[find_features] scans_len={}, rt_range=[{:.6},{:.6}]",
@@ -122,93 +138,52 @@ pub fn find_features(
         time.last().unwrap_or(&0.0)
     );
 
-    let pool = ThreadPoolBuilder::new()
-        .num_threads(cores.max(1))
-        .thread_name(|i| format!("ff-{}", i))
-        .build()
-        .expect("failed to build rayon pool");
-
-    pool.install(|| {
-        let t1 = Instant::now();
-
-        let masses: Vec<f64> = grid
-            .par_iter()
-            .map(|&m| {
-                let y0 = compute_eic_for_mz(&scans, time.len(), &m, scan_eic_options);
-
-                let mut coarse_options = find_peak_options.clone();
-                let mut coarse_filter = coarse_options.filter_peaks_options.unwrap_or_default();
-                coarse_filter.width_threshold = Some(scan_width_threshold);
-                coarse_options.filter_peaks_options = Some(coarse_filter);
-
-                let peaks = find_peaks(
-                    &DataXY {
-                        x: time.clone(),
-                        y: y0,
-                    },
-                    Some(coarse_options),
-                );
-
-                let (rt_from, rt_to) = peaks
-                    .iter()
-                    .max_by(|a, b| {
-                        a.intensity
-                            .partial_cmp(&b.intensity)
-                            .unwrap_or(Ordering::Equal)
-                    })
-                    .map(|p| (p.from, p.to))
-                    .unwrap_or((time_window.from, time_window.to));
-
-                refine_mz_for_peak(&scans, &*time, m, rt_from, rt_to, eic_options)
-            })
-            .collect();
-
-        eprintln!(
-            "[find_features] refined_len={}, refining time={:?}",
-            masses.len(),
-            t1.elapsed()
-        );
-        if masses.is_empty() {
-            panic!("[panic] refine_mz_for_peak returned empty list");
-        }
-
-        let unique_masses: Vec<f64> = dedup_masses_dynamic(masses, eic_options);
-        eprintln!("[find_features] unique_masses={}", unique_masses.len());
-        if unique_masses.is_empty() {
-            eprintln!("[warn] no unique masses after dedup");
-        }
-
+    let mut stats = SweepStats::default();
+    let features = in_pool(cores, || {
         let t2 = Instant::now();
 
-        let mut features_raw: Vec<Feature> = unique_masses
-            .par_iter()
-            .flat_map(|&mz| {
-                let y = compute_eic_for_mz(&scans, time.len(), &mz, eic_options);
-                let data = DataXY { x: time.clone(), y };
-                let peaks = find_peaks(&data, Some(find_peak_options.clone()));
-                if peaks.is_empty() {
-                    return Vec::<Feature>::new();
-                }
-
-                let mut adjusted: Vec<Peak> = peaks
-                    .into_iter()
-                    .map(|p| with_eic_apex_intensity(&*data.x, &data.y, p))
-                    .collect();
-                sort_peaks_desc(&mut adjusted);
-
-                adjusted
-                    .into_iter()
-                    .map(|p| Feature {
-                        mz,
-                        rt: p.rt,
-                        intensity: p.intensity,
-                        from: p.from,
-                        to: p.to,
-                        np: p.np,
-                    })
-                    .collect::<Vec<_>>()
-            })
-            .collect();
+        let mut features_raw = match engine {
+            FeatureEngine::Grid => {
+                let (unique_masses, sweep_stats) = grid_masses(
+                    &scans,
+                    &time,
+                    &tiles,
+                    &grid,
+                    time_window,
+                    scan_eic_options,
+                    eic_options,
+                    &find_peak_options,
+                    scan_width_threshold,
+                    cores,
+                    progress,
+                );
+                stats = sweep_stats;
+                mass_features(
+                    &scans,
+                    &time,
+                    &tiles,
+                    &unique_masses,
+                    eic_options,
+                    &find_peak_options,
+                    cores,
+                    progress,
+                )
+            }
+            FeatureEngine::MassTrace => trace_features(
+                &scans,
+                &time,
+                &tiles,
+                mass_trace_options,
+                eic_options,
+                &find_peak_options,
+                cores,
+                progress,
+            ),
+        };
+        if progress.cancelled() {
+            eprintln!("[find_features] cancelled after {:?}", t0.elapsed());
+            return Vec::new();
+        }
 
         eprintln!(
             "[find_features] raw_features_len={}, dt_eic={:?}",
@@ -249,7 +224,240 @@ pub fn find_features(
                 .then_with(|| a.mz.partial_cmp(&b.mz).unwrap_or(Ordering::Equal))
         });
         features
-    })
+    });
+    (features, stats)
+}
+
+fn checked_mz_grid(options: &MzScanGrid) -> Vec<f64> {
+    if !(options.step_size.is_finite()) || options.step_size <= 0.0 {
+        panic!(
+            "[panic] step_size must be > 0 in Da, got {}",
+            options.step_size
+        );
+    }
+
+    let grid = build_mz_grid(options.mz_min, options.mz_max, options.step_size);
+    eprintln!("[find_features] grid_len={}", grid.len());
+    let eff_step = if grid.len() > 1 {
+        (grid[grid.len() - 1] - grid[0]) / (grid.len() as f64 - 1.0)
+    } else {
+        f64::NAN
+    };
+    eprintln!(
+        "[find_features] grid_params start={:.6} end={:.6} step_da_in={:.9} eff_step={:.9}",
+        options.mz_min, options.mz_max, options.step_size, eff_step
+    );
+    if grid.is_empty() {
+        panic!("[panic] empty grid");
+    }
+    if grid.len() > 2_000_000 {
+        panic!("[panic] grid too large: {}", grid.len());
+    }
+    grid
+}
+
+fn grid_masses(
+    scans: &[CentroidScan],
+    time: &[f64],
+    tiles: &TileIndex,
+    grid: &[f64],
+    time_window: FromTo,
+    scan_eic_options: EicOptions,
+    eic_options: EicOptions,
+    find_peak_options: &FindPeaksOptions,
+    scan_width_threshold: usize,
+    cores: usize,
+    progress: &Progress,
+) -> (Vec<f64>, SweepStats) {
+    let t1 = Instant::now();
+    let stage = progress.stage("grid", grid.len());
+    let mut coarse_options = find_peak_options.clone();
+    let mut coarse_filter = coarse_options.filter_peaks_options.unwrap_or_default();
+    coarse_filter.width_threshold = Some(scan_width_threshold);
+    coarse_options.filter_peaks_options = Some(coarse_filter);
+    let rows = AtomicUsize::new(0);
+    let reused = AtomicUsize::new(0);
+
+    let masses: Vec<f64> = grid
+        .par_chunks(SWEEP_CHUNK)
+        .with_cores(cores)
+        .flat_map_iter(|chunk| {
+            let mut sweep = EicSweep::new(scans);
+            let mut window = None;
+            let (stage, rows, reused, coarse_options) = (&stage, &rows, &reused, &coarse_options);
+            chunk.iter().map(move |&m| {
+                let live =
+                    stage.tick(1) && has_signal(tiles, scans, &m, &[scan_eic_options, eic_options]);
+                if !live {
+                    return (m, None);
+                }
+                let (lo, hi) = eic_window(&m, scan_eic_options);
+                let y0 = sweep.eic(lo, hi);
+                rows.fetch_add(1, AtomicOrdering::Relaxed);
+                if sweep.unchanged() && window.is_some() {
+                    reused.fetch_add(1, AtomicOrdering::Relaxed);
+                } else {
+                    let peaks = find_peaks_xy(time, &y0, Some(coarse_options.clone()));
+                    window = Some(
+                        peaks
+                            .iter()
+                            .max_by(|a, b| {
+                                a.intensity
+                                    .partial_cmp(&b.intensity)
+                                    .unwrap_or(Ordering::Equal)
+                            })
+                            .map(|p| (p.from, p.to))
+                            .unwrap_or((time_window.from, time_window.to)),
+                    );
+                }
+                (m, window)
+            })
+        })
+        .map(|(m, window)| match window {
+            Some((rt_from, rt_to)) => {
+                refine_mz_for_peak(scans, time, m, rt_from, rt_to, eic_options)
+            }
+            None => m,
+        })
+        .collect();
+
+    eprintln!(
+        "[find_features] refined_len={}, refining time={:?}",
+        masses.len(),
+        t1.elapsed()
+    );
+    let stats = SweepStats {
+        rows: rows.into_inner(),
+        reused: reused.into_inner(),
+    };
+    if progress.cancelled() {
+        return (Vec::new(), stats);
+    }
+    if masses.is_empty() {
+        panic!("[panic] refine_mz_for_peak returned empty list");
+    }
+
+    let unique_masses: Vec<f64> = dedup_masses_dynamic(masses, eic_options);
+    eprintln!("[find_features] unique_masses={}", unique_masses.len());
+    if unique_masses.is_empty() {
+        eprintln!("[warn] no unique masses after dedup");
+    }
+    (unique_masses, stats)
+}
+
+fn mass_features(
+    scans: &[CentroidScan],
+    time: &[f64],
+    tiles: &TileIndex,
+    masses: &[f64],
+    eic_options: EicOptions,
+    find_peak_options: &FindPeaksOptions,
+    cores: usize,
+    progress: &Progress,
+) -> Vec<Feature> {
+    let stage = progress.stage("features", masses.len());
+    masses
+        .par_chunks(EIC_BATCH)
+        .with_cores(cores)
+        .flat_map_iter(|chunk| {
+            if !stage.tick(chunk.len()) {
+                return Vec::new();
+            }
+            let live: Vec<f64> = chunk
+                .iter()
+                .copied()
+                .filter(|m| has_signal(tiles, scans, m, &[eic_options]))
+                .collect();
+            let windows: Vec<(f64, f64)> =
+                live.iter().map(|m| eic_window(m, eic_options)).collect();
+            let y = compute_eics_for_mzs(scans, &windows);
+            live.iter()
+                .zip(y.chunks_exact(time.len()))
+                .map(|(&mz, y)| (mz, y.to_vec()))
+                .collect::<Vec<_>>()
+        })
+        .flat_map(|(mz, y)| peak_features(mz, time, &y, find_peak_options))
+        .collect()
+}
+
+fn trace_features(
+    scans: &[CentroidScan],
+    time: &[f64],
+    tiles: &TileIndex,
+    options: MassTraceOptions,
+    eic_options: EicOptions,
+    find_peak_options: &FindPeaksOptions,
+    cores: usize,
+    progress: &Progress,
+) -> Vec<Feature> {
+    let t1 = Instant::now();
+    progress.report(0.0, "traces");
+    let traces = build_mass_traces(scans, options);
+    progress.report(1.0, "traces");
+    eprintln!(
+        "[find_features] mass_traces={}, tracing time={:?}",
+        traces.len(),
+        t1.elapsed()
+    );
+
+    if progress.cancelled() {
+        return Vec::new();
+    }
+    let pad = TRACE_PAD + options.max_gap;
+    let stage = progress.stage("features", traces.len());
+    traces
+        .par_iter()
+        .with_cores(cores)
+        .filter(|_| stage.tick(1))
+        .flat_map_iter(|t| {
+            let span = t.first.saturating_sub(pad)..(t.last + pad + 1).min(scans.len());
+            let (lo, hi) = eic_window(&t.mz, eic_options);
+            let y = tiles.eic(scans, lo, hi, span.clone());
+            peak_features(t.mz, &time[span], &y, find_peak_options)
+        })
+        .collect()
+}
+
+fn peak_features(
+    mz: f64,
+    time: &[f64],
+    y: &[f64],
+    find_peak_options: &FindPeaksOptions,
+) -> Vec<Feature> {
+    let peaks = find_peaks_xy(time, y, Some(find_peak_options.clone()));
+    if peaks.is_empty() {
+        return Vec::new();
+    }
+
+    let mut adjusted: Vec<Peak> = peaks
+        .into_iter()
+        .map(|p| with_eic_apex_intensity(time, y, p))
+        .collect();
+    sort_peaks_desc(&mut adjusted);
+
+    adjusted
+        .into_iter()
+        .map(|p| Feature {
+            mz,
+            rt: p.rt,
+            intensity: p.intensity,
+            from: p.from,
+            to: p.to,
+            np: p.np,
+        })
+        .collect()
+}
+
+fn has_signal(tiles: &TileIndex, scans: &[CentroidScan], m: &f64, opts: &[EicOptions]) -> bool {
+    let (lo, hi) = opts
+        .iter()
+        .map(|&o| eic_window(m, o))
+        .fold((f64::INFINITY, f64::NEG_INFINITY), |(a, b), (lo, hi)| {
+            (a.min(lo), b.max(hi))
+        });
+    tiles
+        .max_intensity(scans, lo, hi, 0..scans.len())
+        .is_some_and(|v| v > 0.0)
 }
 
 fn dedup_masses_dynamic(mut ms: Vec<f64>, opts: EicOptions) -> Vec<f64> {
@@ -329,16 +537,19 @@ fn refine_mz_for_peak(
     let mut bins = vec![0.0f64; n_bins];
 
     for s in i0..i1 {
+        if scans[s].cumulative.is_some() && scans[s].window_sum(lo, hi) <= 0.0 {
+            continue;
+        }
         let mzs = &scans[s].mz;
         let ints = &scans[s].intensity;
-        let mut j = lower_bound(mzs, lo);
+        let mut j = scans[s].mz_lower_bound(lo);
         let mut guard = 0usize;
         while j < mzs.len() {
             let m = mzs[j];
             if m > hi {
                 break;
             }
-            let it = ints[j] as f64;
+            let it = ints.get(j);
             if it.is_finite() && it > 0.0 && m.is_finite() {
                 let idx_f = (m - lo) / bin_da;
                 if idx_f.is_finite() {
@@ -84,20 +84,23 @@ impl Default for FindPeaksOptions {
 }
 
 pub fn find_peaks(data: &DataXY, options: Option<FindPeaksOptions>) -> Vec<Peak> {
+    find_peaks_xy(&data.x, &data.y, options)
+}
+
+pub fn find_peaks_xy(x: &[f64], y: &[f64], options: Option<FindPeaksOptions>) -> Vec<Peak> {
     let o = options.unwrap_or_default();
     let filter_opts = o.filter_peaks_options.unwrap_or_default();
     let base_opts = o.baseline_options.unwrap_or_default();
 
-    let y64: Vec<f64> = data.y.clone();
     let floor = if filter_opts.auto_baseline.unwrap_or(false) {
         let mut b = base_opts.clone();
         b.level = Some(0);
-        calculate_baseline(&y64, b)
+        calculate_baseline(y, b)
     } else {
-        vec![0.0; y64.len()]
+        vec![0.0; y.len()]
     };
 
-    let y_center: Vec<f64> = y64
+    let y_center: Vec<f64> = y
         .iter()
         .zip(&floor)
         .map(|(a, m)| (a - m).max(0.0))
@@ -115,7 +118,7 @@ pub fn find_peaks(data: &DataXY, options: Option<FindPeaksOptions>) -> Vec<Peak>
     };
 
     let normalized_data = DataXY {
-        x: data.x.clone(),
+        x: x.to_vec(),
         y: y_center,
     };
 
@@ -143,7 +146,7 @@ pub fn find_peaks(data: &DataXY, options: Option<FindPeaksOptions>) -> Vec<Peak>
 
         match (b.from.index, b.from.value, b.to.index, b.to.value) {
             (Some(fi), Some(fx), Some(ti), Some(tx)) if fi < ti => {
-                let (integral, intensity) = xy_integration(&data.x[fi..=ti], &data.y[fi..=ti]);
+                let (integral, intensity) = xy_integration(&x[fi..=ti], &y[fi..=ti]);
                 let cand = PeakCandidate {
                     from: fx,
                     to: tx,
@@ -189,7 +192,7 @@ pub fn find_peaks(data: &DataXY, options: Option<FindPeaksOptions>) -> Vec<Peak>
     }
 
     if peaks.len() > 1 {
-        peaks = suppress_contained_peaks(data, peaks);
+        peaks = suppress_contained_peaks(&normalized_data, peaks);
     }
     peaks
 }
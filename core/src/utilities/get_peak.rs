@@ -1,8 +1,17 @@
-use crate::utilities::find_peaks::{FindPeaksOptions, find_peaks};
+use crate::utilities::find_peaks::{FindPeaksOptions, find_peaks_xy};
 use crate::utilities::structs::{DataXY, Peak, Roi};
 
 pub fn get_peak(data: &DataXY, roi: Roi, options: Option<FindPeaksOptions>) -> Option<Peak> {
-    let peaks = find_peaks(data, options);
+    get_peak_xy(&data.x, &data.y, roi, options)
+}
+
+pub fn get_peak_xy(
+    x: &[f64],
+    y: &[f64],
+    roi: Roi,
+    options: Option<FindPeaksOptions>,
+) -> Option<Peak> {
+    let peaks = find_peaks_xy(x, y, options);
 
     if peaks.is_empty() {
         return Some(Peak::default());
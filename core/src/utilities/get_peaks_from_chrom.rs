@@ -1,39 +1,53 @@
-use rayon::{ThreadPoolBuilder, prelude::*};
+use rayon::prelude::*;
+use std::borrow::Cow;
 
 use crate::utilities::{
     find_peaks::FindPeaksOptions,
-    get_peak::get_peak,
-    parse::parse_mzml::MzML,
-    structs::{ChromRoi, DataXY, Roi},
+    get_peak::get_peak_xy,
+    parse::bin1_view::Bin1View,
+    structs::{ChromRoi, Roi},
+    threads::{WithCores, thread_pool},
 };
 
 pub fn get_peaks_from_chrom(
-    mzml: &MzML,
+    view: &Bin1View,
+    items: &[ChromRoi],
+    options: Option<FindPeaksOptions>,
+    cores: usize,
+) -> Option<Vec<(usize, String, f64, f64, f64, f64, f64, f64)>> {
+    let trace = |i: usize| {
+        let (x, y) = match (view.chromatogram_time(i), view.chromatogram_intensity(i)) {
+            (Some(t), Some(ints)) => (t, ints.into_f64()),
+            _ => (Cow::Borrowed(&[][..]), Cow::Borrowed(&[][..])),
+        };
+        (view.chromatogram_index(i), view.chromatogram_id(i), x, y)
+    };
+    get_peaks_from_traces(view.chromatogram_count(), trace, items, options, cores)
+}
+
+pub fn get_peaks_from_traces<'a>(
+    n_traces: usize,
+    trace: impl Fn(usize) -> (usize, &'a str, Cow<'a, [f64]>, Cow<'a, [f64]>) + Sync,
     items: &[ChromRoi],
     options: Option<FindPeaksOptions>,
     cores: usize,
 ) -> Option<Vec<(usize, String, f64, f64, f64, f64, f64, f64)>> {
-    let chroms = &mzml.run.as_ref()?.chromatograms;
     let f = |roi: &ChromRoi| {
         if roi.window <= 0.0 || !roi.rt.is_finite() {
             return (roi.idx, roi.id.clone(), roi.rt, 0.0, 0.0, 0.0, 0.0, 0.0);
         }
         let i = roi.idx;
-        if i >= chroms.len() {
+        if i >= n_traces {
             return (i, roi.id.clone(), roi.rt, 0.0, 0.0, 0.0, 0.0, 0.0);
         }
-        let ch = &chroms[i];
-        let (x, y) = match (&ch.time_array, &ch.intensity_array) {
-            (Some(t), Some(ints)) => (t.iter().copied().collect(), ints.iter().copied().collect()),
-            _ => (Vec::new(), Vec::new()),
-        };
-        compute_one(ch.index, &ch.id, x, y, roi, &options)
+        let (index, id, x, y) = trace(i);
+        compute_one(index, id, &x, &y, roi, &options)
     };
     if cores <= 1 || items.len() < 2 {
         Some(items.iter().map(f).collect())
     } else {
-        let pool = ThreadPoolBuilder::new().num_threads(cores).build().ok()?;
-        Some(pool.install(|| items.par_iter().map(f).collect()))
+        let pool = thread_pool()?;
+        Some(pool.install(|| items.par_iter().with_cores(cores).map(f).collect()))
     }
 }
 
@@ -41,8 +55,8 @@ pub fn get_peaks_from_chrom(
 fn compute_one(
     ch_index: usize,
     ch_id: &str,
-    x: Vec<f64>,
-    y: Vec<f64>,
+    x: &[f64],
+    y: &[f64],
     roi: &ChromRoi,
     options: &Option<FindPeaksOptions>,
 ) -> (usize, String, f64, f64, f64, f64, f64, f64) {
@@ -52,8 +66,9 @@ fn compute_one(
     let mut intensity_val = 0.0_f64;
     let mut integral = 0.0_f64;
     if x.len() >= 3 && x.len() == y.len() {
-        if let Some(p) = get_peak(
-            &DataXY { x, y },
+        if let Some(p) = get_peak_xy(
+            x,
+            y,
             Roi {
                 rt: roi.rt,
                 window: roi.window,
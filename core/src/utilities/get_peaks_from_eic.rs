@@ -1,68 +1,126 @@
-use rayon::{ThreadPoolBuilder, prelude::*};
+use rayon::prelude::*;
 
 use crate::utilities::{
-    EicOptions, calculate_eic_from_mzml,
+    EicOptions,
+    calculate_eic::{
+        CentroidScan, collect_ms1_scans_from_view, compute_eics_for_mzs, eic_window, lower_bound,
+        upper_bound,
+    },
     find_peaks::FindPeaksOptions,
-    get_peak::get_peak,
-    parse::{decode, parse_mzml::MzML},
-    structs::{DataXY, EicRoi, FromTo, Peak, Roi},
+    get_peak::get_peak_xy,
+    parse::bin1_view::Bin1View,
+    progress::Progress,
+    structs::{EicRoi, FromTo, Peak, Roi},
+    threads::{WithCores, thread_pool},
 };
 
+const EIC_BATCH: usize = 128;
+
 pub fn get_peaks_from_eic(
     bytes: &[u8],
     from_to: FromTo,
     rois: &[EicRoi],
     options: Option<FindPeaksOptions>,
     cores: usize,
+    progress: &Progress,
 ) -> Option<Vec<(String, f64, f64, Peak)>> {
-    let mzml = decode(bytes).ok()?;
-    if cores <= 1 || rois.len() < 2 {
-        let mut out: Vec<(String, f64, f64, Peak)> = Vec::with_capacity(rois.len());
-        for roi in rois {
-            out.push(compute_one(&mzml, from_to, roi, &options));
-        }
-        return Some(out);
-    }
-    let pool = ThreadPoolBuilder::new().num_threads(cores).build().ok()?;
-    Some(pool.install(|| {
-        rois.par_iter()
-            .map(|roi| compute_one(&mzml, from_to, roi, &options))
-            .collect()
-    }))
+    let view = Bin1View::new(bytes).ok()?;
+    let (rts, scans) = collect_ms1_scans_from_view(&view, from_to);
+    get_peaks_from_scans(&rts, &scans, from_to, rois, options, cores, progress)
 }
 
-#[inline]
-fn compute_one(
-    mzml: &MzML,
+pub fn get_peaks_from_scans(
+    rts: &[f64],
+    scans: &[CentroidScan],
     from_to: FromTo,
+    rois: &[EicRoi],
+    options: Option<FindPeaksOptions>,
+    cores: usize,
+    progress: &Progress,
+) -> Option<Vec<(String, f64, f64, Peak)>> {
+    let i0 = lower_bound(rts, from_to.from);
+    let i1 = upper_bound(rts, from_to.to).max(i0);
+    let (rts, scans) = (&rts[i0..i1], &scans[i0..i1]);
+    let stage = progress.stage("peaks", rois.len());
+    let batch = |chunk: &[EicRoi]| {
+        if !stage.live() {
+            return Vec::new();
+        }
+        let out = compute_batch(rts, scans, chunk, &options);
+        stage.tick(chunk.len());
+        out
+    };
+    let peaks: Vec<_> = if cores <= 1 || rois.len() < 2 {
+        rois.chunks(EIC_BATCH).flat_map(batch).collect()
+    } else {
+        let size = rois.len().div_ceil(cores * 4).clamp(1, EIC_BATCH);
+        let pool = thread_pool()?;
+        pool.install(|| {
+            rois.par_chunks(size)
+                .with_cores(cores)
+                .flat_map_iter(batch)
+                .collect()
+        })
+    };
+    (!progress.cancelled()).then_some(peaks)
+}
+
+fn compute_batch(
+    rts: &[f64],
+    scans: &[CentroidScan],
+    rois: &[EicRoi],
+    options: &Option<FindPeaksOptions>,
+) -> Vec<(String, f64, f64, Peak)> {
+    let n = rts.len();
+    let opts = EicOptions {
+        ppm_tolerance: 20.0,
+        mz_tolerance: 0.005,
+    };
+    let windows: Vec<(f64, f64)> = rois
+        .iter()
+        .filter(|r| r.from_to.is_none())
+        .map(|r| eic_window(&r.mz, opts))
+        .collect();
+    let y = if n < 3 {
+        Vec::new()
+    } else {
+        compute_eics_for_mzs(scans, &windows)
+    };
+    let mut rows = y.chunks_exact(n.max(1));
+    rois.iter()
+        .map(|roi| match roi.from_to {
+            None => peak_for(roi, rts, rows.next(), options),
+            Some(ft) => {
+                let i0 = lower_bound(rts, ft.from);
+                let i1 = upper_bound(rts, ft.to).max(i0);
+                if i1 - i0 < 3 {
+                    return peak_for(roi, &rts[i0..i1], None, options);
+                }
+                let y = compute_eics_for_mzs(&scans[i0..i1], &[eic_window(&roi.mz, opts)]);
+                peak_for(roi, &rts[i0..i1], Some(&y), options)
+            }
+        })
+        .collect()
+}
+
+fn peak_for(
     roi: &EicRoi,
+    rts: &[f64],
+    y: Option<&[f64]>,
     options: &Option<FindPeaksOptions>,
 ) -> (String, f64, f64, Peak) {
-    let eic = match calculate_eic_from_mzml(
-        mzml,
-        &roi.mz,
-        from_to,
-        EicOptions {
-            ppm_tolerance: 20.0,
-            mz_tolerance: 0.005,
-        },
-    ) {
-        Ok(v) => v,
-        Err(_) => return (roi.id.clone(), roi.rt, roi.mz, Peak::default()),
-    };
-    if eic.x.len() < 3 || eic.x.len() != eic.y.len() {
-        return (roi.id.clone(), roi.rt, roi.mz, Peak::default());
-    }
-    let pk = match get_peak(
-        &DataXY { x: eic.x, y: eic.y },
-        Roi {
-            rt: roi.rt,
-            window: roi.window,
-        },
-        options.clone(),
-    ) {
-        Some(p) => p,
-        None => Peak::default(),
+    let pk = match y {
+        Some(y) if rts.len() >= 3 => get_peak_xy(
+            rts,
+            y,
+            Roi {
+                rt: roi.rt,
+                window: roi.window,
+            },
+            options.clone(),
+        )
+        .unwrap_or_default(),
+        _ => Peak::default(),
     };
     (roi.id.clone(), roi.rt, roi.mz, pk)
 }
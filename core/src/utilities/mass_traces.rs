@@ -0,0 +1,143 @@
+use std::cmp::Ordering;
+
+use crate::utilities::calculate_eic::{CentroidScan, EicOptions, eic_window};
+
+#[derive(Clone, Copy, Debug)]
+pub struct MassTraceOptions {
+    pub ppm_tolerance: f64,
+    pub mz_tolerance: f64,
+    pub min_length: usize,
+    pub max_gap: usize,
+    pub min_intensity: f64,
+}
+
+impl Default for MassTraceOptions {
+    fn default() -> Self {
+        Self {
+            ppm_tolerance: 10.0,
+            mz_tolerance: 0.003,
+            min_length: 5,
+            max_gap: 1,
+            min_intensity: 0.0,
+        }
+    }
+}
+
+#[derive(Clone, Debug)]
+pub struct MassTrace {
+    pub mz: f64,
+    pub first: usize,
+    pub last: usize,
+    pub points: usize,
+    pub max_intensity: f64,
+}
+
+struct OpenTrace {
+    weighted: f64,
+    total: f64,
+    first: usize,
+    last: usize,
+    points: usize,
+    max_intensity: f64,
+}
+
+impl OpenTrace {
+    fn new(scan: usize, mz: f64, intensity: f64) -> Self {
+        Self {
+            weighted: mz * intensity,
+            total: intensity,
+            first: scan,
+            last: scan,
+            points: 1,
+            max_intensity: intensity,
+        }
+    }
+
+    #[inline]
+    fn mz(&self) -> f64 {
+        self.weighted / self.total
+    }
+
+    fn push(&mut self, scan: usize, mz: f64, intensity: f64) {
+        self.weighted += mz * intensity;
+        self.total += intensity;
+        if self.last != scan {
+            self.points += 1;
+            self.last = scan;
+        }
+        self.max_intensity = self.max_intensity.max(intensity);
+    }
+
+    fn close(self) -> MassTrace {
+        MassTrace {
+            mz: self.mz(),
+            first: self.first,
+            last: self.last,
+            points: self.points,
+            max_intensity: self.max_intensity,
+        }
+    }
+}
+
+pub fn build_mass_traces(scans: &[CentroidScan], options: MassTraceOptions) -> Vec<MassTrace> {
+    let tolerance = EicOptions {
+        ppm_tolerance: options.ppm_tolerance,
+        mz_tolerance: options.mz_tolerance,
+    };
+    let min_length = options.min_length.max(1);
+    let mut open: Vec<OpenTrace> = Vec::new();
+    let mut fresh: Vec<OpenTrace> = Vec::new();
+    let mut out: Vec<MassTrace> = Vec::new();
+
+    for (i, s) in scans.iter().enumerate() {
+        for (j, &m) in s.mz.iter().enumerate() {
+            let it = s.intensity.get(j);
+            if !m.is_finite() || !it.is_finite() || it <= 0.0 || it < options.min_intensity {
+                continue;
+            }
+            let (lo, hi) = eic_window(&m, tolerance);
+            let k = open.partition_point(|t| t.mz() < m);
+            let near = [k.checked_sub(1), Some(k)]
+                .into_iter()
+                .flatten()
+                .filter(|&c| c < open.len())
+                .filter(|&c| (lo..=hi).contains(&open[c].mz()))
+                .min_by(|&a, &b| {
+                    (open[a].mz() - m)
+                        .abs()
+                        .partial_cmp(&(open[b].mz() - m).abs())
+                        .unwrap_or(Ordering::Equal)
+                });
+            match near {
+                Some(c) => open[c].push(i, m, it),
+                None => fresh.push(OpenTrace::new(i, m, it)),
+            }
+        }
+
+        let mut k = 0;
+        while k < open.len() {
+            if i - open[k].last > options.max_gap {
+                let t = open.swap_remove(k);
+                if t.points >= min_length {
+                    out.push(t.close());
+                }
+            } else {
+                k += 1;
+            }
+        }
+        open.append(&mut fresh);
+        open.sort_by(|a, b| a.mz().partial_cmp(&b.mz()).unwrap_or(Ordering::Equal));
+    }
+    out.extend(
+        open.into_iter()
+            .filter(|t| t.points >= min_length)
+            .map(OpenTrace::close),
+    );
+
+    out.sort_by(|a, b| {
+        a.mz.partial_cmp(&b.mz)
+            .unwrap_or(Ordering::Equal)
+            .then_with(|| a.first.cmp(&b.first))
+    });
+    out
+}
@@ -2,7 +2,10 @@ pub mod air_pls;
 pub use air_pls::air_pls;
 
 pub mod calculate_eic;
-pub use calculate_eic::{Eic, EicOptions, calculate_eic_from_bin1, calculate_eic_from_mzml};
+pub use calculate_eic::{
+    Eic, EicOptions, calculate_eic_from_bin1, calculate_eic_from_mzml, calculate_eic_from_view,
+    calculate_eics_from_bin1,
+};
 
 pub mod find_features;
 pub use find_features::find_features;
@@ -31,17 +34,29 @@ pub use kmeans::{Point, kmeans};
 pub mod lm;
 pub use lm::lm;
 
+pub mod mass_traces;
+
 pub mod noise_san_plot;
 pub use noise_san_plot::noise_san_plot;
 
 pub mod parse;
 
+pub mod progress;
+
 pub mod scan_for_peaks;
 
+pub mod search;
+
+pub mod session;
+
 pub mod sgg;
 
 pub mod structs;
 
+pub mod threads;
+
+pub mod tile_index;
+
 pub mod utilities;
 pub use utilities::{
     closest_index, mean_step, min_positive_step, min_sep, odd_in_range, quad_peak,
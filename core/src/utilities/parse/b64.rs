@@ -0,0 +1,208 @@
+const INVALID: u8 = 0xFF;
+const WS: u8 = 0xFE;
+const PAD: u8 = 0xFD;
+
+const DECODE: [u8; 256] = {
+    let mut t = [INVALID; 256];
+    let mut i = 0;
+    while i < 26 {
+        t[b'A' as usize + i] = i as u8;
+        t[b'a' as usize + i] = 26 + i as u8;
+        i += 1;
+    }
+    let mut d = 0;
+    while d < 10 {
+        t[b'0' as usize + d] = 52 + d as u8;
+        d += 1;
+    }
+    t[b'+' as usize] = 62;
+    t[b'/' as usize] = 63;
+    t[b' ' as usize] = WS;
+    t[b'\n' as usize] = WS;
+    t[b'\r' as usize] = WS;
+    t[b'\t' as usize] = WS;
+    t[b'=' as usize] = PAD;
+    t
+};
+
+pub fn decode_into(src: &[u8], dst: &mut Vec<u8>) -> Result<usize, ()> {
+    dst.clear();
+    dst.resize(src.len() / 4 * 3 + 32, 0);
+    let n = decode_slice(src, dst)?;
+    dst.truncate(n);
+    Ok(n)
+}
+
+fn decode_slice(src: &[u8], dst: &mut [u8]) -> Result<usize, ()> {
+    let mut i = 0usize;
+    let mut o = 0usize;
+    let mut acc = 0u32;
+    let mut k = 0usize;
+
+    loop {
+        if k == 0 {
+            let (di, do_) = decode_simd(&src[i..], &mut dst[o..]);
+            i += di;
+            o += do_;
+        }
+        let stop = (i + 32).min(src.len());
+        while i < stop || (k != 0 && i < src.len()) {
+            let v = DECODE[src[i] as usize];
+            i += 1;
+            if v < 64 {
+                acc = (acc << 6) | v as u32;
+                k += 1;
+                if k == 4 {
+                    dst[o] = (acc >> 16) as u8;
+                    dst[o + 1] = (acc >> 8) as u8;
+                    dst[o + 2] = acc as u8;
+                    o += 3;
+                    acc = 0;
+                    k = 0;
+                }
+            } else if v == WS {
+                continue;
+            } else if v == PAD {
+                return finish(&src[i..], dst, o, acc, k);
+            } else {
+                return Err(());
+            }
+        }
+        if i >= src.len() {
+            return finish(&[], dst, o, acc, k);
+        }
+    }
+}
+
+fn finish(rest: &[u8], dst: &mut [u8], mut o: usize, acc: u32, k: usize) -> Result<usize, ()> {
+    if rest
+        .iter()
+        .any(|&b| !matches!(DECODE[b as usize], WS | PAD))
+    {
+        return Err(());
+    }
+    match k {
+        0 => {}
+        2 => {
+            dst[o] = (acc >> 4) as u8;
+            o += 1;
+        }
+        3 => {
+            dst[o] = (acc >> 10) as u8;
+            dst[o + 1] = (acc >> 2) as u8;
+            o += 2;
+        }
+        _ => return Err(()),
+    }
+    Ok(o)
+}
+
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+fn decode_simd(src: &[u8], dst: &mut [u8]) -> (usize, usize) {
+    if is_x86_feature_detected!("avx2") {
+        unsafe { x86::decode_avx2(src, dst) }
+    } else if is_x86_feature_detected!("sse4.1") {
+        unsafe { x86::decode_sse41(src, dst) }
+    } else {
+        (0, 0)
+    }
+}
+
+#[cfg(not(any(target_arch = "x86", target_arch = "x86_64")))]
+fn decode_simd(_src: &[u8], _dst: &mut [u8]) -> (usize, usize) {
+    (0, 0)
+}
+
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+mod x86 {
+    #[cfg(target_arch = "x86")]
+    use std::arch::x86::*;
+    #[cfg(target_arch = "x86_64")]
+    use std::arch::x86_64::*;
+
+    const LUT_LO: [i8; 16] = [
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B,
+        0x1A,
+    ];
+    const LUT_HI: [i8; 16] = [
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10,
+    ];
+    const LUT_ROLL: [i8; 16] = [0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0];
+    const PACK: [i8; 16] = [2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1];
+
+    #[target_feature(enable = "sse4.1")]
+    pub unsafe fn decode_sse41(src: &[u8], dst: &mut [u8]) -> (usize, usize) {
+        let lut_lo = unsafe { _mm_loadu_si128(LUT_LO.as_ptr() as *const __m128i) };
+        let lut_hi = unsafe { _mm_loadu_si128(LUT_HI.as_ptr() as *const __m128i) };
+        let lut_roll = unsafe { _mm_loadu_si128(LUT_ROLL.as_ptr() as *const __m128i) };
+        let pack = unsafe { _mm_loadu_si128(PACK.as_ptr() as *const __m128i) };
+        let mask_2f = _mm_set1_epi8(0x2F);
+        let nib = _mm_set1_epi8(0x0F);
+        let mut i = 0usize;
+        let mut o = 0usize;
+        while i + 16 <= src.len() && o + 16 <= dst.len() {
+            let input = unsafe { _mm_loadu_si128(src.as_ptr().add(i) as *const __m128i) };
+            let hi_nib = _mm_and_si128(_mm_srli_epi32(input, 4), nib);
+            let lo_nib = _mm_and_si128(input, nib);
+            let lo = _mm_shuffle_epi8(lut_lo, lo_nib);
+            let hi = _mm_shuffle_epi8(lut_hi, hi_nib);
+            if _mm_testz_si128(lo, hi) == 0 {
+                break;
+            }
+            let eq_2f = _mm_cmpeq_epi8(input, mask_2f);
+            let roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nib));
+            let values = _mm_add_epi8(input, roll);
+            let ab_bc = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+            let out = _mm_madd_epi16(ab_bc, _mm_set1_epi32(0x00011000));
+            let out = _mm_shuffle_epi8(out, pack);
+            unsafe { _mm_storeu_si128(dst.as_mut_ptr().add(o) as *mut __m128i, out) };
+            i += 16;
+            o += 12;
+        }
+        (i, o)
+    }
+
+    #[target_feature(enable = "avx2")]
+    pub unsafe fn decode_avx2(src: &[u8], dst: &mut [u8]) -> (usize, usize) {
+        let lut_lo = unsafe {
+            _mm256_broadcastsi128_si256(_mm_loadu_si128(LUT_LO.as_ptr() as *const __m128i))
+        };
+        let lut_hi = unsafe {
+            _mm256_broadcastsi128_si256(_mm_loadu_si128(LUT_HI.as_ptr() as *const __m128i))
+        };
+        let lut_roll = unsafe {
+            _mm256_broadcastsi128_si256(_mm_loadu_si128(LUT_ROLL.as_ptr() as *const __m128i))
+        };
+        let pack = unsafe {
+            _mm256_broadcastsi128_si256(_mm_loadu_si128(PACK.as_ptr() as *const __m128i))
+        };
+        let lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+        let mask_2f = _mm256_set1_epi8(0x2F);
+        let nib = _mm256_set1_epi8(0x0F);
+        let mut i = 0usize;
+        let mut o = 0usize;
+        while i + 32 <= src.len() && o + 32 <= dst.len() {
+            let input = unsafe { _mm256_loadu_si256(src.as_ptr().add(i) as *const __m256i) };
+            let hi_nib = _mm256_and_si256(_mm256_srli_epi32(input, 4), nib);
+            let lo_nib = _mm256_and_si256(input, nib);
+            let lo = _mm256_shuffle_epi8(lut_lo, lo_nib);
+            let hi = _mm256_shuffle_epi8(lut_hi, hi_nib);
+            if _mm256_testz_si256(lo, hi) == 0 {
+                break;
+            }
+            let eq_2f = _mm256_cmpeq_epi8(input, mask_2f);
+            let roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nib));
+            let values = _mm256_add_epi8(input, roll);
+            let ab_bc = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+            let out = _mm256_madd_epi16(ab_bc, _mm256_set1_epi32(0x00011000));
+            let out = _mm256_shuffle_epi8(out, pack);
+            let out = _mm256_permutevar8x32_epi32(out, lanes);
+            unsafe { _mm256_storeu_si256(dst.as_mut_ptr().add(o) as *mut __m256i, out) };
+            i += 32;
+            o += 24;
+        }
+        let (si, so) = unsafe { decode_sse41(&src[i..], &mut dst[o..]) };
+        (i + si, o + so)
+    }
+}
@@ -0,0 +1,257 @@
+use std::borrow::Cow;
+
+use crate::utilities::parse::{
+    encode::{BIN1_CHROM_META, BIN1_HEADER, BIN1_INDEX, BIN1_SPEC_META, FMT_F32, FMT_F64},
+    helper::{rd_u32, rd_u64},
+};
+
+#[derive(Debug, Clone)]
+pub enum Values<'a> {
+    F64(Cow<'a, [f64]>),
+    F32(Cow<'a, [f32]>),
+}
+
+impl<'a> Values<'a> {
+    #[inline]
+    pub fn len(&self) -> usize {
+        match self {
+            Values::F64(v) => v.len(),
+            Values::F32(v) => v.len(),
+        }
+    }
+
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    #[inline]
+    pub fn get(&self, i: usize) -> f64 {
+        match self {
+            Values::F64(v) => v[i],
+            Values::F32(v) => v[i] as f64,
+        }
+    }
+
+    pub fn into_owned(self) -> Values<'static> {
+        match self {
+            Values::F64(v) => Values::F64(Cow::Owned(v.into_owned())),
+            Values::F32(v) => Values::F32(Cow::Owned(v.into_owned())),
+        }
+    }
+
+    pub fn into_f64(self) -> Cow<'a, [f64]> {
+        match self {
+            Values::F64(v) => v,
+            Values::F32(v) => Cow::Owned(v.iter().map(|&x| x as f64).collect()),
+        }
+    }
+}
+
+trait LeFloat: Copy {
+    const SIZE: usize;
+    fn from_le(b: &[u8]) -> Self;
+}
+
+impl LeFloat for f64 {
+    const SIZE: usize = 8;
+    #[inline]
+    fn from_le(b: &[u8]) -> Self {
+        f64::from_le_bytes([b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7]])
+    }
+}
+
+impl LeFloat for f32 {
+    const SIZE: usize = 4;
+    #[inline]
+    fn from_le(b: &[u8]) -> Self {
+        f32::from_le_bytes([b[0], b[1], b[2], b[3]])
+    }
+}
+
+#[derive(Clone, Copy)]
+pub struct Bin1View<'a> {
+    bin: &'a [u8],
+    n_spec: usize,
+    n_ch: usize,
+    chrom_x: u8,
+    chrom_y: u8,
+    spec_x: u8,
+    spec_y: u8,
+    spec_index: usize,
+    chrom_index: usize,
+    spec_meta: usize,
+    chrom_meta: usize,
+}
+
+impl<'a> Bin1View<'a> {
+    pub fn new(bin: &'a [u8]) -> Result<Self, String> {
+        if bin.len() < BIN1_HEADER {
+            return Err("short header".into());
+        }
+        if &bin[0..4] != b"BIN1" {
+            return Err("bad magic".into());
+        }
+        let view = Self {
+            bin,
+            n_spec: rd_u32(bin, 4)? as usize,
+            n_ch: rd_u32(bin, 8)? as usize,
+            chrom_x: bin[12],
+            chrom_y: bin[13],
+            spec_x: bin[14],
+            spec_y: bin[15],
+            spec_index: rd_u64(bin, 16)? as usize,
+            chrom_index: rd_u64(bin, 24)? as usize,
+            spec_meta: rd_u64(bin, 32)? as usize,
+            chrom_meta: rd_u64(bin, 40)? as usize,
+        };
+        view.check_table(view.spec_index, view.n_spec, BIN1_INDEX, "spec index")?;
+        view.check_table(view.chrom_index, view.n_ch, BIN1_INDEX, "chrom index")?;
+        view.check_table(view.spec_meta, view.n_spec, BIN1_SPEC_META, "spec meta")?;
+        view.check_table(view.chrom_meta, view.n_ch, BIN1_CHROM_META, "chrom meta")?;
+        for i in 0..view.n_spec {
+            let (x, y) = view.entry(view.spec_index, i);
+            view.check_array(x, view.spec_x)?;
+            view.check_array(y, view.spec_y)?;
+        }
+        for i in 0..view.n_ch {
+            let (x, y) = view.entry(view.chrom_index, i);
+            view.check_array(x, view.chrom_x)?;
+            view.check_array(y, view.chrom_y)?;
+            let b = view.chrom_meta + i * BIN1_CHROM_META;
+            let (off, len) = (view.u64_at(b + 8), view.u32_at(b + 16) as usize);
+            if off != 0 && len != 0 && (off as usize).saturating_add(len) > bin.len() {
+                return Err("chrom id OOB".into());
+            }
+        }
+        Ok(view)
+    }
+
+    fn check_table(&self, off: usize, n: usize, width: usize, what: &str) -> Result<(), String> {
+        let len = n.checked_mul(width).ok_or_else(|| format!("{what} ovf"))?;
+        if n > 0 && off.saturating_add(len) > self.bin.len() {
+            return Err(format!("{what} OOB"));
+        }
+        Ok(())
+    }
+
+    fn check_array(&self, (off, len): (u64, u32), fmt: u8) -> Result<(), String> {
+        if off == 0 || len == 0 {
+            return Ok(());
+        }
+        let width = match fmt {
+            FMT_F64 => 8,
+            FMT_F32 => 4,
+            _ => return Err("unknown fmt".into()),
+        };
+        let need = (len as usize).checked_mul(width).ok_or("len overflow")?;
+        if (off as usize).saturating_add(need) > self.bin.len() {
+            return Err("array OOB".into());
+        }
+        Ok(())
+    }
+
+    #[inline]
+    fn u32_at(&self, p: usize) -> u32 {
+        u32::from_le_bytes(self.bin[p..p + 4].try_into().unwrap())
+    }
+
+    #[inline]
+    fn u64_at(&self, p: usize) -> u64 {
+        u64::from_le_bytes(self.bin[p..p + 8].try_into().unwrap())
+    }
+
+    #[inline]
+    fn entry(&self, table: usize, i: usize) -> ((u64, u32), (u64, u32)) {
+        let b = table + i * BIN1_INDEX;
+        (
+            (self.u64_at(b), self.u32_at(b + 8)),
+            (self.u64_at(b + 12), self.u32_at(b + 20)),
+        )
+    }
+
+    fn floats<T: LeFloat>(&self, off: usize, n: usize) -> Cow<'a, [T]> {
+        let bytes = &self.bin[off..off + n * T::SIZE];
+        #[cfg(target_endian = "little")]
+        if bytes.as_ptr().align_offset(std::mem::align_of::<T>()) == 0 {
+            return Cow::Borrowed(unsafe {
+                std::slice::from_raw_parts(bytes.as_ptr() as *const T, n)
+            });
+        }
+        Cow::Owned(bytes.chunks_exact(T::SIZE).map(T::from_le).collect())
+    }
+
+    fn values(&self, (off, len): (u64, u32), fmt: u8) -> Option<Values<'a>> {
+        if off == 0 || len == 0 {
+            return None;
+        }
+        let (off, n) = (off as usize, len as usize);
+        Some(match fmt {
+            FMT_F32 => Values::F32(self.floats(off, n)),
+            _ => Values::F64(self.floats(off, n)),
+        })
+    }
+
+    pub fn bytes(&self) -> &'a [u8] {
+        self.bin
+    }
+
+    pub fn spectrum_count(&self) -> usize {
+        self.n_spec
+    }
+
+    pub fn chromatogram_count(&self) -> usize {
+        self.n_ch
+    }
+
+    #[inline]
+    pub fn ms_level(&self, i: usize) -> Option<u8> {
+        let v = self.bin[self.spec_meta + i * BIN1_SPEC_META + 8];
+        if v == 255 { None } else { Some(v) }
+    }
+
+    #[inline]
+    pub fn polarity(&self, i: usize) -> Option<u8> {
+        let v = self.bin[self.spec_meta + i * BIN1_SPEC_META + 9];
+        if v == 255 { None } else { Some(v) }
+    }
+
+    #[inline]
+    pub fn retention_time(&self, i: usize) -> Option<f64> {
+        let v = f64::from_bits(self.u64_at(self.spec_meta + i * BIN1_SPEC_META + 12));
+        if v < 0.0 { None } else { Some(v) }
+    }
+
+    pub fn spectrum_mz(&self, i: usize) -> Option<Cow<'a, [f64]>> {
+        let (x, _) = self.entry(self.spec_index, i);
+        self.values(x, self.spec_x).map(Values::into_f64)
+    }
+
+    pub fn spectrum_intensity(&self, i: usize) -> Option<Values<'a>> {
+        let (_, y) = self.entry(self.spec_index, i);
+        self.values(y, self.spec_y)
+    }
+
+    pub fn chromatogram_index(&self, i: usize) -> usize {
+        self.u32_at(self.chrom_meta + i * BIN1_CHROM_META) as usize
+    }
+
+    pub fn chromatogram_id(&self, i: usize) -> &'a str {
+        let b = self.chrom_meta + i * BIN1_CHROM_META;
+        let (off, len) = (self.u64_at(b + 8) as usize, self.u32_at(b + 16) as usize);
+        if off == 0 || len == 0 {
+            return "";
+        }
+        std::str::from_utf8(&self.bin[off..off + len]).unwrap_or_default()
+    }
+
+    pub fn chromatogram_time(&self, i: usize) -> Option<Cow<'a, [f64]>> {
+        let (x, _) = self.entry(self.chrom_index, i);
+        self.values(x, self.chrom_x).map(Values::into_f64)
+    }
+
+    pub fn chromatogram_intensity(&self, i: usize) -> Option<Values<'a>> {
+        let (_, y) = self.entry(self.chrom_index, i);
+        self.values(y, self.chrom_y)
+    }
+}
@@ -1,11 +1,37 @@
 use serde_json;
 
 use crate::utilities::parse::{
-    helper::{rd_f64, rd_u32, rd_u64, read_array_as_f64},
-    parse_mzml::{ChromatogramSummary, MzML, Precursor, Run, SpectrumSummary},
+    helper::{rd_f64, rd_u32, rd_u64, read_array_as_f32, read_array_as_f64},
+    parse_mzml::{ChromatogramSummary, MzML, ParseFilter, Precursor, Run, SpectrumSummary},
 };
 
 pub fn decode(bin: &[u8]) -> Result<MzML, String> {
+    decode_with(bin, false, &ParseFilter::ALL)
+}
+
+pub fn decode_native(bin: &[u8]) -> Result<MzML, String> {
+    decode_with(bin, true, &ParseFilter::ALL)
+}
+
+pub fn decode_native_filtered(bin: &[u8], filter: &ParseFilter) -> Result<MzML, String> {
+    decode_with(bin, true, filter)
+}
+
+fn read_intensities(
+    bin: &[u8],
+    off: u64,
+    len: u32,
+    fmt: u8,
+    keep_f32: bool,
+) -> Result<(Option<Vec<f64>>, Option<Vec<f32>>), String> {
+    if keep_f32 && fmt == 1 {
+        Ok((None, read_array_as_f32(bin, off, len, fmt)?))
+    } else {
+        Ok((read_array_as_f64(bin, off, len, fmt)?, None))
+    }
+}
+
+fn decode_with(bin: &[u8], keep_f32: bool, filter: &ParseFilter) -> Result<MzML, String> {
     if bin.len() < 64 {
         return Err("short header".into());
     }
@@ -140,7 +166,9 @@ pub fn decode(bin: &[u8]) -> Result<MzML, String> {
                 base_peak_mz: bpm,
                 mz_array: None,
                 intensity_array: None,
+                intensity_array_f32: None,
                 precursor: prec,
+                array_spans: None,
             });
         }
 
@@ -161,21 +189,33 @@ pub fn decode(bin: &[u8]) -> Result<MzML, String> {
                 array_length,
                 time_array: None,
                 intensity_array: None,
+                intensity_array_f32: None,
                 id: String::new(),
             });
         }
 
-        for (i, (x_off, x_len, _, _)) in sidx.iter().enumerate() {
-            spectra[i].mz_array = read_array_as_f64(bin, *x_off, *x_len, sx)?;
-        }
-        for (i, (_, _, y_off, y_len)) in sidx.iter().enumerate() {
-            spectra[i].intensity_array = read_array_as_f64(bin, *y_off, *y_len, sy)?;
-        }
-        for (i, (x_off, x_len, _, _)) in cidx.iter().enumerate() {
-            chroms[i].time_array = read_array_as_f64(bin, *x_off, *x_len, cx)?;
+        let keep: Vec<bool> = spectra
+            .iter()
+            .map(|s| filter.accepts(s.ms_level, s.retention_time, s.polarity))
+            .collect();
+        for (i, (x_off, x_len, y_off, y_len)) in sidx.iter().enumerate() {
+            if !keep[i] {
+                continue;
+            }
+            if filter.mz_array {
+                spectra[i].mz_array = read_array_as_f64(bin, *x_off, *x_len, sx)?;
+            }
+            if filter.intensity_array {
+                (spectra[i].intensity_array, spectra[i].intensity_array_f32) =
+                    read_intensities(bin, *y_off, *y_len, sy, keep_f32)?;
+            }
         }
-        for (i, (_, _, y_off, y_len)) in cidx.iter().enumerate() {
-            chroms[i].intensity_array = read_array_as_f64(bin, *y_off, *y_len, cy)?;
+        if filter.chromatograms {
+            for (i, (x_off, x_len, y_off, y_len)) in cidx.iter().enumerate() {
+                chroms[i].time_array = read_array_as_f64(bin, *x_off, *x_len, cx)?;
+                (chroms[i].intensity_array, chroms[i].intensity_array_f32) =
+                    read_intensities(bin, *y_off, *y_len, cy, keep_f32)?;
+            }
         }
 
         for (i, (off, len)) in ids.into_iter().enumerate() {
@@ -191,6 +231,11 @@ pub fn decode(bin: &[u8]) -> Result<MzML, String> {
                 chroms[i].id = s.to_owned();
             }
         }
+        let mut kept = keep.into_iter();
+        spectra.retain(|_| kept.next().unwrap_or(false));
+        if !filter.chromatograms {
+            chroms.clear();
+        }
     } else if magic == b"BINS" {
         for i in 0..n_spec {
             spectra.push(SpectrumSummary {
@@ -207,7 +252,9 @@ pub fn decode(bin: &[u8]) -> Result<MzML, String> {
                 base_peak_mz: None,
                 mz_array: None,
                 intensity_array: None,
+                intensity_array_f32: None,
                 precursor: None,
+                array_spans: None,
             });
         }
         for i in 0..n_ch {
@@ -216,6 +263,7 @@ pub fn decode(bin: &[u8]) -> Result<MzML, String> {
                 array_length: 0,
                 time_array: None,
                 intensity_array: None,
+                intensity_array_f32: None,
                 id: String::new(),
             });
         }
@@ -226,9 +274,11 @@ pub fn decode(bin: &[u8]) -> Result<MzML, String> {
             spectra[i].array_length = n.max(spectra[i].array_length);
         }
         for (i, (_, _, y_off, y_len)) in sidx.iter().enumerate() {
-            let a = read_array_as_f64(bin, *y_off, *y_len, sy)?;
+            let (a, b) = read_intensities(bin, *y_off, *y_len, sy, keep_f32)?;
             let n = a.as_ref().map(|v| v.len()).unwrap_or(0);
+            let n = b.as_ref().map(|v| v.len()).unwrap_or(n);
             spectra[i].intensity_array = a;
+            spectra[i].intensity_array_f32 = b;
             spectra[i].array_length = n.max(spectra[i].array_length);
         }
         for (i, (x_off, x_len, _, _)) in cidx.iter().enumerate() {
@@ -238,9 +288,11 @@ pub fn decode(bin: &[u8]) -> Result<MzML, String> {
             chroms[i].array_length = n.max(chroms[i].array_length);
         }
         for (i, (_, _, y_off, y_len)) in cidx.iter().enumerate() {
-            let a = read_array_as_f64(bin, *y_off, *y_len, cy)?;
+            let (a, b) = read_intensities(bin, *y_off, *y_len, cy, keep_f32)?;
             let n = a.as_ref().map(|v| v.len()).unwrap_or(0);
+            let n = b.as_ref().map(|v| v.len()).unwrap_or(n);
             chroms[i].intensity_array = a;
+            chroms[i].intensity_array_f32 = b;
             chroms[i].array_length = n.max(chroms[i].array_length);
         }
     } else {
@@ -295,7 +347,9 @@ pub fn metadata_to_json(src: &MzML) -> Result<Vec<u8>, serde_json::Error> {
                 base_peak_mz: s.base_peak_mz,
                 mz_array: None,
                 intensity_array: None,
+                intensity_array_f32: None,
                 precursor: s.precursor.clone(),
+                array_spans: s.array_spans,
             })
             .collect(),
         chromatograms: r
@@ -306,6 +360,7 @@ pub fn metadata_to_json(src: &MzML) -> Result<Vec<u8>, serde_json::Error> {
                 array_length: c.array_length,
                 time_array: None,
                 intensity_array: None,
+                intensity_array_f32: None,
                 id: c.id.clone(),
             })
             .collect(),
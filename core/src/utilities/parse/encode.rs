@@ -1,219 +1,317 @@
 use crate::utilities::parse::{
-    helper::{ensure_cap, set_f64_at, set_u32_at, set_u64_at, write_f64_at, write_f64_le},
-    parse_mzml::MzML,
+    helper::{
+        ensure_cap, set_f64_at, set_u32_at, set_u64_at, write_f32_le, write_f64_at, write_f64_le,
+    },
+    parse_mzml::{ChromatogramSummary, MzML, SpectrumSummary},
 };
 
-pub fn encode(mzml: &MzML) -> Vec<u8> {
-    const H: usize = 64;
-    const SI: usize = 32;
-    const CI: usize = 32;
-    const SM: usize = 104;
-    const CM: usize = 24;
+pub(crate) const BIN1_HEADER: usize = 64;
+pub(crate) const BIN1_INDEX: usize = 32;
+pub(crate) const BIN1_SPEC_META: usize = 104;
+pub(crate) const BIN1_CHROM_META: usize = 24;
 
-    #[inline]
-    fn a8(x: usize) -> usize {
-        (x + 7) & !7
+pub(crate) const FMT_F32: u8 = 1;
+pub(crate) const FMT_F64: u8 = 2;
+
+pub(crate) fn put_header(out: &mut [u8], n_spec: u32, n_ch: u32, chrom_y: u8, spec_y: u8) {
+    out[0..4].copy_from_slice(b"BIN1");
+    set_u32_at(out, 4, n_spec);
+    set_u32_at(out, 8, n_ch);
+    out[12] = FMT_F64;
+    out[13] = chrom_y;
+    out[14] = FMT_F64;
+    out[15] = spec_y;
+}
+
+fn intensity_fmt<'a>(
+    mut arrays: impl Iterator<Item = (&'a Option<Vec<f64>>, &'a Option<Vec<f32>>)>,
+) -> u8 {
+    let mut any_f32 = false;
+    let all_f32 = arrays.all(|(wide, narrow)| {
+        any_f32 |= narrow.is_some();
+        wide.is_none()
+    });
+    if all_f32 && any_f32 { FMT_F32 } else { FMT_F64 }
+}
+
+fn intensity_bytes(wide: &Option<Vec<f64>>, narrow: &Option<Vec<f32>>, fmt: u8) -> Option<usize> {
+    match (wide, narrow) {
+        (Some(v), _) => Some(v.len() * 8),
+        (None, Some(v)) if fmt == FMT_F32 => Some(v.len() * 4),
+        (None, Some(v)) => Some(v.len() * 8),
+        _ => None,
     }
+}
 
-    let run = match mzml.run.as_ref() {
-        Some(r) => r,
-        None => {
-            let mut out = vec![0u8; H];
-            out[0..4].copy_from_slice(b"BIN1");
-            set_u32_at(&mut out, 4, 0);
-            set_u32_at(&mut out, 8, 0);
-            out[12] = 2;
-            out[13] = 2;
-            out[14] = 2;
-            out[15] = 2;
-            set_u64_at(&mut out, 56, H as u64);
-            return out;
+unsafe fn write_intensities(
+    out: &mut Vec<u8>,
+    cur: &mut usize,
+    wide: &Option<Vec<f64>>,
+    narrow: &Option<Vec<f32>>,
+    fmt: u8,
+) -> (u64, u32) {
+    match (wide, narrow) {
+        (Some(v), _) if !v.is_empty() => unsafe { write_f64_le(out, cur, v) },
+        (None, Some(v)) if !v.is_empty() && fmt == FMT_F32 => unsafe { write_f32_le(out, cur, v) },
+        (None, Some(v)) if !v.is_empty() => {
+            let w: Vec<f64> = v.iter().map(|&x| x as f64).collect();
+            unsafe { write_f64_le(out, cur, &w) }
         }
+        _ => (0, 0),
+    }
+}
+
+pub(crate) fn put_index_entry(out: &mut [u8], b: usize, x: (u64, u32), y: (u64, u32)) {
+    set_u64_at(out, b + 0, x.0);
+    set_u32_at(out, b + 8, x.1);
+    set_u64_at(out, b + 12, y.0);
+    set_u32_at(out, b + 20, y.1);
+    set_u64_at(out, b + 24, 0);
+}
+
+pub(crate) fn put_spectrum_meta(out: &mut [u8], b: usize, s: &SpectrumSummary) {
+    set_u32_at(out, b + 0, s.index as u32);
+    set_u32_at(out, b + 4, s.array_length as u32);
+    out[b + 8] = s.ms_level.unwrap_or(255);
+    out[b + 9] = s.polarity.unwrap_or(255);
+    out[b + 10] = s.spectrum_type.unwrap_or(255);
+    out[b + 11] = 0;
+    set_f64_at(out, b + 12, s.retention_time.unwrap_or(-1.0));
+    set_f64_at(out, b + 20, s.scan_window_lower_limit.unwrap_or(-1.0));
+    set_f64_at(out, b + 28, s.scan_window_upper_limit.unwrap_or(-1.0));
+    set_f64_at(out, b + 36, s.total_ion_current.unwrap_or(-1.0));
+    set_f64_at(out, b + 44, s.base_peak_intensity.unwrap_or(-1.0));
+    set_f64_at(out, b + 52, s.base_peak_mz.unwrap_or(-1.0));
+    let (tgt, low, up, sel) = match &s.precursor {
+        Some(p) => (
+            p.isolation_window_target_mz.unwrap_or(-1.0),
+            p.isolation_window_lower_offset.unwrap_or(-1.0),
+            p.isolation_window_upper_offset.unwrap_or(-1.0),
+            p.selected_ion_mz.unwrap_or(-1.0),
+        ),
+        None => (-1.0, -1.0, -1.0, -1.0),
     };
+    set_f64_at(out, b + 60, tgt);
+    set_f64_at(out, b + 68, low);
+    set_f64_at(out, b + 76, up);
+    set_f64_at(out, b + 84, sel);
+}
 
-    let n_spec = run.spectra.len() as u32;
-    let n_ch = run.chromatograms.len() as u32;
+pub(crate) fn put_chrom_meta(out: &mut [u8], b: usize, c: &ChromatogramSummary, id: (u64, u32)) {
+    set_u32_at(out, b + 0, c.index as u32);
+    set_u32_at(out, b + 4, c.array_length as u32);
+    set_u64_at(out, b + 8, id.0);
+    set_u32_at(out, b + 16, id.1);
+    set_u32_at(out, b + 20, 0);
+}
 
-    let sb = (n_spec as usize) * SI;
-    let cb = (n_ch as usize) * CI;
-    let smb = (n_spec as usize) * SM;
-    let cmb = (n_ch as usize) * CM;
+pub(crate) type Slot = (u64, u32);
 
-    let mut plan = H + sb + cb + smb + cmb;
+pub(crate) struct Tables {
+    pub spec_index: usize,
+    pub chrom_index: usize,
+    pub spec_meta: usize,
+    pub chrom_meta: usize,
+    pub data: usize,
+}
 
-    for s in &run.spectra {
-        if let Some(v) = &s.mz_array {
-            plan = a8(plan);
-            plan += v.len() * 8;
+impl Tables {
+    pub(crate) fn new(n_spec: usize, n_ch: usize) -> Self {
+        let spec_index = BIN1_HEADER;
+        let chrom_index = spec_index + n_spec * BIN1_INDEX;
+        let spec_meta = chrom_index + n_ch * BIN1_INDEX;
+        let chrom_meta = spec_meta + n_spec * BIN1_SPEC_META;
+        let data = chrom_meta + n_ch * BIN1_CHROM_META;
+        Self {
+            spec_index,
+            chrom_index,
+            spec_meta,
+            chrom_meta,
+            data,
         }
     }
-    for s in &run.spectra {
-        if let Some(v) = &s.intensity_array {
-            plan = a8(plan);
-            plan += v.len() * 8;
-        }
-    }
-    for c in &run.chromatograms {
+}
+
+#[inline]
+pub(crate) fn a8(x: usize) -> usize {
+    (x + 7) & !7
+}
+
+pub(crate) fn chrom_intensity_fmt(chroms: &[ChromatogramSummary]) -> u8 {
+    intensity_fmt(
+        chroms
+            .iter()
+            .map(|c| (&c.intensity_array, &c.intensity_array_f32)),
+    )
+}
+
+pub(crate) fn plan_chromatograms(
+    mut plan: usize,
+    chroms: &[ChromatogramSummary],
+    fmt: u8,
+) -> usize {
+    for c in chroms {
         if let Some(v) = &c.time_array {
             plan = a8(plan);
             plan += v.len() * 8;
         }
     }
-    for c in &run.chromatograms {
-        if let Some(v) = &c.intensity_array {
+    for c in chroms {
+        if let Some(n) = intensity_bytes(&c.intensity_array, &c.intensity_array_f32, fmt) {
             plan = a8(plan);
-            plan += v.len() * 8;
+            plan += n;
         }
     }
-    for c in &run.chromatograms {
+    for c in chroms {
         let b = c.id.as_bytes();
         if !b.is_empty() {
             plan = a8(plan);
             plan += b.len();
         }
     }
+    plan
+}
 
-    let mut out: Vec<u8> = Vec::with_capacity(plan);
-    unsafe {
-        out.set_len(plan);
-    }
-    let mut cur = H;
-
-    out[0..4].copy_from_slice(b"BIN1");
-    set_u32_at(&mut out, 4, n_spec);
-    set_u32_at(&mut out, 8, n_ch);
-    out[12] = 2;
-    out[13] = 2;
-    out[14] = 2;
-    out[15] = 2;
-
-    let spec_index_off = cur as u64;
-    cur += sb;
-    let chrom_index_off = cur as u64;
-    cur += cb;
-    let spec_meta_off = cur as u64;
-    cur += smb;
-    let chrom_meta_off = cur as u64;
-    cur += cmb;
-    let data_off = cur as u64;
-
-    let mut sx: Vec<(u64, u32)> = Vec::with_capacity(n_spec as usize);
-    for s in &run.spectra {
-        let p = match &s.mz_array {
-            Some(v) if !v.is_empty() => unsafe { write_f64_le(&mut out, &mut cur, v) },
-            _ => (0, 0),
-        };
-        sx.push(p);
-    }
-    let mut sy: Vec<(u64, u32)> = Vec::with_capacity(n_spec as usize);
-    for s in &run.spectra {
-        let p = match &s.intensity_array {
-            Some(v) if !v.is_empty() => unsafe { write_f64_le(&mut out, &mut cur, v) },
-            _ => (0, 0),
-        };
-        sy.push(p);
-    }
-    let mut cx: Vec<(u64, u32)> = Vec::with_capacity(n_ch as usize);
-    for c in &run.chromatograms {
+pub(crate) fn write_chromatograms(
+    out: &mut Vec<u8>,
+    cur: &mut usize,
+    chroms: &[ChromatogramSummary],
+    fmt: u8,
+) -> (Vec<Slot>, Vec<Slot>, Vec<Slot>) {
+    let mut cx: Vec<Slot> = Vec::with_capacity(chroms.len());
+    for c in chroms {
         let p = match &c.time_array {
-            Some(v) if !v.is_empty() => unsafe { write_f64_le(&mut out, &mut cur, v) },
+            Some(v) if !v.is_empty() => unsafe { write_f64_le(out, cur, v) },
             _ => (0, 0),
         };
         cx.push(p);
     }
-    let mut cy: Vec<(u64, u32)> = Vec::with_capacity(n_ch as usize);
-    for c in &run.chromatograms {
-        let p = match &c.intensity_array {
-            Some(v) if !v.is_empty() => unsafe { write_f64_le(&mut out, &mut cur, v) },
-            _ => (0, 0),
-        };
-        cy.push(p);
+    let mut cy: Vec<Slot> = Vec::with_capacity(chroms.len());
+    for c in chroms {
+        let (wide, narrow) = (&c.intensity_array, &c.intensity_array_f32);
+        cy.push(unsafe { write_intensities(out, cur, wide, narrow, fmt) });
     }
-    let mut cid: Vec<(u64, u32)> = Vec::with_capacity(n_ch as usize);
-    for c in &run.chromatograms {
+    let mut cid: Vec<Slot> = Vec::with_capacity(chroms.len());
+    for c in chroms {
         let s = c.id.as_bytes();
         if s.is_empty() {
             cid.push((0, 0));
         } else {
-            cur = a8(cur);
-            let off = cur as u64;
+            *cur = a8(*cur);
+            let off = *cur as u64;
             let len = s.len() as u32;
-            ensure_cap(&mut out, cur + s.len());
+            ensure_cap(out, *cur + s.len());
             unsafe {
-                std::ptr::copy_nonoverlapping(s.as_ptr(), out.as_mut_ptr().add(cur), s.len());
+                std::ptr::copy_nonoverlapping(s.as_ptr(), out.as_mut_ptr().add(*cur), s.len());
             }
-            cur += s.len();
+            *cur += s.len();
             cid.push((off, len));
         }
     }
+    (cx, cy, cid)
+}
 
-    for i in 0..(n_spec as usize) {
-        let b = spec_index_off as usize + i * SI;
-        let (x_off, x_len) = sx[i];
-        let (y_off, y_len) = sy[i];
-        set_u64_at(&mut out, b + 0, x_off);
-        set_u32_at(&mut out, b + 8, x_len);
-        set_u64_at(&mut out, b + 12, y_off);
-        set_u32_at(&mut out, b + 20, y_len);
-        set_u64_at(&mut out, b + 24, 0);
+pub(crate) fn put_tables(
+    out: &mut [u8],
+    t: &Tables,
+    spectra: &[SpectrumSummary],
+    sx: &[Slot],
+    sy: &[Slot],
+    chroms: &[ChromatogramSummary],
+    (cx, cy, cid): &(Vec<Slot>, Vec<Slot>, Vec<Slot>),
+    total: usize,
+) {
+    for i in 0..spectra.len() {
+        put_index_entry(out, t.spec_index + i * BIN1_INDEX, sx[i], sy[i]);
     }
-    for i in 0..(n_ch as usize) {
-        let b = chrom_index_off as usize + i * CI;
-        let (x_off, x_len) = cx[i];
-        let (y_off, y_len) = cy[i];
-        set_u64_at(&mut out, b + 0, x_off);
-        set_u32_at(&mut out, b + 8, x_len);
-        set_u64_at(&mut out, b + 12, y_off);
-        set_u32_at(&mut out, b + 20, y_len);
-        set_u64_at(&mut out, b + 24, 0);
+    for i in 0..chroms.len() {
+        put_index_entry(out, t.chrom_index + i * BIN1_INDEX, cx[i], cy[i]);
+    }
+    for (i, s) in spectra.iter().enumerate() {
+        put_spectrum_meta(out, t.spec_meta + i * BIN1_SPEC_META, s);
+    }
+    for (i, c) in chroms.iter().enumerate() {
+        put_chrom_meta(out, t.chrom_meta + i * BIN1_CHROM_META, c, cid[i]);
     }
 
-    for (i, s) in run.spectra.iter().enumerate() {
-        let b = spec_meta_off as usize + i * SM;
-        set_u32_at(&mut out, b + 0, s.index as u32);
-        set_u32_at(&mut out, b + 4, s.array_length as u32);
-        out[b + 8] = s.ms_level.unwrap_or(255);
-        out[b + 9] = s.polarity.unwrap_or(255);
-        out[b + 10] = s.spectrum_type.unwrap_or(255);
-        out[b + 11] = 0;
-        set_f64_at(&mut out, b + 12, s.retention_time.unwrap_or(-1.0));
-        set_f64_at(&mut out, b + 20, s.scan_window_lower_limit.unwrap_or(-1.0));
-        set_f64_at(&mut out, b + 28, s.scan_window_upper_limit.unwrap_or(-1.0));
-        set_f64_at(&mut out, b + 36, s.total_ion_current.unwrap_or(-1.0));
-        set_f64_at(&mut out, b + 44, s.base_peak_intensity.unwrap_or(-1.0));
-        set_f64_at(&mut out, b + 52, s.base_peak_mz.unwrap_or(-1.0));
-        let (tgt, low, up, sel) = match &s.precursor {
-            Some(p) => (
-                p.isolation_window_target_mz.unwrap_or(-1.0),
-                p.isolation_window_lower_offset.unwrap_or(-1.0),
-                p.isolation_window_upper_offset.unwrap_or(-1.0),
-                p.selected_ion_mz.unwrap_or(-1.0),
-            ),
-            None => (-1.0, -1.0, -1.0, -1.0),
-        };
-        set_f64_at(&mut out, b + 60, tgt);
-        set_f64_at(&mut out, b + 68, low);
-        set_f64_at(&mut out, b + 76, up);
-        set_f64_at(&mut out, b + 84, sel);
+    let has_spec = !spectra.is_empty();
+    let has_ch = !chroms.is_empty();
+    set_u64_at(out, 16, if has_spec { t.spec_index as u64 } else { 0 });
+    set_u64_at(out, 24, if has_ch { t.chrom_index as u64 } else { 0 });
+    set_u64_at(out, 32, if has_spec { t.spec_meta as u64 } else { 0 });
+    set_u64_at(out, 40, if has_ch { t.chrom_meta as u64 } else { 0 });
+    set_u64_at(out, 48, t.data as u64);
+    set_u64_at(out, 56, total as u64);
+}
+
+pub(crate) fn empty_bin1() -> Vec<u8> {
+    let mut out = vec![0u8; BIN1_HEADER];
+    put_header(&mut out, 0, 0, FMT_F64, FMT_F64);
+    set_u64_at(&mut out, 56, BIN1_HEADER as u64);
+    out
+}
+
+pub fn encode(mzml: &MzML) -> Vec<u8> {
+    let run = match mzml.run.as_ref() {
+        Some(r) => r,
+        None => return empty_bin1(),
+    };
+
+    let n_spec = run.spectra.len() as u32;
+    let n_ch = run.chromatograms.len() as u32;
+    let spec_y = intensity_fmt(
+        run.spectra
+            .iter()
+            .map(|s| (&s.intensity_array, &s.intensity_array_f32)),
+    );
+    let chrom_y = chrom_intensity_fmt(&run.chromatograms);
+    let tables = Tables::new(n_spec as usize, n_ch as usize);
+
+    let mut plan = tables.data;
+    for s in &run.spectra {
+        if let Some(v) = &s.mz_array {
+            plan = a8(plan);
+            plan += v.len() * 8;
+        }
     }
+    for s in &run.spectra {
+        if let Some(n) = intensity_bytes(&s.intensity_array, &s.intensity_array_f32, spec_y) {
+            plan = a8(plan);
+            plan += n;
+        }
+    }
+    let plan = plan_chromatograms(plan, &run.chromatograms, chrom_y);
 
-    for i in 0..(n_ch as usize) {
-        let b = chrom_meta_off as usize + i * CM;
-        set_u32_at(&mut out, b + 0, run.chromatograms[i].index as u32);
-        set_u32_at(&mut out, b + 4, run.chromatograms[i].array_length as u32);
-        let (off, len) = cid[i];
-        set_u64_at(&mut out, b + 8, off);
-        set_u32_at(&mut out, b + 16, len);
-        set_u32_at(&mut out, b + 20, 0);
+    let mut out = vec![0u8; plan];
+    let mut cur = tables.data;
+
+    put_header(&mut out, n_spec, n_ch, chrom_y, spec_y);
+
+    let mut sx: Vec<Slot> = Vec::with_capacity(n_spec as usize);
+    for s in &run.spectra {
+        let p = match &s.mz_array {
+            Some(v) if !v.is_empty() => unsafe { write_f64_le(&mut out, &mut cur, v) },
+            _ => (0, 0),
+        };
+        sx.push(p);
+    }
+    let mut sy: Vec<Slot> = Vec::with_capacity(n_spec as usize);
+    for s in &run.spectra {
+        let (wide, narrow) = (&s.intensity_array, &s.intensity_array_f32);
+        sy.push(unsafe { write_intensities(&mut out, &mut cur, wide, narrow, spec_y) });
     }
+    let chrom_slots = write_chromatograms(&mut out, &mut cur, &run.chromatograms, chrom_y);
 
-    let total = cur as u64;
-    set_u64_at(&mut out, 16, if n_spec > 0 { spec_index_off } else { 0 });
-    set_u64_at(&mut out, 24, if n_ch > 0 { chrom_index_off } else { 0 });
-    set_u64_at(&mut out, 32, if n_spec > 0 { spec_meta_off } else { 0 });
-    set_u64_at(&mut out, 40, if n_ch > 0 { chrom_meta_off } else { 0 });
-    set_u64_at(&mut out, 48, data_off);
-    set_u64_at(&mut out, 56, total);
+    put_tables(
+        &mut out,
+        &tables,
+        &run.spectra,
+        &sx,
+        &sy,
+        &run.chromatograms,
+        &chrom_slots,
+        cur,
+    );
 
     out.truncate(cur);
     out
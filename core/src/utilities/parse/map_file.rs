@@ -0,0 +1,14 @@
+use memmap2::Mmap;
+use std::{fs::File, path::Path};
+
+pub fn map_file(path: &Path) -> Result<Mmap, String> {
+    let file = File::open(path).map_err(|e| format!("open {}: {e}", path.display()))?;
+    let map = unsafe { Mmap::map(&file) }.map_err(|e| format!("mmap {}: {e}", path.display()))?;
+    #[cfg(unix)]
+    {
+        use memmap2::Advice;
+        let _ = map.advise(Advice::Sequential);
+        let _ = map.advise(Advice::WillNeed);
+    }
+    Ok(map)
+}
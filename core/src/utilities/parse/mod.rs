@@ -1,3 +1,5 @@
+pub mod b64;
+pub mod bin1_view;
 pub mod encode;
 pub use encode::encode;
 pub mod decode;
@@ -5,5 +7,10 @@ pub use decode::decode;
 pub mod bin_to_json;
 pub use bin_to_json::bin_to_json;
 pub mod helper;
+pub mod mzml_to_bin1;
+pub mod numpress;
 pub mod parse_mzml;
+pub mod stream_bin1;
+#[cfg(not(target_arch = "wasm32"))]
+pub mod map_file;
 pub use helper::*;
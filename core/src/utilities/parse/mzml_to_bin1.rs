@@ -0,0 +1,262 @@
+use rayon::prelude::*;
+
+use crate::utilities::parse::{
+    encode::{
+        FMT_F32, FMT_F64, Slot, Tables, a8, chrom_intensity_fmt, empty_bin1, encode,
+        plan_chromatograms, put_header, put_tables, write_chromatograms,
+    },
+    numpress,
+    parse_mzml::{
+        BinaryArraySpan, MzML, ParseFilter, Scratch, SpectrumSummary, decode_array_to,
+        parse_mzml_native_filtered, parse_mzml_spans,
+    },
+};
+use crate::utilities::threads::{WithCores, in_pool};
+
+pub fn parse_mzml_to_bin1(bytes: &[u8], cores: usize) -> Result<Vec<u8>, String> {
+    parse_mzml_to_bin1_filtered(bytes, cores, &ParseFilter::ALL)
+}
+
+pub fn parse_mzml_to_bin1_filtered(
+    bytes: &[u8],
+    cores: usize,
+    filter: &ParseFilter,
+) -> Result<Vec<u8>, String> {
+    to_bin1(bytes, cores, filter).map(|(_, bin)| bin)
+}
+
+pub fn parse_mzml_to_bin1_with_meta(bytes: &[u8], cores: usize) -> Result<(MzML, Vec<u8>), String> {
+    to_bin1(bytes, cores, &ParseFilter::ALL)
+}
+
+fn to_bin1(bytes: &[u8], cores: usize, filter: &ParseFilter) -> Result<(MzML, Vec<u8>), String> {
+    let mut mzml = parse_mzml_spans(bytes, cores, filter)?;
+    let Some(run) = mzml.run.as_mut() else {
+        return Ok((mzml, empty_bin1()));
+    };
+    if !run.spectra.iter().all(presized) {
+        return reencode(bytes, cores, filter);
+    }
+
+    let narrow = narrow_intensities(&run.spectra);
+    let spec_y = if narrow { FMT_F32 } else { FMT_F64 };
+    let chrom_y = chrom_intensity_fmt(&run.chromatograms);
+    let tables = Tables::new(run.spectra.len(), run.chromatograms.len());
+
+    let mut cur = tables.data;
+    let mut reserve = |span: Option<BinaryArraySpan>, bytes: usize| {
+        span.map(|_| {
+            cur = a8(cur);
+            cur += bytes;
+            (cur - bytes, bytes)
+        })
+    };
+    let mz_slots: Vec<Option<(usize, usize)>> = run
+        .spectra
+        .iter()
+        .map(|s| reserve(s.array_spans.and_then(|a| a.mz), s.array_length * 8))
+        .collect();
+    let width = if narrow { 4 } else { 8 };
+    let int_slots: Vec<Option<(usize, usize)>> = run
+        .spectra
+        .iter()
+        .map(|s| {
+            reserve(
+                s.array_spans.and_then(|a| a.intensity),
+                s.array_length * width,
+            )
+        })
+        .collect();
+    let mz_end = mz_slots
+        .iter()
+        .flatten()
+        .last()
+        .map_or(tables.data, |&(off, len)| off + len);
+    let spec_end = cur;
+    let total = plan_chromatograms(spec_end, &run.chromatograms, chrom_y);
+
+    let mut out = vec![0u8; total];
+    put_header(
+        &mut out,
+        run.spectra.len() as u32,
+        run.chromatograms.len() as u32,
+        chrom_y,
+        spec_y,
+    );
+
+    let counts = {
+        let (mz_region, rest) = out[tables.data..spec_end].split_at_mut(mz_end - tables.data);
+        let mz_dst = carve(mz_region, tables.data, &mz_slots);
+        let int_dst = carve(rest, mz_end, &int_slots);
+        decode_spectra(bytes, &mut run.spectra, mz_dst, int_dst, narrow, cores)
+    };
+    let Some(counts) = counts.into_iter().collect::<Option<Vec<_>>>() else {
+        return reencode(bytes, cores, filter);
+    };
+
+    let mut cur = tables.data;
+    let mut place = |slot: &Option<(usize, usize)>, n: Option<usize>, width: usize| -> Slot {
+        match (slot, n) {
+            (Some((off, _)), Some(n)) if n > 0 => {
+                let at = a8(cur);
+                out[cur..at].fill(0);
+                if *off != at {
+                    out.copy_within(*off..off + n * width, at);
+                }
+                cur = at + n * width;
+                (at as u64, n as u32)
+            }
+            _ => (0, 0),
+        }
+    };
+    let sx: Vec<Slot> = mz_slots
+        .iter()
+        .zip(&counts)
+        .map(|(s, &(n, _))| place(s, n, 8))
+        .collect();
+    let sy: Vec<Slot> = int_slots
+        .iter()
+        .zip(&counts)
+        .map(|(s, &(_, n))| place(s, n, width))
+        .collect();
+    out[cur..spec_end].fill(0);
+
+    let chrom_slots = write_chromatograms(&mut out, &mut cur, &run.chromatograms, chrom_y);
+    put_tables(
+        &mut out,
+        &tables,
+        &run.spectra,
+        &sx,
+        &sy,
+        &run.chromatograms,
+        &chrom_slots,
+        cur,
+    );
+    out.truncate(cur);
+    Ok((mzml, out))
+}
+
+fn reencode(bytes: &[u8], cores: usize, filter: &ParseFilter) -> Result<(MzML, Vec<u8>), String> {
+    let mzml = parse_mzml_native_filtered(bytes, true, cores, filter)?;
+    let bin = encode(&mzml);
+    Ok((mzml, bin))
+}
+
+fn presized(s: &SpectrumSummary) -> bool {
+    let sized = |span: Option<BinaryArraySpan>| span.map_or(true, |sp| sp.end <= sp.start);
+    s.array_length > 0
+        || s.array_spans
+            .map_or(true, |a| sized(a.mz) && sized(a.intensity))
+}
+
+fn narrow_intensities(spectra: &[SpectrumSummary]) -> bool {
+    let mut any = false;
+    let all = spectra
+        .iter()
+        .filter_map(|s| s.array_spans.and_then(|a| a.intensity))
+        .all(|span| {
+            any = true;
+            span.bits == 32 && span.numpress == numpress::NONE
+        });
+    all && any
+}
+
+fn carve<'a>(
+    mut region: &'a mut [u8],
+    base: usize,
+    slots: &[Option<(usize, usize)>],
+) -> Vec<Option<&'a mut [u8]>> {
+    let mut at = base;
+    slots
+        .iter()
+        .map(|slot| {
+            let (off, len) = (*slot)?;
+            let (_, rest) = std::mem::take(&mut region).split_at_mut(off - at);
+            let (dst, rest) = rest.split_at_mut(len);
+            region = rest;
+            at = off + len;
+            Some(dst)
+        })
+        .collect()
+}
+
+fn decode_spectra(
+    bytes: &[u8],
+    spectra: &mut [SpectrumSummary],
+    mz: Vec<Option<&mut [u8]>>,
+    int: Vec<Option<&mut [u8]>>,
+    narrow: bool,
+    cores: usize,
+) -> Vec<Option<(Option<usize>, Option<usize>)>> {
+    let work = move || {
+        spectra
+            .par_iter_mut()
+            .zip(mz.into_par_iter())
+            .zip(int.into_par_iter())
+            .with_cores(cores)
+            .with_min_len(16)
+            .map_init(
+                || Scratch::with_f32(true),
+                |scratch, ((s, mz), int)| decode_spectrum_to(bytes, s, mz, int, narrow, scratch),
+            )
+            .collect()
+    };
+    in_pool(cores, work)
+}
+
+fn decode_spectrum_to(
+    bytes: &[u8],
+    s: &mut SpectrumSummary,
+    mz: Option<&mut [u8]>,
+    int: Option<&mut [u8]>,
+    narrow: bool,
+    scratch: &mut Scratch,
+) -> Option<(Option<usize>, Option<usize>)> {
+    let spans = s.array_spans.take().unwrap_or_default();
+    let (mz, nm) = match (spans.mz, mz) {
+        (Some(span), Some(dst)) => {
+            let n = decode_array_to(bytes, &span, false, dst, scratch)?;
+            (Some(&*dst), Some(n))
+        }
+        _ => (None, None),
+    };
+    let (int, ni) = match (spans.intensity, int) {
+        (Some(span), Some(dst)) => {
+            let n = decode_array_to(bytes, &span, narrow, dst, scratch)?;
+            (Some(&*dst), Some(n))
+        }
+        _ => (None, None),
+    };
+
+    if s.total_ion_current.is_none() || s.base_peak_intensity.is_none() || s.base_peak_mz.is_none()
+    {
+        if let (Some(mz), Some(nm), Some(int), Some(ni)) = (mz, nm, int, ni) {
+            let width = if narrow { 4 } else { 8 };
+            let (tic, bpi, bpmz) = tic_and_base_peak(&mz[..nm * 8], &int[..ni * width], narrow);
+            s.total_ion_current.get_or_insert(tic);
+            s.base_peak_intensity.get_or_insert(bpi);
+            s.base_peak_mz.get_or_insert(bpmz);
+        }
+    }
+    Some((nm, ni))
+}
+
+fn tic_and_base_peak(mz: &[u8], int: &[u8], narrow: bool) -> (f64, f64, f64) {
+    let mut tic = 0.0;
+    let mut bpi = 0.0;
+    let mut bpmz = 0.0;
+    let width = if narrow { 4 } else { 8 };
+    for (m, c) in mz.chunks_exact(8).zip(int.chunks_exact(width)) {
+        let v = if narrow {
+            f32::from_le_bytes([c[0], c[1], c[2], c[3]]) as f64
+        } else {
+            f64::from_le_bytes([c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7]])
+        };
+        tic += v;
+        if v > bpi {
+            bpi = v;
+            bpmz = f64::from_le_bytes([m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7]]);
+        }
+    }
+    (tic, bpi, bpmz)
+}
@@ -0,0 +1,130 @@
+pub const NONE: u8 = 0;
+pub const LINEAR: u8 = 1;
+pub const PIC: u8 = 2;
+pub const SLOF: u8 = 3;
+
+pub fn decode_into(kind: u8, data: &[u8], out: &mut Vec<f64>) -> Result<usize, ()> {
+    out.clear();
+    match kind {
+        LINEAR => decode_linear(data, out),
+        PIC => decode_pic(data, out),
+        SLOF => decode_slof(data, out),
+        _ => Err(()),
+    }?;
+    Ok(out.len())
+}
+
+fn fixed_point(data: &[u8]) -> Result<f64, ()> {
+    let b: [u8; 8] = data.get(..8).ok_or(())?.try_into().map_err(|_| ())?;
+    Ok(f64::from_be_bytes(b))
+}
+
+fn read_u32_le(data: &[u8], at: usize) -> Result<i64, ()> {
+    let b: [u8; 4] = data.get(at..at + 4).ok_or(())?.try_into().map_err(|_| ())?;
+    Ok(u32::from_le_bytes(b) as i64)
+}
+
+struct Nibbles<'a> {
+    data: &'a [u8],
+    di: usize,
+    half: bool,
+}
+
+impl<'a> Nibbles<'a> {
+    fn new(data: &'a [u8], di: usize) -> Self {
+        Self {
+            data,
+            di,
+            half: false,
+        }
+    }
+
+    #[inline]
+    fn done(&self) -> bool {
+        if self.di >= self.data.len() {
+            return true;
+        }
+        self.half && self.di == self.data.len() - 1 && self.data[self.di] & 0x0F == 0
+    }
+
+    #[inline]
+    fn nibble(&mut self) -> u32 {
+        let b = self.data[self.di];
+        if self.half {
+            self.di += 1;
+            self.half = false;
+            (b & 0x0F) as u32
+        } else {
+            self.half = true;
+            (b >> 4) as u32
+        }
+    }
+
+    #[inline]
+    fn next_int(&mut self) -> Result<u32, ()> {
+        let head = self.nibble();
+        let (n, mut res) = if head <= 8 {
+            (head, 0u32)
+        } else {
+            let n = head - 8;
+            (n, !(u32::MAX >> (4 * n)))
+        };
+        if n == 8 {
+            return Ok(res);
+        }
+        let left = (8 - n) as usize;
+        let avail = (self.data.len() - self.di) * 2 - self.half as usize;
+        if left > avail {
+            return Err(());
+        }
+        for i in 0..left {
+            res |= self.nibble() << (4 * i);
+        }
+        Ok(res)
+    }
+}
+
+fn decode_linear(data: &[u8], out: &mut Vec<f64>) -> Result<(), ()> {
+    if data.len() == 8 {
+        return Ok(());
+    }
+    let fp = fixed_point(data)?;
+    let mut prev = read_u32_le(data, 8)?;
+    out.push(prev as f64 / fp);
+    if data.len() == 12 {
+        return Ok(());
+    }
+    let mut cur = read_u32_le(data, 12)?;
+    out.push(cur as f64 / fp);
+
+    let mut nib = Nibbles::new(data, 16);
+    while !nib.done() {
+        let diff = nib.next_int()? as i32 as i64;
+        let y = 2 * cur - prev + diff;
+        out.push(y as f64 / fp);
+        prev = cur;
+        cur = y;
+    }
+    Ok(())
+}
+
+fn decode_pic(data: &[u8], out: &mut Vec<f64>) -> Result<(), ()> {
+    let mut nib = Nibbles::new(data, 0);
+    while !nib.done() {
+        out.push(nib.next_int()? as f64);
+    }
+    Ok(())
+}
+
+fn decode_slof(data: &[u8], out: &mut Vec<f64>) -> Result<(), ()> {
+    let fp = fixed_point(data)?;
+    let body = &data[8..];
+    if body.len() % 2 != 0 {
+        return Err(());
+    }
+    out.extend(
+        body.chunks_exact(2)
+            .map(|c| (u16::from_le_bytes([c[0], c[1]]) as f64 / fp).exp() - 1.0),
+    );
+    Ok(())
+}
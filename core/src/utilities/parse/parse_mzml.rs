@@ -1,11 +1,22 @@
-use base64::Engine;
-use base64::engine::general_purpose::STANDARD;
 use memchr::{memchr as mc_memchr, memmem};
-use miniz_oxide::inflate::decompress_to_vec_zlib;
+use miniz_oxide::inflate::{
+    TINFLStatus,
+    core::{
+        DecompressorOxide, decompress,
+        inflate_flags::{TINFL_FLAG_PARSE_ZLIB_HEADER, TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF},
+    },
+};
+use rayon::prelude::*;
 use serde::{Deserialize, Serialize};
 use std::io::{Cursor, Read, Seek, SeekFrom};
 use std::str;
 
+use crate::utilities::{
+    parse::{b64, numpress},
+    structs::FromTo,
+    threads::{WithCores, in_pool, thread_pool},
+};
+
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct SpectrumSummary {
     pub index: usize,
@@ -21,7 +32,30 @@ pub struct SpectrumSummary {
     pub base_peak_mz: Option<f64>,
     pub mz_array: Option<Vec<f64>>,
     pub intensity_array: Option<Vec<f64>>,
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub intensity_array_f32: Option<Vec<f32>>,
     pub precursor: Option<Precursor>,
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub array_spans: Option<SpectrumArraySpans>,
+}
+
+#[derive(Debug, Clone, Copy, Serialize, Deserialize)]
+pub struct BinaryArraySpan {
+    pub start: usize,
+    pub end: usize,
+    pub zlib: bool,
+    pub bits: u8,
+    pub little: bool,
+    #[serde(default)]
+    pub numpress: u8,
+}
+
+#[derive(Debug, Clone, Copy, Default, Serialize, Deserialize)]
+pub struct SpectrumArraySpans {
+    pub mz: Option<BinaryArraySpan>,
+    pub intensity: Option<BinaryArraySpan>,
+    #[serde(default)]
+    pub block: (usize, usize),
 }
 
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -132,6 +166,8 @@ pub struct ChromatogramSummary {
     pub array_length: usize,
     pub time_array: Option<Vec<f64>>,
     pub intensity_array: Option<Vec<f64>>,
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub intensity_array_f32: Option<Vec<f32>>,
     pub id: String,
 }
 
@@ -160,6 +196,67 @@ pub struct IndexList {
     pub file_checksum: Option<String>,
 }
 
+#[derive(Debug, Clone)]
+pub struct ParseFilter {
+    pub ms_levels: Option<Vec<u8>>,
+    pub rt_range: Option<FromTo>,
+    pub polarity: Option<u8>,
+    pub mz_array: bool,
+    pub intensity_array: bool,
+    pub chromatograms: bool,
+}
+
+impl ParseFilter {
+    pub const ALL: ParseFilter = ParseFilter {
+        ms_levels: None,
+        rt_range: None,
+        polarity: None,
+        mz_array: true,
+        intensity_array: true,
+        chromatograms: true,
+    };
+
+    pub fn ms1_in(window: FromTo) -> Self {
+        Self {
+            ms_levels: Some(vec![1]),
+            rt_range: Some(window),
+            ..Self::ALL
+        }
+    }
+
+    pub fn accepts(&self, ms_level: Option<u8>, rt: Option<f64>, polarity: Option<u8>) -> bool {
+        if let Some(levels) = &self.ms_levels {
+            if !ms_level.is_some_and(|l| levels.contains(&l)) {
+                return false;
+            }
+        }
+        if let Some(w) = self.rt_range {
+            if !rt.is_some_and(|t| t >= w.from && t <= w.to) {
+                return false;
+            }
+        }
+        match self.polarity {
+            Some(p) => polarity == Some(p),
+            None => true,
+        }
+    }
+
+    fn project(&self, spans: &mut SpectrumArraySpans) {
+        if !self.mz_array {
+            spans.mz = None;
+        }
+        if !self.intensity_array {
+            spans.intensity = None;
+        }
+    }
+}
+
+impl Default for ParseFilter {
+    fn default() -> Self {
+        Self::ALL
+    }
+}
+
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Precursor {
     pub isolation_window_target_mz: Option<f64>,
@@ -168,66 +265,255 @@ pub struct Precursor {
     pub selected_ion_mz: Option<f64>,
 }
 
-struct Scratch {
+pub(crate) struct Scratch {
     b64_buf: Vec<u8>,
     zlib_buf: Vec<u8>,
+    inflater: Box<DecompressorOxide>,
+    keep_f32: bool,
 }
 
-pub fn parse_mzml(bytes: &[u8], slim: bool) -> Result<MzML, String> {
-    if slim {
-        let run_header = parse_run_header(bytes);
-        let spectra = parse_spectra_internal(bytes)?;
-        let chromatograms = parse_chromatograms_linear(bytes)?;
-        let run = run_header.map(|mut r| {
-            r.spectra = spectra;
-            r.chromatograms = chromatograms;
-            r
-        });
+impl Scratch {
+    pub(crate) fn new() -> Self {
+        Self::with_f32(false)
+    }
 
-        return Ok(MzML {
-            cv_list: Vec::new(),
-            file_description: None,
-            referenceable_param_groups: Vec::new(),
-            sample_list: Vec::new(),
-            instrument_configurations: Vec::new(),
-            software_list: Vec::new(),
-            data_processing_list: Vec::new(),
-            acquisition_settings_list: Vec::new(),
-            run,
-            index_list: None,
-        });
+    pub(crate) fn with_f32(keep_f32: bool) -> Self {
+        Self {
+            b64_buf: Vec::with_capacity(256),
+            zlib_buf: Vec::with_capacity(256),
+            inflater: Box::default(),
+            keep_f32,
+        }
     }
+}
 
-    let cv_list = parse_cv_list(bytes);
-    let file_description = parse_file_description(bytes);
-    let referenceable_param_groups = parse_ref_param_groups(bytes);
-    let sample_list = parse_sample_list(bytes);
-    let instrument_configurations = parse_instrument_configurations(bytes);
-    let software_list = parse_software_list(bytes);
-    let data_processing_list = parse_data_processing_list(bytes);
-    let acquisition_settings_list = parse_acquisition_settings_list(bytes);
-    let index_list = parse_index_list_wrapper(bytes);
-    let run_header = parse_run_header(bytes);
-    let spectra = parse_spectra_internal(bytes)?;
-    let chromatograms = parse_chromatograms_linear(bytes)?;
-    let run = run_header.map(|mut r| {
+pub fn parse_mzml(bytes: &[u8], slim: bool, cores: usize) -> Result<MzML, String> {
+    parse_mzml_with(bytes, slim, cores, false, false, &ParseFilter::ALL)
+}
+
+pub fn parse_mzml_lazy(bytes: &[u8], slim: bool, cores: usize) -> Result<MzML, String> {
+    parse_mzml_with(bytes, slim, cores, true, false, &ParseFilter::ALL)
+}
+
+pub fn parse_mzml_native(bytes: &[u8], slim: bool, cores: usize) -> Result<MzML, String> {
+    parse_mzml_with(bytes, slim, cores, false, true, &ParseFilter::ALL)
+}
+
+pub fn parse_mzml_filtered(
+    bytes: &[u8],
+    slim: bool,
+    cores: usize,
+    filter: &ParseFilter,
+) -> Result<MzML, String> {
+    parse_mzml_with(bytes, slim, cores, false, false, filter)
+}
+
+pub fn parse_mzml_native_filtered(
+    bytes: &[u8],
+    slim: bool,
+    cores: usize,
+    filter: &ParseFilter,
+) -> Result<MzML, String> {
+    parse_mzml_with(bytes, slim, cores, false, true, filter)
+}
+
+pub(crate) fn parse_mzml_spans(
+    bytes: &[u8],
+    cores: usize,
+    filter: &ParseFilter,
+) -> Result<MzML, String> {
+    parse_mzml_with(bytes, true, cores, true, true, filter)
+}
+
+fn parse_mzml_with(
+    bytes: &[u8],
+    slim: bool,
+    cores: usize,
+    lazy: bool,
+    keep_f32: bool,
+    filter: &ParseFilter,
+) -> Result<MzML, String> {
+    let sections = scan_sections(bytes);
+    let header = || {
+        if slim {
+            MzML {
+                cv_list: Vec::new(),
+                file_description: None,
+                referenceable_param_groups: Vec::new(),
+                sample_list: Vec::new(),
+                instrument_configurations: Vec::new(),
+                software_list: Vec::new(),
+                data_processing_list: Vec::new(),
+                acquisition_settings_list: Vec::new(),
+                run: None,
+                index_list: None,
+            }
+        } else {
+            parse_metadata(&sections)
+        }
+    };
+    let body = || -> Result<_, String> {
+        let spectra = parse_spectra_internal(bytes, cores, lazy, keep_f32, filter)?;
+        let chromatograms = if filter.chromatograms {
+            parse_chromatograms_internal(bytes, sections.tail, cores, keep_f32)?
+        } else {
+            Vec::new()
+        };
+        Ok((spectra, chromatograms))
+    };
+    let (mut mzml, body) = if cores > 1 {
+        in_pool(cores, || rayon::join(header, body))
+    } else {
+        (header(), body())
+    };
+    let (spectra, chromatograms) = body?;
+    mzml.run = parse_run_header(sections.run).map(|mut r| {
         r.spectra = spectra;
         r.chromatograms = chromatograms;
         r
     });
+    Ok(mzml)
+}
+
+#[derive(Default)]
+struct Sections<'a> {
+    cv_list: &'a [u8],
+    file_description: &'a [u8],
+    referenceable_param_groups: &'a [u8],
+    sample_list: &'a [u8],
+    software_list: &'a [u8],
+    instrument_configurations: &'a [u8],
+    data_processing_list: &'a [u8],
+    acquisition_settings_list: &'a [u8],
+    run: &'a [u8],
+    tail: &'a [u8],
+}
+
+fn scan_sections(xml: &[u8]) -> Sections<'_> {
+    let mut s = Sections {
+        tail: xml,
+        ..Default::default()
+    };
+    let mut cur = 0usize;
+    while let Some(p) = mc_memchr(b'<', &xml[cur..]) {
+        let start = cur + p;
+        let rest = &xml[start + 1..];
+        if rest.starts_with(b"!--") {
+            cur = match memmem::find(rest, b"-->") {
+                Some(e) => start + 1 + e + 3,
+                None => break,
+            };
+            continue;
+        }
+        let gt = match mc_memchr(b'>', rest) {
+            Some(x) => start + 1 + x,
+            None => break,
+        };
+        let name_len = rest
+            .iter()
+            .position(|&b| is_ws(b) || b == b'>' || b == b'/')
+            .unwrap_or(rest.len());
+        let name = &rest[..name_len];
+        match name {
+            b"run" => {
+                let end = memmem::rfind(&xml[start..], b"</run>")
+                    .map(|e| start + e + b"</run>".len())
+                    .unwrap_or(xml.len());
+                s.run = &xml[start..end];
+                s.tail = &xml[end..];
+                break;
+            }
+            b"mzML" | b"indexedmzML" => {
+                cur = gt + 1;
+                continue;
+            }
+            _ if name.is_empty() || matches!(name[0], b'?' | b'!' | b'/') => {
+                cur = gt + 1;
+                continue;
+            }
+            _ => {}
+        }
+        let end = if xml[gt - 1] == b'/' {
+            gt + 1
+        } else {
+            let mut close = Vec::with_capacity(name.len() + 3);
+            close.extend_from_slice(b"</");
+            close.extend_from_slice(name);
+            close.push(b'>');
+            match memmem::find(&xml[gt..], &close) {
+                Some(e) => gt + e + close.len(),
+                None => break,
+            }
+        };
+        let span = &xml[start..end];
+        match name {
+            b"cvList" => s.cv_list = span,
+            b"fileDescription" => s.file_description = span,
+            b"referenceableParamGroupList" => s.referenceable_param_groups = span,
+            b"sampleList" => s.sample_list = span,
+            b"softwareList" => s.software_list = span,
+            b"instrumentConfigurationList" => s.instrument_configurations = span,
+            b"dataProcessingList" => s.data_processing_list = span,
+            b"acquisitionSettingsList" => s.acquisition_settings_list = span,
+            _ => {}
+        }
+        cur = end;
+    }
+    if s.run.is_empty() {
+        recover_run(xml, &mut s);
+    }
+    s
+}
 
-    Ok(MzML {
-        cv_list,
-        file_description,
-        referenceable_param_groups,
-        sample_list,
-        instrument_configurations,
-        software_list,
-        data_processing_list,
-        acquisition_settings_list,
-        run,
-        index_list,
-    })
+fn recover_run<'a>(xml: &'a [u8], s: &mut Sections<'a>) {
+    let finder = memmem::Finder::new(b"<run");
+    let mut from = 0usize;
+    let start = loop {
+        let Some(p) = finder.find(&xml[from..]) else {
+            return;
+        };
+        let at = from + p;
+        match xml.get(at + 4) {
+            Some(&b) if is_ws(b) || b == b'>' || b == b'/' => break at,
+            _ => from = at + 4,
+        }
+    };
+    let end = memmem::rfind(&xml[start..], b"</run>")
+        .map(|e| start + e + b"</run>".len())
+        .unwrap_or(xml.len());
+    s.run = &xml[start..end];
+    s.tail = &xml[end..];
+
+    let head = &xml[..start];
+    for section in [
+        &mut s.cv_list,
+        &mut s.file_description,
+        &mut s.referenceable_param_groups,
+        &mut s.sample_list,
+        &mut s.software_list,
+        &mut s.instrument_configurations,
+        &mut s.data_processing_list,
+        &mut s.acquisition_settings_list,
+    ] {
+        if section.is_empty() {
+            *section = head;
+        }
+    }
+}
+
+fn parse_metadata(s: &Sections) -> MzML {
+    MzML {
+        cv_list: parse_cv_list(s.cv_list),
+        file_description: parse_file_description(s.file_description),
+        referenceable_param_groups: parse_ref_param_groups(s.referenceable_param_groups),
+        sample_list: parse_sample_list(s.sample_list),
+        instrument_configurations: parse_instrument_configurations(s.instrument_configurations),
+        software_list: parse_software_list(s.software_list),
+        data_processing_list: parse_data_processing_list(s.data_processing_list),
+        acquisition_settings_list: parse_acquisition_settings_list(s.acquisition_settings_list),
+        run: None,
+        index_list: parse_index_list_wrapper(s.tail),
+    }
 }
 
 fn parse_cv_list(xml: &[u8]) -> Vec<CvEntry> {
@@ -577,18 +863,22 @@ fn parse_acquisition_settings_list(xml: &[u8]) -> Vec<AcquisitionSettings> {
     out
 }
 
-fn parse_run_header(xml: &[u8]) -> Option<Run> {
-    let b = find_section(xml, b"run")?;
-    let gt = mc_memchr(b'>', b).unwrap_or(0);
-    let head = &b[..gt];
+fn parse_run_header(run: &[u8]) -> Option<Run> {
+    if !run.starts_with(b"<run") {
+        return None;
+    }
+    let gt = mc_memchr(b'>', run).unwrap_or(0);
+    let head = &run[..gt];
     let id = b2s(find_attr_value_in_tag(head, b"id")).unwrap_or_default();
     let start_time_stamp = b2s(find_attr_value_in_tag(head, b"startTimeStamp"));
     let def_icr = b2s(find_attr_value_in_tag(
         head,
         b"defaultInstrumentConfigurationRef",
     ));
-    let spectrum_list_count = find_attr_usize(b, b"spectrumList", b"count");
-    let chromatogram_list_count = find_attr_usize(b, b"chromatogramList", b"count");
+    let spectrum_list_count = find_attr_usize(run, b"spectrumList", b"count");
+    let after_spectra = memmem::rfind(run, b"</spectrumList>").unwrap_or(0);
+    let chromatogram_list_count =
+        find_attr_usize(&run[after_spectra..], b"chromatogramList", b"count");
     Some(Run {
         id,
         start_time_stamp,
@@ -658,48 +948,84 @@ fn parse_offsets_from_index(hay: &[u8], name: &[u8]) -> Vec<IndexOffset> {
     out
 }
 
-fn parse_spectra_internal(bytes: &[u8]) -> Result<Vec<SpectrumSummary>, String> {
-    let file_len = bytes.len() as u64;
+fn parse_spectra_internal(
+    bytes: &[u8],
+    cores: usize,
+    lazy: bool,
+    keep_f32: bool,
+    filter: &ParseFilter,
+) -> Result<Vec<SpectrumSummary>, String> {
     let mut cursor = Cursor::new(bytes);
-    let mut scratch = Scratch {
-        b64_buf: Vec::with_capacity(256),
-        zlib_buf: Vec::with_capacity(256),
-    };
+    let mut scratch = Scratch::with_f32(keep_f32);
     if let Some(offsets) = read_spectrum_offsets(&mut cursor)? {
-        if file_len <= 1_073_741_824 {
-            let all = bytes;
-            let mut out = Vec::with_capacity(offsets.len());
-            for i in 0..offsets.len() {
-                let start = offsets[i] as usize;
-                let end = if i + 1 < offsets.len() {
-                    offsets[i + 1] as usize
-                } else {
-                    find_spectrum_end_in(all, start)
-                        .ok_or_else(|| "no </spectrum> after last offset".to_string())?
-                };
-                if let Some(sum) = parse_spectrum_block(&all[start..end], &mut scratch) {
-                    out.push(sum);
-                }
+        if cores > 1 && offsets.len() > 1 {
+            if let Some(out) =
+                parse_spectra_parallel(bytes, &offsets, cores, lazy, keep_f32, filter)?
+            {
+                return Ok(out);
             }
-            return Ok(out);
-        } else {
-            let mut out = Vec::with_capacity(offsets.len());
-            for i in 0..offsets.len() {
-                let start = offsets[i];
-                let next = if i + 1 < offsets.len() {
-                    Some(offsets[i + 1])
-                } else {
-                    None
-                };
-                if let Some(sum) = read_one_spectrum_span(&mut cursor, start, next, &mut scratch)? {
-                    out.push(sum);
-                }
+        }
+        let spans = spectrum_spans(bytes, &offsets)?;
+        let mut out = Vec::with_capacity(spans.len());
+        for (start, end) in spans {
+            if let Some(sum) =
+                parse_spectrum_block_at(&bytes[start..end], start, lazy, filter, &mut scratch)
+            {
+                out.push(sum);
             }
-            return Ok(out);
         }
+        return Ok(out);
     }
-    cursor.set_position(0);
-    linear_scan_spectra(&mut cursor, &mut scratch)
+    linear_scan_spectra(bytes, lazy, filter, &mut scratch)
+}
+
+fn spectrum_spans(all: &[u8], offsets: &[u64]) -> Result<Vec<(usize, usize)>, String> {
+    let mut spans = Vec::with_capacity(offsets.len());
+    for i in 0..offsets.len() {
+        let start = offsets[i] as usize;
+        if start > all.len() {
+            return Err(format!("spectrum offset {start} past end of file"));
+        }
+        let end = if i + 1 < offsets.len() {
+            offsets[i + 1] as usize
+        } else {
+            find_spectrum_end_in(all, start)
+                .ok_or_else(|| "no </spectrum> after last offset".to_string())?
+        };
+        if end < start || end > all.len() {
+            return Err(format!("bad spectrum span {start}..{end}"));
+        }
+        spans.push((start, end));
+    }
+    Ok(spans)
+}
+
+fn parse_spectra_parallel(
+    all: &[u8],
+    offsets: &[u64],
+    cores: usize,
+    lazy: bool,
+    keep_f32: bool,
+    filter: &ParseFilter,
+) -> Result<Option<Vec<SpectrumSummary>>, String> {
+    let Some(pool) = thread_pool() else {
+        return Ok(None);
+    };
+    let spans = spectrum_spans(all, offsets)?;
+    let parsed: Vec<Option<SpectrumSummary>> = pool.install(|| {
+        spans
+            .par_iter()
+            .with_cores(cores)
+            .with_min_len(16)
+            .map_init(
+                || Scratch::with_f32(keep_f32),
+                |scratch, &(start, end)| {
+                    parse_spectrum_block_at(&all[start..end], start, lazy, filter, scratch)
+                },
+            )
+            .collect()
+    });
+    Ok(Some(parsed.into_iter().flatten().collect()))
 }
 
 fn extract_index_list_offset(tail: &[u8]) -> Option<u64> {
@@ -742,66 +1068,17 @@ fn parse_spectrum_offsets_from_index(buf: &[u8]) -> Vec<u64> {
     out
 }
 
-fn read_one_spectrum_span<R: Read + Seek>(
-    r: &mut R,
-    start: u64,
-    next: Option<u64>,
-    scratch: &mut Scratch,
-) -> Result<Option<SpectrumSummary>, String> {
-    r.seek(SeekFrom::Start(start))
-        .map_err(|e| format!("seek: {e}"))?;
-    if let Some(end) = next {
-        let len = (end - start) as usize;
-        let mut buf = vec![0u8; len];
-        r.read_exact(&mut buf)
-            .map_err(|e| format!("read span: {e}"))?;
-        if let Some(pos) = memmem::find(&buf, b"</spectrum>") {
-            buf.truncate(pos + b"</spectrum>".len());
-        }
-        Ok(parse_spectrum_block(&buf, scratch))
-    } else {
-        let mut buf = Vec::with_capacity(128 * 1024);
-        let mut tmp = [0u8; 128 * 1024];
-        let close = b"</spectrum>";
-        let close_f = memmem::Finder::new(close);
-        let mut search_from = 0usize;
-        loop {
-            let n = r
-                .read(&mut tmp)
-                .map_err(|e| format!("read tail spectrum: {e}"))?;
-            if n == 0 {
-                break;
-            }
-            buf.extend_from_slice(&tmp[..n]);
-            let window_start = search_from.saturating_sub(close.len().saturating_sub(1));
-            if let Some(rel) = close_f.find(&buf[window_start..]) {
-                let end = window_start + rel + close.len();
-                buf.truncate(end);
-                break;
-            }
-            search_from = buf.len();
-            if buf.len() > 32 * 1024 * 1024 {
-                return Err("spectrum block too large?".into());
-            }
-        }
-        Ok(parse_spectrum_block(&buf, scratch))
-    }
-}
-
 fn find_spectrum_end_in(hay: &[u8], start: usize) -> Option<usize> {
     let rel = memmem::find(&hay[start..], b"</spectrum>")?;
     Some(start + rel + b"</spectrum>".len())
 }
 
-fn linear_scan_spectra<R: Read + Seek>(
-    r: &mut R,
+fn linear_scan_spectra(
+    file: &[u8],
+    lazy: bool,
+    filter: &ParseFilter,
     scratch: &mut Scratch,
 ) -> Result<Vec<SpectrumSummary>, String> {
-    r.seek(SeekFrom::Start(0))
-        .map_err(|e| format!("seek: {e}"))?;
-    let mut file = Vec::new();
-    r.read_to_end(&mut file)
-        .map_err(|e| format!("read all: {e}"))?;
     let mut out = Vec::new();
     let mut cur = 0usize;
     let open_tag = b"<spectrum ";
@@ -814,7 +1091,8 @@ fn linear_scan_spectra<R: Read + Seek>(
             .find(&file[start..])
             .ok_or_else(|| "unterminated <spectrum>".to_string())?;
         let end = start + end_rel + close_tag.len();
-        if let Some(sum) = parse_spectrum_block(&file[start..end], scratch) {
+        if let Some(sum) = parse_spectrum_block_at(&file[start..end], start, lazy, filter, scratch)
+        {
             out.push(sum);
         }
         cur = end;
@@ -864,9 +1142,17 @@ fn parse_precursor_from_header(header: &[u8]) -> Option<Precursor> {
     }
 }
 
-fn parse_spectrum_block(block: &[u8], scratch: &mut Scratch) -> Option<SpectrumSummary> {
-    let index = find_attr_usize(block, b"spectrum", b"index").unwrap_or(0);
-    let array_len = find_attr_usize(block, b"spectrum", b"defaultArrayLength").unwrap_or(0);
+pub(crate) fn parse_spectrum_block(block: &[u8], scratch: &mut Scratch) -> Option<SpectrumSummary> {
+    parse_spectrum_block_at(block, 0, false, &ParseFilter::ALL, scratch)
+}
+
+fn parse_spectrum_block_at(
+    block: &[u8],
+    base: usize,
+    lazy: bool,
+    filter: &ParseFilter,
+    scratch: &mut Scratch,
+) -> Option<SpectrumSummary> {
     let header_end = memmem::find(block, b"<binaryDataArrayList").unwrap_or(block.len());
     let header = &block[..header_end];
     let ms_level = find_cv_value_u8(header, b"ms level");
@@ -877,6 +1163,12 @@ fn parse_spectrum_block(block: &[u8], scratch: &mut Scratch) -> Option<SpectrumS
     } else {
         None
     };
+    let retention_time = find_scan_start_time_min(header);
+    if !filter.accepts(ms_level, retention_time, polarity) {
+        return None;
+    }
+    let index = find_attr_usize(block, b"spectrum", b"index").unwrap_or(0);
+    let array_len = find_attr_usize(block, b"spectrum", b"defaultArrayLength").unwrap_or(0);
     let spectrum_type = if has_cv_name(header, b"profile spectrum") {
         Some(0)
     } else if has_cv_name(header, b"centroid spectrum") {
@@ -887,40 +1179,11 @@ fn parse_spectrum_block(block: &[u8], scratch: &mut Scratch) -> Option<SpectrumS
     let total_ion_current = find_cv_value_f64(header, b"total ion current");
     let base_peak_intensity = find_cv_value_f64(header, b"base peak intensity");
     let base_peak_mz = find_cv_value_f64(header, b"base peak m/z");
-    let retention_time = find_scan_start_time_min(header);
     let scan_window_lower_limit = find_cv_value_f64(header, b"scan window lower limit");
     let scan_window_upper_limit = find_cv_value_f64(header, b"scan window upper limit");
     let precursor = parse_precursor_from_header(header);
-    let (mz_array_opt, intensity_array_opt) = decode_binary_arrays(block, array_len, scratch);
-
-    let mut tic_out = total_ion_current;
-    let mut bpi_out = base_peak_intensity;
-    let mut bpmz_out = base_peak_mz;
-
-    if tic_out.is_none() || bpi_out.is_none() || bpmz_out.is_none() {
-        if let (Some(mz), Some(inten)) = (&mz_array_opt, &intensity_array_opt) {
-            let mut tic_val: f64 = 0.0;
-            let mut bpi_val: f64 = 0.0;
-            let mut bpmz_val: f64 = 0.0;
-            for (mzv, &intv) in mz.iter().zip(inten.iter()) {
-                tic_val += intv;
-                if intv > bpi_val {
-                    bpi_val = intv;
-                    bpmz_val = *mzv;
-                }
-            }
-            if tic_out.is_none() {
-                tic_out = Some(tic_val);
-            }
-            if bpi_out.is_none() {
-                bpi_out = Some(bpi_val);
-            }
-            if bpmz_out.is_none() {
-                bpmz_out = Some(bpmz_val);
-            }
-        }
-    }
-    Some(SpectrumSummary {
+
+    let mut sum = SpectrumSummary {
         index,
         array_length: array_len,
         ms_level,
@@ -929,13 +1192,128 @@ fn parse_spectrum_block(block: &[u8], scratch: &mut Scratch) -> Option<SpectrumS
         retention_time,
         scan_window_lower_limit,
         scan_window_upper_limit,
-        total_ion_current: tic_out,
-        base_peak_intensity: bpi_out,
-        base_peak_mz: bpmz_out,
-        mz_array: mz_array_opt,
-        intensity_array: intensity_array_opt,
+        total_ion_current,
+        base_peak_intensity,
+        base_peak_mz,
+        mz_array: None,
+        intensity_array: None,
+        intensity_array_f32: None,
         precursor,
+        array_spans: None,
+    };
+    if lazy {
+        let mut spans = spectrum_array_spans(block, base);
+        filter.project(&mut spans);
+        sum.array_spans = Some(spans);
+    } else {
+        let mut spans = spectrum_array_spans(block, 0);
+        filter.project(&mut spans);
+        decode_spectrum_spans(block, &spans, &mut sum, scratch);
+    }
+    Some(sum)
+}
+
+fn decode_spectrum_spans(
+    hay: &[u8],
+    spans: &SpectrumArraySpans,
+    sum: &mut SpectrumSummary,
+    scratch: &mut Scratch,
+) {
+    let len = sum.array_length;
+    sum.mz_array = decode_first_good(hay, spans, true, |s| decode_array(hay, s, len, scratch));
+    (sum.intensity_array, sum.intensity_array_f32) = decode_first_good(hay, spans, false, |s| {
+        if keeps_f32(s, scratch) {
+            decode_array_f32(hay, s, len, scratch).map(|v| (None, Some(v)))
+        } else {
+            decode_array(hay, s, len, scratch).map(|v| (Some(v), None))
+        }
     })
+    .unwrap_or((None, None));
+
+    if sum.total_ion_current.is_none()
+        || sum.base_peak_intensity.is_none()
+        || sum.base_peak_mz.is_none()
+    {
+        let peaks = match (
+            &sum.mz_array,
+            &sum.intensity_array,
+            &sum.intensity_array_f32,
+        ) {
+            (Some(mz), Some(inten), _) => Some(tic_and_base_peak(mz, inten)),
+            (Some(mz), None, Some(inten)) => Some(tic_and_base_peak(mz, inten)),
+            _ => None,
+        };
+        if let Some((tic_val, bpi_val, bpmz_val)) = peaks {
+            if sum.total_ion_current.is_none() {
+                sum.total_ion_current = Some(tic_val);
+            }
+            if sum.base_peak_intensity.is_none() {
+                sum.base_peak_intensity = Some(bpi_val);
+            }
+            if sum.base_peak_mz.is_none() {
+                sum.base_peak_mz = Some(bpmz_val);
+            }
+        }
+    }
+}
+
+fn tic_and_base_peak<T: Copy + Into<f64>>(mz: &[f64], inten: &[T]) -> (f64, f64, f64) {
+    let mut tic_val: f64 = 0.0;
+    let mut bpi_val: f64 = 0.0;
+    let mut bpmz_val: f64 = 0.0;
+    for (mzv, &intv) in mz.iter().zip(inten.iter()) {
+        let intv: f64 = intv.into();
+        tic_val += intv;
+        if intv > bpi_val {
+            bpi_val = intv;
+            bpmz_val = *mzv;
+        }
+    }
+    (tic_val, bpi_val, bpmz_val)
+}
+
+pub fn load_spectrum(bytes: &[u8], sum: &mut SpectrumSummary) -> bool {
+    load_spectrum_with(bytes, sum, &mut Scratch::new())
+}
+
+fn load_spectrum_with(bytes: &[u8], sum: &mut SpectrumSummary, scratch: &mut Scratch) -> bool {
+    let spans = match sum.array_spans {
+        Some(s) => s,
+        None => {
+            return sum.mz_array.is_some()
+                || sum.intensity_array.is_some()
+                || sum.intensity_array_f32.is_some();
+        }
+    };
+    let in_bounds =
+        |s: &Option<BinaryArraySpan>| s.map_or(true, |s| s.start <= s.end && s.end <= bytes.len());
+    if !in_bounds(&spans.mz) || !in_bounds(&spans.intensity) {
+        return false;
+    }
+    decode_spectrum_spans(bytes, &spans, sum, scratch);
+    true
+}
+
+pub fn load_spectra(bytes: &[u8], spectra: &mut [SpectrumSummary], cores: usize) -> usize {
+    if cores > 1 && spectra.len() > 1 {
+        if let Some(pool) = thread_pool() {
+            return pool.install(|| {
+                spectra
+                    .par_iter_mut()
+                    .with_cores(cores)
+                    .with_min_len(16)
+                    .map_init(Scratch::new, |scratch, s| {
+                        load_spectrum_with(bytes, s, scratch) as usize
+                    })
+                    .sum()
+            });
+        }
+    }
+    let mut scratch = Scratch::new();
+    spectra
+        .iter_mut()
+        .map(|s| load_spectrum_with(bytes, s, &mut scratch) as usize)
+        .sum()
 }
 
 fn has_cv_name(buf: &[u8], name: &[u8]) -> bool {
@@ -1008,7 +1386,7 @@ fn find_scan_start_time_min(buf: &[u8]) -> Option<f64> {
     None
 }
 
-fn bda_flags(b: &[u8]) -> (bool, bool, bool, bool, bool, bool) {
+fn bda_flags(b: &[u8]) -> (bool, bool, bool, bool, bool, bool, u8) {
     let stop = memmem::find(b, b"<binary>").unwrap_or(b.len());
     let head = &b[..stop];
     let mut kind_mz = false;
@@ -1017,6 +1395,7 @@ fn bda_flags(b: &[u8]) -> (bool, bool, bool, bool, bool, bool) {
     let mut is_f64 = false;
     let mut is_f32 = false;
     let mut little = true;
+    let mut numpress = numpress::NONE;
     let mut cur = 0usize;
     let f = memmem::Finder::new(b"<cvParam");
     while let Some(p) = f.find(&head[cur..]) {
@@ -1033,7 +1412,12 @@ fn bda_flags(b: &[u8]) -> (bool, bool, bool, bool, bool, bool) {
                     b"32-bit float" => is_f32 = true,
                     b"little endian" => little = true,
                     b"big endian" => little = false,
-                    _ => {}
+                    _ => {
+                        if let Some((np, z)) = numpress_kind(nm) {
+                            numpress = np;
+                            is_zlib |= z;
+                        }
+                    }
                 }
             }
             cur = gt + 1;
@@ -1041,17 +1425,40 @@ fn bda_flags(b: &[u8]) -> (bool, bool, bool, bool, bool, bool) {
             break;
         }
     }
-    (kind_mz, kind_int, is_zlib, is_f64, is_f32, little)
+    (kind_mz, kind_int, is_zlib, is_f64, is_f32, little, numpress)
 }
 
-fn decode_binary_arrays(
-    block: &[u8],
-    expected_len: usize,
-    scratch: &mut Scratch,
-) -> (Option<Vec<f64>>, Option<Vec<f64>>) {
-    let mut mz: Option<Vec<f64>> = None;
-    let mut inten: Option<Vec<f64>> = None;
+fn numpress_kind(name: &[u8]) -> Option<(u8, bool)> {
+    let rest = name.strip_prefix(b"MS-Numpress ")?;
+    let (rest, zlib) = match rest.strip_suffix(b" followed by zlib compression") {
+        Some(r) => (r, true),
+        None => (rest, false),
+    };
+    let kind = match rest {
+        b"linear prediction compression" => numpress::LINEAR,
+        b"positive integer compression" => numpress::PIC,
+        b"short logged float compression" => numpress::SLOF,
+        _ => return None,
+    };
+    Some((kind, zlib))
+}
+
+fn spectrum_array_spans(block: &[u8], base: usize) -> SpectrumArraySpans {
+    let mut spans = SpectrumArraySpans {
+        block: (base, base + block.len()),
+        ..SpectrumArraySpans::default()
+    };
+    for_each_array_span(block, base, |is_mz, span| {
+        if is_mz {
+            spans.mz = Some(span);
+        } else {
+            spans.intensity = Some(span);
+        }
+    });
+    spans
+}
 
+fn for_each_array_span(block: &[u8], base: usize, mut f: impl FnMut(bool, BinaryArraySpan)) {
     let mut cur = 0usize;
     let bda_open = memmem::Finder::new(b"<binaryDataArray");
     let bda_close = b"</binaryDataArray>";
@@ -1065,73 +1472,282 @@ fn decode_binary_arrays(
         };
         let b = &block[start..start + end_rel];
 
-        let (kind_mz, kind_int, is_zlib, is_f64, is_f32, little) = bda_flags(b);
+        let (kind_mz, kind_int, is_zlib, is_f64, is_f32, little, numpress) = bda_flags(b);
 
         if let Some((bs, be)) = tag_body(b, b"<binary>", b"</binary>") {
-            strip_b64_ws_into(&b[bs..be], &mut scratch.zlib_buf);
-            let cap = (scratch.zlib_buf.len() / 4) * 3 + 3;
-            scratch.b64_buf.resize(cap, 0);
-            let written = match STANDARD.decode_slice(&scratch.zlib_buf, &mut scratch.b64_buf) {
-                Ok(n) => n,
-                Err(_) => {
-                    cur = start + end_rel + bda_close.len();
-                    continue;
-                }
-            };
-            scratch.b64_buf.truncate(written);
-
-            let bytes: &[u8] = if is_zlib {
-                scratch.zlib_buf.clear();
-                match decompress_to_vec_zlib(&scratch.b64_buf) {
-                    Ok(v) => {
-                        scratch.zlib_buf = v;
-                        &scratch.zlib_buf
-                    }
-                    Err(_) => {
-                        cur = start + end_rel + bda_close.len();
-                        continue;
-                    }
-                }
-            } else {
-                &scratch.b64_buf
+            let span = |bits: u8| BinaryArraySpan {
+                start: base + start + bs,
+                end: base + start + be,
+                zlib: is_zlib,
+                bits,
+                little,
+                numpress,
             };
-
-            let want = if expected_len > 0 {
-                expected_len
-            } else if is_f64 {
-                bytes.len() / 8
-            } else {
-                bytes.len() / 4
-            };
-
+            let f64_bits = if is_f64 { 64 } else { 0 };
+            let f32_bits = if is_f32 { 32 } else { 0 };
             if kind_mz {
-                let vals = if is_f64 {
-                    bytes_to_f64_exact_into(bytes, little, want)
-                } else if is_f32 {
-                    bytes_to_f32_as_f64_exact_into(bytes, little, want)
-                } else {
-                    Vec::new()
-                };
-                mz = Some(vals);
+                f(true, span(if is_f64 { 64 } else { f32_bits }));
             } else if kind_int {
-                let vals = if is_f32 {
-                    bytes_to_f32_as_f64_exact_into(bytes, little, want)
-                } else if is_f64 {
-                    bytes_to_f64_exact_into(bytes, little, want)
-                } else {
-                    Vec::new()
-                };
-                inten = Some(vals);
+                f(false, span(if is_f32 { 32 } else { f64_bits }));
             }
         }
 
         cur = start + end_rel + bda_close.len();
     }
+}
 
-    (mz, inten)
+fn decode_first_good<T>(
+    hay: &[u8],
+    spans: &SpectrumArraySpans,
+    mz: bool,
+    mut decode: impl FnMut(&BinaryArraySpan) -> Option<T>,
+) -> Option<T> {
+    let last = if mz { spans.mz } else { spans.intensity }?;
+    if let Some(v) = decode(&last) {
+        return Some(v);
+    }
+    let (start, end) = spans.block;
+    let block = hay.get(start..end)?;
+    let mut earlier = Vec::new();
+    for_each_array_span(block, start, |is_mz, span| {
+        if is_mz == mz && span.start < last.start {
+            earlier.push(span);
+        }
+    });
+    earlier.iter().rev().find_map(decode)
 }
 
-fn bda_flags_chrom(b: &[u8]) -> (bool, bool, bool, bool, bool, bool) {
+fn decode_array(
+    hay: &[u8],
+    span: &BinaryArraySpan,
+    expected_len: usize,
+    scratch: &mut Scratch,
+) -> Option<Vec<f64>> {
+    b64::decode_into(&hay[span.start..span.end], &mut scratch.b64_buf).ok()?;
+
+    #[cfg(target_endian = "little")]
+    if span.zlib
+        && span.numpress == numpress::NONE
+        && span.bits == 64
+        && span.little
+        && expected_len > 0
+    {
+        if let Some(vals) = inflate_in_place(&mut scratch.inflater, &scratch.b64_buf, expected_len)
+        {
+            return Some(vals);
+        }
+    }
+
+    let bytes: &[u8] = if span.zlib {
+        let hint = if span.numpress == numpress::NONE {
+            expected_len * (span.bits as usize / 8)
+        } else {
+            0
+        };
+        inflate_into(
+            &mut scratch.inflater,
+            &scratch.b64_buf,
+            &mut scratch.zlib_buf,
+            hint,
+        )?;
+        &scratch.zlib_buf
+    } else {
+        &scratch.b64_buf
+    };
+
+    if span.numpress != numpress::NONE {
+        let mut out = Vec::with_capacity(expected_len);
+        numpress::decode_into(span.numpress, bytes, &mut out).ok()?;
+        return Some(out);
+    }
+
+    let want = if expected_len > 0 {
+        expected_len
+    } else if span.bits == 64 {
+        bytes.len() / 8
+    } else {
+        bytes.len() / 4
+    };
+
+    Some(match span.bits {
+        64 => bytes_to_f64_exact_into(bytes, span.little, want),
+        32 => bytes_to_f32_as_f64_exact_into(bytes, span.little, want),
+        _ => Vec::new(),
+    })
+}
+
+const INFLATE_FLAGS: u32 = TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF;
+
+fn inflate_into(
+    state: &mut DecompressorOxide,
+    mut input: &[u8],
+    out: &mut Vec<u8>,
+    hint: usize,
+) -> Option<()> {
+    state.init();
+    let start = if hint > 0 { hint } else { input.len() * 4 };
+    out.clear();
+    out.resize(start.max(64), 0);
+    let mut pos = 0usize;
+    loop {
+        let (status, used, written) = decompress(state, input, out, pos, INFLATE_FLAGS);
+        pos += written;
+        match status {
+            TINFLStatus::Done => {
+                out.truncate(pos);
+                return Some(());
+            }
+            TINFLStatus::HasMoreOutput => {
+                input = input.get(used..)?;
+                let grown = out.len() * 2;
+                out.resize(grown, 0);
+            }
+            _ => return None,
+        }
+    }
+}
+
+#[cfg(target_endian = "little")]
+fn inflate_in_place<T: Copy + Default>(
+    state: &mut DecompressorOxide,
+    input: &[u8],
+    want: usize,
+) -> Option<Vec<T>> {
+    let width = std::mem::size_of::<T>();
+    state.init();
+    let mut vals = vec![T::default(); want];
+    let out = unsafe { std::slice::from_raw_parts_mut(vals.as_mut_ptr() as *mut u8, want * width) };
+    let (status, _, written) = decompress(state, input, out, 0, INFLATE_FLAGS);
+    match status {
+        TINFLStatus::Done => {
+            vals.truncate(written / width);
+            Some(vals)
+        }
+        _ => None,
+    }
+}
+
+pub(crate) fn decode_array_to(
+    hay: &[u8],
+    span: &BinaryArraySpan,
+    narrow: bool,
+    dst: &mut [u8],
+    scratch: &mut Scratch,
+) -> Option<usize> {
+    let width = if narrow { 4 } else { 8 };
+    let want = dst.len() / width;
+    b64::decode_into(&hay[span.start..span.end], &mut scratch.b64_buf).ok()?;
+
+    #[cfg(target_endian = "little")]
+    if span.zlib
+        && span.numpress == numpress::NONE
+        && span.little
+        && span.bits as usize == width * 8
+    {
+        scratch.inflater.init();
+        let (status, _, written) = decompress(
+            &mut scratch.inflater,
+            &scratch.b64_buf,
+            &mut dst[..want * width],
+            0,
+            INFLATE_FLAGS,
+        );
+        return match status {
+            TINFLStatus::Done => Some(written / width),
+            _ => None,
+        };
+    }
+
+    let bytes: &[u8] = if span.zlib {
+        inflate_into(
+            &mut scratch.inflater,
+            &scratch.b64_buf,
+            &mut scratch.zlib_buf,
+            want * (span.bits as usize / 8),
+        )?;
+        &scratch.zlib_buf
+    } else {
+        &scratch.b64_buf
+    };
+
+    if span.numpress != numpress::NONE {
+        let mut vals = Vec::with_capacity(want);
+        numpress::decode_into(span.numpress, bytes, &mut vals).ok()?;
+        if vals.len() > want {
+            return None;
+        }
+        for (c, v) in dst.chunks_exact_mut(8).zip(&vals) {
+            c.copy_from_slice(&v.to_le_bytes());
+        }
+        return Some(vals.len());
+    }
+
+    let src_width = span.bits as usize / 8;
+    if src_width != 4 && src_width != 8 {
+        return None;
+    }
+    let n = want.min(bytes.len() / src_width);
+    let src = &bytes[..n * src_width];
+    if src_width == width && span.little {
+        dst[..n * width].copy_from_slice(src);
+        return Some(n);
+    }
+    for (c, d) in src.chunks_exact(src_width).zip(dst.chunks_exact_mut(width)) {
+        let v = match (src_width, span.little) {
+            (8, true) => f64::from_le_bytes(c.try_into().ok()?),
+            (8, false) => f64::from_be_bytes(c.try_into().ok()?),
+            (_, true) => f32::from_le_bytes(c.try_into().ok()?) as f64,
+            (_, false) => f32::from_be_bytes(c.try_into().ok()?) as f64,
+        };
+        if narrow {
+            d.copy_from_slice(&(v as f32).to_le_bytes());
+        } else {
+            d.copy_from_slice(&v.to_le_bytes());
+        }
+    }
+    Some(n)
+}
+
+fn keeps_f32(span: &BinaryArraySpan, scratch: &Scratch) -> bool {
+    scratch.keep_f32 && span.bits == 32 && span.numpress == numpress::NONE
+}
+
+fn decode_array_f32(
+    hay: &[u8],
+    span: &BinaryArraySpan,
+    expected_len: usize,
+    scratch: &mut Scratch,
+) -> Option<Vec<f32>> {
+    b64::decode_into(&hay[span.start..span.end], &mut scratch.b64_buf).ok()?;
+
+    #[cfg(target_endian = "little")]
+    if span.zlib && span.little && expected_len > 0 {
+        if let Some(vals) = inflate_in_place(&mut scratch.inflater, &scratch.b64_buf, expected_len)
+        {
+            return Some(vals);
+        }
+    }
+
+    let bytes: &[u8] = if span.zlib {
+        inflate_into(
+            &mut scratch.inflater,
+            &scratch.b64_buf,
+            &mut scratch.zlib_buf,
+            expected_len * 4,
+        )?;
+        &scratch.zlib_buf
+    } else {
+        &scratch.b64_buf
+    };
+    let want = if expected_len > 0 {
+        expected_len
+    } else {
+        bytes.len() / 4
+    };
+    Some(bytes_to_f32_exact_into(bytes, span.little, want))
+}
+
+fn bda_flags_chrom(b: &[u8]) -> (bool, bool, bool, bool, bool, bool, u8) {
     let stop = memmem::find(b, b"<binary>").unwrap_or(b.len());
     let head = &b[..stop];
     let mut kind_time = false;
@@ -1140,6 +1756,7 @@ fn bda_flags_chrom(b: &[u8]) -> (bool, bool, bool, bool, bool, bool) {
     let mut is_f64 = false;
     let mut is_f32 = false;
     let mut little = true;
+    let mut numpress = numpress::NONE;
     let mut cur = 0usize;
     let f = memmem::Finder::new(b"<cvParam");
     while let Some(p) = f.find(&head[cur..]) {
@@ -1156,7 +1773,12 @@ fn bda_flags_chrom(b: &[u8]) -> (bool, bool, bool, bool, bool, bool) {
                     b"32-bit float" => is_f32 = true,
                     b"little endian" => little = true,
                     b"big endian" => little = false,
-                    _ => {}
+                    _ => {
+                        if let Some((np, z)) = numpress_kind(nm) {
+                            numpress = np;
+                            is_zlib |= z;
+                        }
+                    }
                 }
             }
             cur = gt + 1;
@@ -1164,16 +1786,19 @@ fn bda_flags_chrom(b: &[u8]) -> (bool, bool, bool, bool, bool, bool) {
             break;
         }
     }
-    (kind_time, kind_int, is_zlib, is_f64, is_f32, little)
+    (
+        kind_time, kind_int, is_zlib, is_f64, is_f32, little, numpress,
+    )
 }
 
 fn decode_chrom_binary_arrays(
     block: &[u8],
     expected_len: usize,
     scratch: &mut Scratch,
-) -> (Option<Vec<f64>>, Option<Vec<f64>>) {
+) -> (Option<Vec<f64>>, Option<Vec<f64>>, Option<Vec<f32>>) {
     let mut time_arr: Option<Vec<f64>> = None;
     let mut intensity_arr: Option<Vec<f64>> = None;
+    let mut intensity_f32: Option<Vec<f32>> = None;
 
     let mut cur = 0usize;
     let bda_open = memmem::Finder::new(b"<binaryDataArray");
@@ -1188,77 +1813,107 @@ fn decode_chrom_binary_arrays(
         };
         let b = &block[start..start + end_rel];
 
-        let (kind_time, kind_int, is_zlib, is_f64, is_f32, little) = bda_flags_chrom(b);
+        let (kind_time, kind_int, is_zlib, is_f64, is_f32, little, numpress) = bda_flags_chrom(b);
 
         if let Some((bs, be)) = tag_body(b, b"<binary>", b"</binary>") {
-            strip_b64_ws_into(&b[bs..be], &mut scratch.zlib_buf);
-            let cap = (scratch.zlib_buf.len() / 4) * 3 + 3;
-            scratch.b64_buf.resize(cap, 0);
-            let written = match STANDARD.decode_slice(&scratch.zlib_buf, &mut scratch.b64_buf) {
-                Ok(n) => n,
-                Err(_) => {
-                    cur = start + end_rel + bda_close.len();
-                    continue;
-                }
+            let span = |bits: u8| BinaryArraySpan {
+                start: start + bs,
+                end: start + be,
+                zlib: is_zlib,
+                bits,
+                little,
+                numpress,
             };
-            scratch.b64_buf.truncate(written);
-
-            let bytes: &[u8] = if is_zlib {
-                scratch.zlib_buf.clear();
-                match decompress_to_vec_zlib(&scratch.b64_buf) {
-                    Ok(v) => {
-                        scratch.zlib_buf = v;
-                        &scratch.zlib_buf
-                    }
-                    Err(_) => {
-                        cur = start + end_rel + bda_close.len();
-                        continue;
-                    }
-                }
-            } else {
-                &scratch.b64_buf
-            };
-
-            let want = if expected_len > 0 {
-                expected_len
-            } else if is_f64 {
-                bytes.len() / 8
-            } else {
-                bytes.len() / 4
-            };
-
+            let f64_bits = if is_f64 { 64 } else { 0 };
+            let f32_bits = if is_f32 { 32 } else { 0 };
             if kind_time {
-                let vals = if is_f64 {
-                    bytes_to_f64_exact_into(bytes, little, want)
-                } else if is_f32 {
-                    bytes_to_f32_as_f64_exact_into(bytes, little, want)
-                } else {
-                    Vec::new()
-                };
-                time_arr = Some(vals);
+                let s = span(if is_f64 { 64 } else { f32_bits });
+                if let Some(v) = decode_array(block, &s, expected_len, scratch) {
+                    time_arr = Some(v);
+                }
             } else if kind_int {
-                let vals = if is_f32 {
-                    bytes_to_f32_as_f64_exact_into(bytes, little, want)
-                } else if is_f64 {
-                    bytes_to_f64_exact_into(bytes, little, want)
-                } else {
-                    Vec::new()
-                };
-                intensity_arr = Some(vals);
+                let s = span(if is_f32 { 32 } else { f64_bits });
+                if keeps_f32(&s, scratch) {
+                    if let Some(v) = decode_array_f32(block, &s, expected_len, scratch) {
+                        intensity_arr = None;
+                        intensity_f32 = Some(v);
+                    }
+                } else if let Some(v) = decode_array(block, &s, expected_len, scratch) {
+                    intensity_arr = Some(v);
+                    intensity_f32 = None;
+                }
             }
         }
 
         cur = start + end_rel + bda_close.len();
     }
 
-    (time_arr, intensity_arr)
+    (time_arr, intensity_arr, intensity_f32)
 }
 
-fn parse_chromatograms_linear(xml: &[u8]) -> Result<Vec<ChromatogramSummary>, String> {
-    let mut scratch = Scratch {
-        b64_buf: Vec::with_capacity(256),
-        zlib_buf: Vec::with_capacity(256),
+fn parse_chromatograms_internal(
+    bytes: &[u8],
+    index_tail: &[u8],
+    cores: usize,
+    keep_f32: bool,
+) -> Result<Vec<ChromatogramSummary>, String> {
+    let offsets = parse_offsets_from_index(index_tail, b"chromatogram");
+    let spans = match chromatogram_spans(bytes, &offsets) {
+        Some(spans) => spans,
+        None => return parse_chromatograms_linear(bytes, keep_f32),
     };
+    if cores > 1 && spans.len() > 1 {
+        if let Some(pool) = thread_pool() {
+            let parsed: Vec<Option<ChromatogramSummary>> = pool.install(|| {
+                spans
+                    .par_iter()
+                    .with_cores(cores)
+                    .with_min_len(4)
+                    .map_init(
+                        || Scratch::with_f32(keep_f32),
+                        |scratch, &(start, end)| {
+                            parse_chromatogram_block(&bytes[start..end], scratch)
+                        },
+                    )
+                    .collect()
+            });
+            return Ok(parsed.into_iter().flatten().collect());
+        }
+    }
+    let mut scratch = Scratch::with_f32(keep_f32);
+    Ok(spans
+        .into_iter()
+        .filter_map(|(start, end)| parse_chromatogram_block(&bytes[start..end], &mut scratch))
+        .collect())
+}
+
+fn chromatogram_spans(all: &[u8], offsets: &[IndexOffset]) -> Option<Vec<(usize, usize)>> {
+    if offsets.is_empty() {
+        return None;
+    }
+    const CLOSE: &[u8] = b"</chromatogram>";
+    let cf = memmem::Finder::new(CLOSE);
+    let mut spans = Vec::with_capacity(offsets.len());
+    for (i, o) in offsets.iter().enumerate() {
+        let start = usize::try_from(o.offset).ok()?;
+        if !all.get(start..)?.starts_with(b"<chromatogram ") {
+            return None;
+        }
+        let limit = match offsets.get(i + 1) {
+            Some(next) => usize::try_from(next.offset).ok()?.clamp(start, all.len()),
+            None => all.len(),
+        };
+        let end = start + cf.find(&all[start..limit])? + CLOSE.len();
+        spans.push((start, end));
+    }
+    Some(spans)
+}
+
+fn parse_chromatograms_linear(
+    xml: &[u8],
+    keep_f32: bool,
+) -> Result<Vec<ChromatogramSummary>, String> {
+    let mut scratch = Scratch::with_f32(keep_f32);
     let mut out = Vec::new();
     let mut cur = 0usize;
     const OPEN: &[u8] = b"<chromatogram ";
@@ -1282,16 +1937,21 @@ fn parse_chromatograms_linear(xml: &[u8]) -> Result<Vec<ChromatogramSummary>, St
     Ok(out)
 }
 
-fn parse_chromatogram_block(block: &[u8], scratch: &mut Scratch) -> Option<ChromatogramSummary> {
+pub(crate) fn parse_chromatogram_block(
+    block: &[u8],
+    scratch: &mut Scratch,
+) -> Option<ChromatogramSummary> {
     let index = find_attr_usize(block, b"chromatogram", b"index").unwrap_or(0);
     let array_length = find_attr_usize(block, b"chromatogram", b"defaultArrayLength").unwrap_or(0);
-    let (time_array, intensity_array) = decode_chrom_binary_arrays(block, array_length, scratch);
+    let (time_array, intensity_array, intensity_array_f32) =
+        decode_chrom_binary_arrays(block, array_length, scratch);
     let id = find_attr_string(block, b"chromatogram", b"id").unwrap_or_default();
     Some(ChromatogramSummary {
         index,
         array_length,
         time_array,
         intensity_array,
+        intensity_array_f32,
         id,
     })
 }
@@ -1356,15 +2016,6 @@ fn find_attr_value_in_tag<'a>(head: &'a [u8], attr: &[u8]) -> Option<&'a [u8]> {
     Some(&rest[..end])
 }
 
-fn strip_b64_ws_into(src: &[u8], dst: &mut Vec<u8>) {
-    dst.clear();
-    dst.extend(
-        src.iter()
-            .copied()
-            .filter(|b| !matches!(b, b' ' | b'\n' | b'\r' | b'\t')),
-    );
-}
-
 fn tag_body(hay: &[u8], open: &[u8], close: &[u8]) -> Option<(usize, usize)> {
     let s = memmem::find(hay, open)?;
     let e_rel = memmem::find(&hay[s + open.len()..], close)?;
@@ -1393,6 +2044,20 @@ fn bytes_to_f64_exact_into(b: &[u8], little: bool, want: usize) -> Vec<f64> {
     out
 }
 
+fn bytes_to_f32_exact_into(b: &[u8], little: bool, want: usize) -> Vec<f32> {
+    let len = want.min(b.len() / 4);
+    let mut out = Vec::with_capacity(len);
+    for c in b[..len * 4].chunks_exact(4) {
+        let bits = if little {
+            u32::from_le_bytes([c[0], c[1], c[2], c[3]])
+        } else {
+            u32::from_be_bytes([c[0], c[1], c[2], c[3]])
+        };
+        out.push(f32::from_bits(bits));
+    }
+    out
+}
+
 fn bytes_to_f32_as_f64_exact_into(b: &[u8], little: bool, want: usize) -> Vec<f64> {
     let len = want.min(b.len() / 4);
     let mut out = Vec::with_capacity(len);
@@ -0,0 +1,240 @@
+use memchr::memmem::Finder;
+use std::io::{Read, Seek, SeekFrom, Write};
+
+use crate::utilities::parse::{
+    encode::{
+        BIN1_CHROM_META, BIN1_HEADER, BIN1_INDEX, BIN1_SPEC_META, FMT_F64, put_chrom_meta,
+        put_header, put_index_entry, put_spectrum_meta,
+    },
+    helper::set_u64_at,
+    parse_mzml::{Scratch, parse_chromatogram_block, parse_spectrum_block},
+};
+
+pub const DEFAULT_WINDOW: usize = 64 * 1024 * 1024;
+
+#[derive(Debug, Clone, Copy)]
+pub struct StreamStats {
+    pub spectra: usize,
+    pub chromatograms: usize,
+    pub bytes_written: u64,
+}
+
+struct BlockReader<R: Read> {
+    r: R,
+    buf: Vec<u8>,
+    pos: usize,
+    eof: bool,
+    window: usize,
+}
+
+impl<R: Read> BlockReader<R> {
+    fn fill(&mut self) -> Result<bool, String> {
+        if self.eof {
+            return Ok(false);
+        }
+        if self.pos > 0 {
+            self.buf.drain(..self.pos);
+            self.pos = 0;
+        }
+        let old = self.buf.len();
+        self.buf.resize(old + self.window, 0);
+        let mut filled = old;
+        while filled < self.buf.len() {
+            let n = self
+                .r
+                .read(&mut self.buf[filled..])
+                .map_err(|e| format!("read: {e}"))?;
+            if n == 0 {
+                self.eof = true;
+                break;
+            }
+            filled += n;
+        }
+        self.buf.truncate(filled);
+        Ok(filled > old)
+    }
+
+    fn next_block(
+        &mut self,
+        open: &Finder,
+        close: &Finder,
+        stop: Option<&Finder>,
+    ) -> Result<Option<(usize, usize)>, String> {
+        loop {
+            if let Some(p) = open.find(&self.buf[self.pos..]) {
+                let start = self.pos + p;
+                if let Some(q) = close.find(&self.buf[start..]) {
+                    let end = start + q + close.needle().len();
+                    self.pos = end;
+                    return Ok(Some((start, end)));
+                }
+                self.pos = start;
+                if !self.fill()? {
+                    return Err("unterminated block at end of input".into());
+                }
+                continue;
+            }
+            if let Some(stop) = stop {
+                if let Some(p) = stop.find(&self.buf[self.pos..]) {
+                    self.pos += p;
+                    return Ok(None);
+                }
+            }
+            let keep = open
+                .needle()
+                .len()
+                .max(stop.map_or(0, |f| f.needle().len()));
+            self.pos = self.pos.max(self.buf.len().saturating_sub(keep));
+            if !self.fill()? {
+                return Ok(None);
+            }
+        }
+    }
+}
+
+struct Bin1Writer<W: Write + Seek> {
+    w: W,
+    pos: u64,
+}
+
+impl<W: Write + Seek> Bin1Writer<W> {
+    fn align8(&mut self) -> Result<(), String> {
+        let pad = (8 - (self.pos & 7) as usize) & 7;
+        if pad > 0 {
+            self.write(&[0u8; 8][..pad])?;
+        }
+        Ok(())
+    }
+
+    fn write(&mut self, b: &[u8]) -> Result<(), String> {
+        self.w.write_all(b).map_err(|e| format!("write: {e}"))?;
+        self.pos += b.len() as u64;
+        Ok(())
+    }
+
+    fn write_f64s(&mut self, v: Option<&Vec<f64>>) -> Result<(u64, u32), String> {
+        let v = match v {
+            Some(v) if !v.is_empty() => v,
+            _ => return Ok((0, 0)),
+        };
+        self.align8()?;
+        let off = self.pos;
+        #[cfg(target_endian = "little")]
+        {
+            let b = unsafe { std::slice::from_raw_parts(v.as_ptr() as *const u8, v.len() * 8) };
+            self.write(b)?;
+        }
+        #[cfg(not(target_endian = "little"))]
+        {
+            let mut b = Vec::with_capacity(v.len() * 8);
+            for x in v {
+                b.extend_from_slice(&x.to_le_bytes());
+            }
+            self.write(&b)?;
+        }
+        Ok((off, v.len() as u32))
+    }
+
+    fn write_table(&mut self, t: &[u8], n: usize) -> Result<u64, String> {
+        if n == 0 {
+            return Ok(0);
+        }
+        self.align8()?;
+        let off = self.pos;
+        self.write(t)?;
+        Ok(off)
+    }
+}
+
+pub fn convert_mzml_to_bin1<R: Read, W: Write + Seek>(
+    input: R,
+    output: W,
+    window: usize,
+) -> Result<StreamStats, String> {
+    let mut rd = BlockReader {
+        r: input,
+        buf: Vec::new(),
+        pos: 0,
+        eof: false,
+        window: if window > 0 { window } else { DEFAULT_WINDOW },
+    };
+    let mut wr = Bin1Writer { w: output, pos: 0 };
+    wr.write(&[0u8; BIN1_HEADER])?;
+
+    let mut scratch = Scratch::new();
+    let mut spec_idx: Vec<u8> = Vec::new();
+    let mut spec_meta: Vec<u8> = Vec::new();
+    let mut n_spec = 0usize;
+
+    let spec_open = Finder::new(b"<spectrum ");
+    let spec_close = Finder::new(b"</spectrum>");
+    let chrom_list = Finder::new(b"<chromatogramList");
+    while let Some((s, e)) = rd.next_block(&spec_open, &spec_close, Some(&chrom_list))? {
+        let Some(sum) = parse_spectrum_block(&rd.buf[s..e], &mut scratch) else {
+            continue;
+        };
+        let x = wr.write_f64s(sum.mz_array.as_ref())?;
+        let y = wr.write_f64s(sum.intensity_array.as_ref())?;
+        spec_idx.resize(spec_idx.len() + BIN1_INDEX, 0);
+        put_index_entry(&mut spec_idx, n_spec * BIN1_INDEX, x, y);
+        spec_meta.resize(spec_meta.len() + BIN1_SPEC_META, 0);
+        put_spectrum_meta(&mut spec_meta, n_spec * BIN1_SPEC_META, &sum);
+        n_spec += 1;
+    }
+
+    let mut chrom_idx: Vec<u8> = Vec::new();
+    let mut chrom_meta: Vec<u8> = Vec::new();
+    let mut n_ch = 0usize;
+
+    let chrom_open = Finder::new(b"<chromatogram ");
+    let chrom_close = Finder::new(b"</chromatogram>");
+    while let Some((s, e)) = rd.next_block(&chrom_open, &chrom_close, None)? {
+        let Some(ch) = parse_chromatogram_block(&rd.buf[s..e], &mut scratch) else {
+            continue;
+        };
+        let x = wr.write_f64s(ch.time_array.as_ref())?;
+        let y = wr.write_f64s(ch.intensity_array.as_ref())?;
+        let id = if ch.id.is_empty() {
+            (0, 0)
+        } else {
+            wr.align8()?;
+            let off = wr.pos;
+            wr.write(ch.id.as_bytes())?;
+            (off, ch.id.len() as u32)
+        };
+        chrom_idx.resize(chrom_idx.len() + BIN1_INDEX, 0);
+        put_index_entry(&mut chrom_idx, n_ch * BIN1_INDEX, x, y);
+        chrom_meta.resize(chrom_meta.len() + BIN1_CHROM_META, 0);
+        put_chrom_meta(&mut chrom_meta, n_ch * BIN1_CHROM_META, &ch, id);
+        n_ch += 1;
+    }
+
+    if n_spec > u32::MAX as usize || n_ch > u32::MAX as usize {
+        return Err("too many spectra for BIN1".into());
+    }
+
+    let spec_index_off = wr.write_table(&spec_idx, n_spec)?;
+    let chrom_index_off = wr.write_table(&chrom_idx, n_ch)?;
+    let spec_meta_off = wr.write_table(&spec_meta, n_spec)?;
+    let chrom_meta_off = wr.write_table(&chrom_meta, n_ch)?;
+    let total = wr.pos;
+
+    let mut header = [0u8; BIN1_HEADER];
+    put_header(&mut header, n_spec as u32, n_ch as u32, FMT_F64, FMT_F64);
+    set_u64_at(&mut header, 16, spec_index_off);
+    set_u64_at(&mut header, 24, chrom_index_off);
+    set_u64_at(&mut header, 32, spec_meta_off);
+    set_u64_at(&mut header, 40, chrom_meta_off);
+    set_u64_at(&mut header, 48, BIN1_HEADER as u64);
+    set_u64_at(&mut header, 56, total);
+    wr.w.seek(SeekFrom::Start(0))
+        .map_err(|e| format!("seek: {e}"))?;
+    wr.w.write_all(&header).map_err(|e| format!("write: {e}"))?;
+    wr.w.flush().map_err(|e| format!("flush: {e}"))?;
+
+    Ok(StreamStats {
+        spectra: n_spec,
+        chromatograms: n_ch,
+        bytes_written: total,
+    })
+}
@@ -0,0 +1,83 @@
+use std::sync::Arc;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+
+const REPORT_STEPS: usize = 100;
+
+#[derive(Clone, Default)]
+pub struct Progress {
+    report: Option<Arc<dyn Fn(f64, &str) + Send + Sync>>,
+    cancel: Option<Arc<dyn Fn() -> bool + Send + Sync>>,
+    stopped: Arc<AtomicBool>,
+}
+
+impl Progress {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn with_report(mut self, report: impl Fn(f64, &str) + Send + Sync + 'static) -> Self {
+        self.report = Some(Arc::new(report));
+        self
+    }
+
+    pub fn with_cancel(mut self, cancel: impl Fn() -> bool + Send + Sync + 'static) -> Self {
+        self.cancel = Some(Arc::new(cancel));
+        self
+    }
+
+    pub fn cancel(&self) {
+        self.stopped.store(true, Ordering::Relaxed);
+    }
+
+    pub fn cancelled(&self) -> bool {
+        if self.stopped.load(Ordering::Relaxed) {
+            return true;
+        }
+        if self.cancel.as_ref().is_some_and(|c| c()) {
+            self.stopped.store(true, Ordering::Relaxed);
+            return true;
+        }
+        false
+    }
+
+    pub fn report(&self, fraction: f64, stage: &str) {
+        if let Some(r) = &self.report {
+            r(fraction.clamp(0.0, 1.0), stage);
+        }
+    }
+
+    pub fn stage<'a>(&'a self, name: &'a str, total: usize) -> Stage<'a> {
+        self.report(0.0, name);
+        Stage {
+            progress: self,
+            name,
+            total: total.max(1),
+            step: (total / REPORT_STEPS).max(1),
+            done: AtomicUsize::new(0),
+        }
+    }
+}
+
+pub struct Stage<'a> {
+    progress: &'a Progress,
+    name: &'a str,
+    total: usize,
+    step: usize,
+    done: AtomicUsize,
+}
+
+impl Stage<'_> {
+    pub fn tick(&self, n: usize) -> bool {
+        let before = self.done.fetch_add(n, Ordering::Relaxed);
+        let after = (before + n).min(self.total);
+        if before < self.total && (after / self.step != before / self.step || after == self.total) {
+            self.progress
+                .report(after as f64 / self.total as f64, self.name);
+        }
+        !self.progress.cancelled()
+    }
+
+    pub fn live(&self) -> bool {
+        !self.progress.cancelled()
+    }
+}
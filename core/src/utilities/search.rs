@@ -0,0 +1,50 @@
+const SKIP_STRIDE: usize = 64;
+
+#[inline]
+pub fn partition(a: &[f64], before: impl Fn(f64) -> bool) -> usize {
+    let mut size = a.len();
+    if size == 0 {
+        return 0;
+    }
+    let mut base = 0usize;
+    while size > 1 {
+        let half = size / 2;
+        base += before(a[base + half]) as usize * half;
+        size -= half;
+    }
+    base + before(a[base]) as usize
+}
+
+#[derive(Clone, Debug)]
+pub struct SkipTable {
+    keys: Vec<f64>,
+}
+
+impl SkipTable {
+    pub fn new(a: &[f64]) -> Self {
+        Self {
+            keys: a.iter().step_by(SKIP_STRIDE).copied().collect(),
+        }
+    }
+
+    #[inline]
+    pub fn partition(&self, a: &[f64], before: impl Fn(f64) -> bool) -> usize {
+        let b = partition(&self.keys, &before);
+        if b == 0 {
+            return 0;
+        }
+        let lo = (b - 1) * SKIP_STRIDE + 1;
+        let hi = (b * SKIP_STRIDE).min(a.len());
+        lo + partition(&a[lo..hi], before)
+    }
+
+    #[inline]
+    pub fn lower_bound(&self, a: &[f64], x: f64) -> usize {
+        self.partition(a, |v| v < x)
+    }
+
+    #[inline]
+    pub fn upper_bound(&self, a: &[f64], x: f64) -> usize {
+        self.partition(a, |v| v <= x)
+    }
+}
@@ -0,0 +1,142 @@
+use std::borrow::Cow;
+
+use crate::utilities::{
+    calculate_eic::{
+        CentroidScan, Eic, EicOptions, calculate_eics_from_scans, collect_ms1_scans_from_view,
+        compute_eic_for_mz_tiled, lower_bound, upper_bound,
+    },
+    find_peaks::FindPeaksOptions,
+    get_peaks_from_chrom::get_peaks_from_traces,
+    get_peaks_from_eic::get_peaks_from_scans,
+    parse::bin1_view::Bin1View,
+    progress::Progress,
+    structs::{ChromRoi, EicRoi, FromTo, Peak},
+    tile_index::TileIndex,
+};
+
+struct Trace {
+    index: usize,
+    id: String,
+    time: Vec<f64>,
+    intensity: Vec<f64>,
+}
+
+pub struct Session {
+    rts: Vec<f64>,
+    scans: Vec<CentroidScan<'static>>,
+    tiles: TileIndex,
+    chromatograms: Vec<Trace>,
+}
+
+impl Session {
+    pub fn open(bin: &[u8]) -> Result<Self, String> {
+        let view = Bin1View::new(bin)?;
+        let all = FromTo {
+            from: f64::NEG_INFINITY,
+            to: f64::INFINITY,
+        };
+        let (rts, scans) = collect_ms1_scans_from_view(&view, all);
+        let scans: Vec<_> = scans
+            .into_iter()
+            .map(|s| {
+                let mut s = s.into_owned();
+                s.index_intensities();
+                s.index_search();
+                s
+            })
+            .collect();
+        let tiles = TileIndex::new(&scans);
+        let chromatograms = (0..view.chromatogram_count())
+            .map(|i| {
+                let (time, intensity) =
+                    match (view.chromatogram_time(i), view.chromatogram_intensity(i)) {
+                        (Some(t), Some(ints)) => (t.into_owned(), ints.into_f64().into_owned()),
+                        _ => (Vec::new(), Vec::new()),
+                    };
+                Trace {
+                    index: view.chromatogram_index(i),
+                    id: view.chromatogram_id(i).to_string(),
+                    time,
+                    intensity,
+                }
+            })
+            .collect();
+        Ok(Self {
+            rts,
+            scans,
+            tiles,
+            chromatograms,
+        })
+    }
+
+    pub fn scan_count(&self) -> usize {
+        self.scans.len()
+    }
+
+    pub fn tiles(&self) -> &TileIndex {
+        &self.tiles
+    }
+
+    pub fn chromatogram_count(&self) -> usize {
+        self.chromatograms.len()
+    }
+
+    pub fn chromatogram_id(&self, i: usize) -> Option<&str> {
+        self.chromatograms.get(i).map(|c| c.id.as_str())
+    }
+
+    pub fn calculate_eic(
+        &self,
+        target_mass: &f64,
+        from_to: FromTo,
+        options: EicOptions,
+    ) -> Result<Eic, &'static str> {
+        let i0 = lower_bound(&self.rts, from_to.from);
+        let i1 = upper_bound(&self.rts, from_to.to).max(i0);
+        Ok(Eic {
+            x: self.rts[i0..i1].to_vec(),
+            y: compute_eic_for_mz_tiled(&self.tiles, &self.scans, i0..i1, target_mass, options),
+        })
+    }
+
+    pub fn calculate_eics(&self, targets: &[f64], options: &[EicOptions], from_to: FromTo) -> Eic {
+        calculate_eics_from_scans(&self.rts, &self.scans, targets, options, from_to)
+    }
+
+    pub fn get_peaks_from_eic(
+        &self,
+        from_to: FromTo,
+        rois: &[EicRoi],
+        options: Option<FindPeaksOptions>,
+        cores: usize,
+        progress: &Progress,
+    ) -> Option<Vec<(String, f64, f64, Peak)>> {
+        get_peaks_from_scans(
+            &self.rts,
+            &self.scans,
+            from_to,
+            rois,
+            options,
+            cores,
+            progress,
+        )
+    }
+
+    pub fn get_peaks_from_chrom(
+        &self,
+        items: &[ChromRoi],
+        options: Option<FindPeaksOptions>,
+        cores: usize,
+    ) -> Option<Vec<(usize, String, f64, f64, f64, f64, f64, f64)>> {
+        let trace = |i: usize| {
+            let c = &self.chromatograms[i];
+            (
+                c.index,
+                c.id.as_str(),
+                Cow::Borrowed(&c.time[..]),
+                Cow::Borrowed(&c.intensity[..]),
+            )
+        };
+        get_peaks_from_traces(self.chromatograms.len(), trace, items, options, cores)
+    }
+}
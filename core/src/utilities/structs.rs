@@ -76,6 +76,7 @@ pub struct EicRoi {
     pub rt: f64,
     pub mz: f64,
     pub window: f64,
+    pub from_to: Option<FromTo>,
 }
 
 impl EicRoi {
@@ -85,6 +86,12 @@ impl EicRoi {
             rt,
             mz,
             window,
+            from_to: None,
         }
     }
+
+    pub fn with_from_to(mut self, from_to: FromTo) -> Self {
+        self.from_to = Some(from_to);
+        self
+    }
 }
@@ -0,0 +1,94 @@
+use std::sync::{Arc, Mutex};
+
+use rayon::{
+    ThreadPool, ThreadPoolBuilder,
+    iter::{IndexedParallelIterator, MinLen},
+};
+
+struct Pool {
+    threads: usize,
+    cpus: Vec<usize>,
+    pool: Option<Arc<ThreadPool>>,
+}
+
+impl Pool {
+    fn size(&self) -> usize {
+        if self.threads > 0 {
+            self.threads
+        } else {
+            std::thread::available_parallelism().map_or(1, |n| n.get())
+        }
+    }
+}
+
+static POOL: Mutex<Pool> = Mutex::new(Pool {
+    threads: 0,
+    cpus: Vec::new(),
+    pool: None,
+});
+
+pub fn set_threads(threads: usize, cpus: &[usize]) {
+    let mut pool = POOL.lock().unwrap_or_else(|e| e.into_inner());
+    pool.threads = threads;
+    pool.cpus = cpus.to_vec();
+    pool.pool = None;
+}
+
+pub fn thread_pool() -> Option<Arc<ThreadPool>> {
+    let mut pool = POOL.lock().unwrap_or_else(|e| e.into_inner());
+    if let Some(p) = &pool.pool {
+        return Some(p.clone());
+    }
+    let cpus = pool.cpus.clone();
+    let p = ThreadPoolBuilder::new()
+        .num_threads(pool.size())
+        .thread_name(|i| format!("msut-{}", i))
+        .start_handler(move |i| {
+            if !cpus.is_empty() {
+                pin_to_cpu(cpus[i % cpus.len()]);
+            }
+        })
+        .build()
+        .ok()
+        .map(Arc::new)?;
+    pool.pool = Some(p.clone());
+    Some(p)
+}
+
+pub fn in_pool<R: Send>(cores: usize, work: impl FnOnce() -> R + Send) -> R {
+    if cores <= 1 {
+        return work();
+    }
+    match thread_pool() {
+        Some(pool) => pool.install(work),
+        None => work(),
+    }
+}
+
+pub trait WithCores: IndexedParallelIterator {
+    fn with_cores(self, cores: usize) -> MinLen<Self> {
+        let len = self.len();
+        self.with_min_len(len.div_ceil(cores.max(1)).max(1))
+    }
+}
+
+impl<I: IndexedParallelIterator> WithCores for I {}
+
+#[cfg(target_os = "linux")]
+fn pin_to_cpu(cpu: usize) {
+    const SET_WORDS: usize = 16;
+    unsafe extern "C" {
+        fn sched_setaffinity(pid: i32, size: usize, mask: *const u64) -> i32;
+    }
+    if cpu >= SET_WORDS * 64 {
+        return;
+    }
+    let mut mask = [0u64; SET_WORDS];
+    mask[cpu / 64] |= 1 << (cpu % 64);
+    unsafe {
+        sched_setaffinity(0, size_of_val(&mask), mask.as_ptr());
+    }
+}
+
+#[cfg(not(target_os = "linux"))]
+fn pin_to_cpu(_cpu: usize) {}
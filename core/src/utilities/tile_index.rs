@@ -0,0 +1,187 @@
+use std::ops::Range;
+
+use crate::utilities::calculate_eic::CentroidScan;
+
+const RT_BLOCK: usize = 32;
+const MZ_WIDTH: f64 = 1.0;
+const MAX_MZ_BLOCKS: usize = 1 << 16;
+
+pub struct TileIndex {
+    rt_block: usize,
+    mz_min: f64,
+    mz_width: f64,
+    n_mz: usize,
+    n_scans: usize,
+    bounds: Vec<u32>,
+    max: Vec<f64>,
+}
+
+impl TileIndex {
+    pub fn new(scans: &[CentroidScan]) -> Self {
+        Self::with_tiles(scans, RT_BLOCK, MZ_WIDTH)
+    }
+
+    pub fn with_tiles(scans: &[CentroidScan], rt_block: usize, mz_width: f64) -> Self {
+        let rt_block = rt_block.max(1);
+        let mut mz_width = if mz_width.is_finite() && mz_width > 0.0 {
+            mz_width
+        } else {
+            MZ_WIDTH
+        };
+        let (mz_min, mz_max) = scans
+            .iter()
+            .filter_map(|s| Some((*s.mz.first()?, *s.mz.last()?)))
+            .fold((f64::INFINITY, f64::NEG_INFINITY), |(a, b), (lo, hi)| {
+                (a.min(lo), b.max(hi))
+            });
+        let mut index = Self {
+            rt_block,
+            mz_min,
+            mz_width,
+            n_mz: 0,
+            n_scans: scans.len(),
+            bounds: Vec::new(),
+            max: Vec::new(),
+        };
+        if mz_min > mz_max {
+            return index;
+        }
+        let points: usize = scans.iter().map(|s| s.mz.len()).sum();
+        let cap = (points / scans.len()).clamp(1, MAX_MZ_BLOCKS);
+        let span = mz_max - mz_min;
+        if span / mz_width >= cap as f64 {
+            mz_width = span / cap as f64;
+        }
+        index.mz_width = mz_width;
+        index.n_mz = ((span / mz_width).floor().min(cap as f64 - 1.0) as usize) + 1;
+
+        let n_mz = index.n_mz;
+        let mut bounds = vec![0u32; scans.len() * (n_mz + 1)];
+        let mut max = vec![f64::NEG_INFINITY; scans.len().div_ceil(rt_block) * n_mz];
+        for (i, s) in scans.iter().enumerate() {
+            let row = &mut bounds[i * (n_mz + 1)..(i + 1) * (n_mz + 1)];
+            let tiles = &mut max[(i / rt_block) * n_mz..(i / rt_block + 1) * n_mz];
+            let mut b = 0;
+            for (j, &m) in s.mz.iter().enumerate() {
+                let mb = index.mz_block(m);
+                while b < mb {
+                    b += 1;
+                    row[b] = j as u32;
+                }
+                tiles[mb] = tiles[mb].max(s.intensity.get(j));
+            }
+            row[b + 1..].fill(s.mz.len() as u32);
+        }
+        index.bounds = bounds;
+        index.max = max;
+        index
+    }
+
+    pub fn scan_count(&self) -> usize {
+        self.n_scans
+    }
+
+    #[inline]
+    fn mz_block(&self, m: f64) -> usize {
+        let b = ((m - self.mz_min) / self.mz_width).floor().max(0.0) as usize;
+        b.min(self.n_mz - 1)
+    }
+
+    #[inline]
+    fn window(
+        &self,
+        scan: &CentroidScan,
+        s: usize,
+        b: (usize, usize),
+        lo: f64,
+        hi: f64,
+    ) -> Range<usize> {
+        let row = &self.bounds[s * (self.n_mz + 1)..];
+        let (from, to) = (row[b.0] as usize, row[b.1 + 1] as usize);
+        let mz = &scan.mz[from..to];
+        let k = mz.partition_point(|&m| m < lo);
+        let n = mz[k..].partition_point(|&m| m <= hi);
+        from + k..from + k + n
+    }
+
+    fn blocks(
+        &self,
+        lo: f64,
+        hi: f64,
+        scans: &Range<usize>,
+    ) -> Option<(usize, usize, Range<usize>)> {
+        let end = scans.end.min(self.n_scans);
+        (self.n_mz > 0 && lo <= hi && scans.start < end)
+            .then(|| (self.mz_block(lo), self.mz_block(hi), scans.start..end))
+    }
+
+    fn for_each_window(
+        &self,
+        data: &[CentroidScan],
+        lo: f64,
+        hi: f64,
+        scans: &Range<usize>,
+        mut f: impl FnMut(usize, f64),
+    ) {
+        let Some((b0, b1, live)) = self.blocks(lo, hi, scans) else {
+            return;
+        };
+        let mut i = live.start;
+        while i < live.end {
+            let r = i / self.rt_block;
+            let next = ((r + 1) * self.rt_block).min(live.end);
+            let tiles = &self.max[r * self.n_mz + b0..=r * self.n_mz + b1];
+            if tiles.iter().any(|&m| m > f64::NEG_INFINITY) {
+                for s in i..next {
+                    let w = self.window(&data[s], s, (b0, b1), lo, hi);
+                    if !w.is_empty() {
+                        f(s, data[s].range_sum(w));
+                    }
+                }
+            }
+            i = next;
+        }
+    }
+
+    pub fn eic(&self, data: &[CentroidScan], lo: f64, hi: f64, scans: Range<usize>) -> Vec<f64> {
+        let mut y = vec![0.0f64; scans.len()];
+        self.for_each_window(data, lo, hi, &scans, |s, v| y[s - scans.start] = v);
+        y
+    }
+
+    pub fn sum(&self, data: &[CentroidScan], lo: f64, hi: f64, scans: Range<usize>) -> f64 {
+        let mut acc = 0.0f64;
+        self.for_each_window(data, lo, hi, &scans, |_, v| acc += v);
+        acc
+    }
+
+    pub fn max_intensity(
+        &self,
+        data: &[CentroidScan],
+        lo: f64,
+        hi: f64,
+        scans: Range<usize>,
+    ) -> Option<f64> {
+        let (b0, b1, live) = self.blocks(lo, hi, &scans)?;
+        let mut best: Option<f64> = None;
+        for r in live.start / self.rt_block..=(live.end - 1) / self.rt_block {
+            let first = (r * self.rt_block).max(live.start);
+            let last = ((r + 1) * self.rt_block).min(live.end);
+            for b in b0..=b1 {
+                let t = self.max[r * self.n_mz + b];
+                if t == f64::NEG_INFINITY || best.is_some_and(|v| t <= v) {
+                    continue;
+                }
+                for s in first..last {
+                    for j in self.window(&data[s], s, (b, b), lo, hi) {
+                        let v = data[s].intensity.get(j);
+                        if best.is_none_or(|b| v > b) {
+                            best = Some(v);
+                        }
+                    }
+                }
+            }
+        }
+        best
+    }
+}
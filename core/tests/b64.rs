@@ -0,0 +1,69 @@
+use base64::Engine;
+use base64::engine::general_purpose::STANDARD;
+use msut::utilities::parse::b64::decode_into;
+
+fn bytes(n: usize, seed: u32) -> Vec<u8> {
+    let mut x = seed.wrapping_mul(2654435761).wrapping_add(1);
+    (0..n)
+        .map(|_| {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            x as u8
+        })
+        .collect()
+}
+
+fn wrap(s: &str, every: usize, ws: &str) -> String {
+    let mut out = String::with_capacity(s.len() * 2);
+    for (i, c) in s.chars().enumerate() {
+        if i > 0 && i % every == 0 {
+            out.push_str(ws);
+        }
+        out.push(c);
+    }
+    out
+}
+
+#[test]
+fn matches_reference_for_all_lengths() {
+    let mut out = Vec::new();
+    for n in 0..300 {
+        let raw = bytes(n, n as u32);
+        let text = STANDARD.encode(&raw);
+        let written = decode_into(text.as_bytes(), &mut out).unwrap();
+        assert_eq!(written, n);
+        assert_eq!(out, raw, "length {n}");
+    }
+}
+
+#[test]
+fn skips_embedded_whitespace() {
+    let mut out = Vec::new();
+    let raw = bytes(4096, 7);
+    let text = STANDARD.encode(&raw);
+    for (every, ws) in [
+        (76, "\n"),
+        (64, "\r\n"),
+        (1, " "),
+        (33, "\t \n"),
+        (17, "  "),
+    ] {
+        let wrapped = format!("\n    {}\n  ", wrap(&text, every, ws));
+        decode_into(wrapped.as_bytes(), &mut out).unwrap();
+        assert_eq!(out, raw, "every={every}");
+    }
+}
+
+#[test]
+fn rejects_invalid_characters() {
+    let mut out = Vec::new();
+    let text = STANDARD.encode(bytes(200, 3));
+    for pos in [0, 5, 40, 100, 180] {
+        let mut bad = text.clone().into_bytes();
+        bad[pos] = b'*';
+        assert!(decode_into(&bad, &mut out).is_err(), "pos {pos}");
+    }
+    assert!(decode_into(b"QUJD=QUJD", &mut out).is_err());
+    assert!(decode_into(b"QUJDR", &mut out).is_err());
+}
@@ -0,0 +1,47 @@
+mod common;
+
+use common::f32_intensity_mzml;
+use msut::utilities::parse::bin1_view::Bin1View;
+use msut::utilities::parse::decode::decode_native;
+use msut::utilities::parse::encode;
+use msut::utilities::parse::parse_mzml::parse_mzml_native;
+
+#[test]
+fn bin1_view_matches_decode() {
+    let xml = f32_intensity_mzml(40, 64);
+    let bin = encode(&parse_mzml_native(xml.as_bytes(), true, 1).unwrap());
+    let kept = decode_native(&bin).unwrap();
+    let run = kept.run.as_ref().unwrap();
+
+    let mut shifted = vec![0u8; bin.len() + 1];
+    shifted[1..].copy_from_slice(&bin);
+    for bytes in [&bin[..], &shifted[1..]] {
+        let view = Bin1View::new(bytes).unwrap();
+        assert_eq!(view.spectrum_count(), run.spectra.len());
+        assert_eq!(view.chromatogram_count(), run.chromatograms.len());
+        for (i, s) in run.spectra.iter().enumerate() {
+            assert_eq!(view.ms_level(i), s.ms_level);
+            assert_eq!(view.retention_time(i), s.retention_time);
+            assert_eq!(view.spectrum_mz(i).as_deref(), s.mz_array.as_deref());
+            let ints = view.spectrum_intensity(i).unwrap().into_f64();
+            let want: Vec<f64> = s
+                .intensity_array_f32
+                .as_ref()
+                .unwrap()
+                .iter()
+                .map(|&v| v as f64)
+                .collect();
+            assert_eq!(&*ints, &want[..]);
+        }
+        for (i, c) in run.chromatograms.iter().enumerate() {
+            assert_eq!(view.chromatogram_id(i), c.id);
+            assert_eq!(
+                view.chromatogram_time(i).as_deref(),
+                c.time_array.as_deref()
+            );
+        }
+    }
+
+    assert!(Bin1View::new(&bin[..40]).is_err());
+    assert!(Bin1View::new(&bin[..bin.len() - 8]).is_err());
+}
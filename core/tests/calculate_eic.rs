@@ -0,0 +1,125 @@
+mod common;
+
+use common::f32_intensity_mzml;
+use msut::utilities::calculate_eic::{
+    CentroidScan, EicOptions, EicSweep, calculate_eic_from_bin1, calculate_eics_from_bin1,
+    collect_ms1_scans, compute_eic_for_mz, compute_eics_for_mzs, eic_window,
+};
+use msut::utilities::parse::encode;
+use msut::utilities::parse::mzml_to_bin1::parse_mzml_to_bin1;
+use msut::utilities::parse::parse_mzml::parse_mzml_native;
+use msut::utilities::structs::FromTo;
+
+#[test]
+fn batched_eics_match_single_target_kernel() {
+    let xml = f32_intensity_mzml(60, 256);
+    let bin = encode(&parse_mzml_native(xml.as_bytes(), true, 1).unwrap());
+    let window = FromTo { from: 0.4, to: 2.6 };
+    let targets = [181.0, 150.0, 150.2, 149.0, 190.3, 150.25, 400.0, 163.75];
+    let options: Vec<EicOptions> = (0..targets.len())
+        .map(|t| EicOptions {
+            ppm_tolerance: 5.0 * t as f64,
+            mz_tolerance: 0.05 + 0.2 * (t % 3) as f64,
+        })
+        .collect();
+
+    let eics = calculate_eics_from_bin1(&bin, &targets, &options, window).unwrap();
+    let n = eics.x.len();
+    assert_eq!(eics.y.len(), targets.len() * n);
+    for (t, target) in targets.iter().enumerate() {
+        let one = calculate_eic_from_bin1(&bin, target, window, options[t], 1).unwrap();
+        assert_eq!(one.x, eics.x);
+        assert_eq!(one.y, eics.y[t * n..(t + 1) * n]);
+    }
+
+    let shared = calculate_eics_from_bin1(&bin, &targets, &options[..1], window).unwrap();
+    for (t, target) in targets.iter().enumerate() {
+        let one = calculate_eic_from_bin1(&bin, target, window, options[0], 1).unwrap();
+        assert_eq!(one.y, shared.y[t * n..(t + 1) * n]);
+    }
+}
+
+#[test]
+fn prefix_sum_index_matches_point_sums() {
+    let xml = f32_intensity_mzml(30, 512);
+    let mzml = parse_mzml_native(xml.as_bytes(), true, 1).unwrap();
+    let window = FromTo {
+        from: 0.0,
+        to: 10.0,
+    };
+    let (rts, plain) = collect_ms1_scans(&mzml, window);
+    let mut indexed = plain.clone();
+    indexed.iter_mut().for_each(CentroidScan::index_intensities);
+
+    let wide = EicOptions {
+        ppm_tolerance: 2000.0,
+        mz_tolerance: 0.0,
+    };
+    let targets = [150.0, 175.25, 200.0, 260.0, 300.0, 500.0];
+    let windows: Vec<(f64, f64)> = targets.iter().map(|m| eic_window(m, wide)).collect();
+    let batched = compute_eics_for_mzs(&indexed, &windows);
+    for (t, target) in targets.iter().enumerate() {
+        let a = compute_eic_for_mz(&plain, rts.len(), target, wide);
+        let b = compute_eic_for_mz(&indexed, rts.len(), target, wide);
+        let c = &batched[t * rts.len()..(t + 1) * rts.len()];
+        for ((x, y), z) in a.iter().zip(&b).zip(c) {
+            assert!((x - y).abs() <= 1e-9 * x.abs().max(1.0));
+            assert_eq!(y, z);
+        }
+    }
+}
+
+#[test]
+fn parallel_eic_matches_serial() {
+    let xml = f32_intensity_mzml(700, 32);
+    let bin = parse_mzml_to_bin1(xml.as_bytes(), 1).unwrap();
+    let window = FromTo { from: 0.0, to: 1e6 };
+    for target in [150.0, 160.5, 181.0] {
+        let one = calculate_eic_from_bin1(&bin, &target, window, EicOptions::default(), 1).unwrap();
+        let par = calculate_eic_from_bin1(&bin, &target, window, EicOptions::default(), 4).unwrap();
+        assert_eq!(one.x.len(), 700);
+        assert_eq!(one.x, par.x);
+        assert_eq!(one.y, par.y);
+    }
+}
+
+#[test]
+fn sweep_matches_batched_kernel() {
+    let xml = f32_intensity_mzml(30, 256);
+    let mzml = parse_mzml_native(xml.as_bytes(), true, 1).unwrap();
+    let window = FromTo {
+        from: 0.0,
+        to: 10.0,
+    };
+    let (rts, plain) = collect_ms1_scans(&mzml, window);
+    let mut indexed = plain.clone();
+    indexed.iter_mut().for_each(|s| {
+        s.index_intensities();
+        s.index_search();
+    });
+    let opts = EicOptions {
+        ppm_tolerance: 2000.0,
+        mz_tolerance: 0.1,
+    };
+    let centers: Vec<f64> = (0..400)
+        .map(|i| 149.0 + i as f64 * 0.37)
+        .chain([160.0, 150.5, 175.0])
+        .collect();
+    for scans in [&plain, &indexed] {
+        let mut sweep = EicSweep::new(scans);
+        for c in &centers {
+            let w = eic_window(c, opts);
+            let y = sweep.eic(w.0, w.1);
+            let moved = !sweep.unchanged();
+            assert_eq!(y, compute_eics_for_mzs(scans, &[w]));
+            assert_eq!(y.len(), rts.len());
+            assert_eq!(sweep.eic(w.0, w.1), y);
+            assert!(sweep.unchanged());
+            if moved {
+                assert!(sweep.eic(w.0 + 1e3, w.1 + 1e3).iter().all(|&v| v == 0.0));
+                assert_eq!(sweep.eic(w.0, w.1), y);
+                assert_eq!(sweep.unchanged(), y.iter().all(|&v| v == 0.0));
+            }
+        }
+    }
+}
@@ -0,0 +1,162 @@
+#![allow(dead_code)]
+
+use base64::Engine;
+use base64::engine::general_purpose::STANDARD;
+use miniz_oxide::deflate::compress_to_vec_zlib;
+
+pub fn array(raw: Vec<u8>, bits: &str, name: &str) -> String {
+    format!(
+        "<binaryDataArray>\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000000\" name=\"{bits}\" value=\"\"/>\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000576\" name=\"no compression\" value=\"\"/>\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000000\" name=\"{name}\" value=\"\"/>\n\
+         <binary>{}</binary>\n</binaryDataArray>\n",
+        STANDARD.encode(raw)
+    )
+}
+
+pub fn f32_intensity_mzml(spectra: usize, points: usize) -> String {
+    let mut body = String::new();
+    for i in 0..spectra {
+        let mz: Vec<u8> = (0..points)
+            .flat_map(|k| (150.0 + k as f64 * 0.5).to_le_bytes())
+            .collect();
+        let inten: Vec<u8> = (0..points)
+            .flat_map(|k| (((k * 31 + i * 7) % 101) as f32 * 0.75).to_le_bytes())
+            .collect();
+        body.push_str(&format!(
+            "<spectrum index=\"{i}\" id=\"scan={}\" defaultArrayLength=\"{points}\">\n\
+             <cvParam cvRef=\"MS\" accession=\"MS:1000511\" name=\"ms level\" value=\"1\"/>\n\
+             <cvParam cvRef=\"MS\" accession=\"MS:1000016\" name=\"scan start time\" value=\"{}\" unitName=\"minute\"/>\n\
+             <binaryDataArrayList count=\"2\">\n{}{}</binaryDataArrayList>\n</spectrum>\n",
+            i + 1,
+            i as f64 * 0.05,
+            array(mz, "64-bit float", "m/z array"),
+            array(inten, "32-bit float", "intensity array"),
+        ));
+    }
+    let time: Vec<u8> = (0..spectra)
+        .flat_map(|i| (i as f64 * 0.05).to_le_bytes())
+        .collect();
+    let tic: Vec<u8> = (0..spectra)
+        .flat_map(|i| (i as f32 * 2.5).to_le_bytes())
+        .collect();
+    format!(
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<mzML>\n<run id=\"r\">\n\
+         <spectrumList count=\"{spectra}\">\n{body}</spectrumList>\n\
+         <chromatogramList count=\"1\">\n\
+         <chromatogram index=\"0\" id=\"TIC\" defaultArrayLength=\"{spectra}\">\n\
+         <binaryDataArrayList count=\"2\">\n{}{}</binaryDataArrayList>\n</chromatogram>\n\
+         </chromatogramList>\n</run>\n</mzML>\n",
+        array(time, "64-bit float", "time array"),
+        array(tic, "32-bit float", "intensity array"),
+    )
+}
+
+pub fn zlib_array(values: &[f64], f32_prec: bool, accession: &str, name: &str) -> String {
+    let raw: Vec<u8> = if f32_prec {
+        values
+            .iter()
+            .flat_map(|v| (*v as f32).to_le_bytes())
+            .collect()
+    } else {
+        values.iter().flat_map(|v| v.to_le_bytes()).collect()
+    };
+    let text = STANDARD.encode(compress_to_vec_zlib(&raw, 6));
+    let (bits_acc, bits_name) = if f32_prec {
+        ("MS:1000521", "32-bit float")
+    } else {
+        ("MS:1000523", "64-bit float")
+    };
+    format!(
+        "<binaryDataArray encodedLength=\"{}\">\n\
+         <cvParam cvRef=\"MS\" accession=\"{bits_acc}\" name=\"{bits_name}\" value=\"\"/>\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000574\" name=\"zlib compression\" value=\"\"/>\n\
+         <cvParam cvRef=\"MS\" accession=\"{accession}\" name=\"{name}\" value=\"\"/>\n\
+         <binary>{text}</binary>\n</binaryDataArray>\n",
+        text.len()
+    )
+}
+
+fn encode_int(x: u32, nibbles: &mut Vec<u8>) {
+    let lead = (0..8)
+        .take_while(|&i| (x >> (28 - 4 * i)) & 0xF == 0)
+        .count();
+    let ones = (0..7)
+        .take_while(|&i| (x >> (28 - 4 * i)) & 0xF == 0xF)
+        .count();
+    let (head, skip) = if lead > 0 {
+        (lead as u8, lead)
+    } else if ones > 0 {
+        (ones as u8 + 8, ones)
+    } else {
+        (0, 0)
+    };
+    nibbles.push(head);
+    nibbles.extend((0..8 - skip).map(|i| ((x >> (4 * i)) & 0xF) as u8));
+}
+
+fn pack_nibbles(nibbles: &[u8], out: &mut Vec<u8>) {
+    out.extend(
+        nibbles
+            .chunks(2)
+            .map(|c| c[0] << 4 | c.get(1).copied().unwrap_or(0)),
+    );
+}
+
+pub fn numpress_linear(values: &[f64], fp: f64) -> (Vec<u8>, Vec<f64>) {
+    let ints: Vec<i64> = values.iter().map(|v| (v * fp + 0.5) as i64).collect();
+    let mut out = fp.to_be_bytes().to_vec();
+    out.extend((ints[0] as u32).to_le_bytes());
+    out.extend((ints[1] as u32).to_le_bytes());
+    let mut nibbles = Vec::new();
+    for w in ints.windows(3) {
+        encode_int((w[2] - (2 * w[1] - w[0])) as i32 as u32, &mut nibbles);
+    }
+    pack_nibbles(&nibbles, &mut out);
+    (out, ints.iter().map(|&i| i as f64 / fp).collect())
+}
+
+pub fn numpress_pic(values: &[f64]) -> (Vec<u8>, Vec<f64>) {
+    let ints: Vec<u32> = values.iter().map(|v| (v + 0.5) as u32).collect();
+    let mut nibbles = Vec::new();
+    for &i in &ints {
+        encode_int(i, &mut nibbles);
+    }
+    let mut out = Vec::new();
+    pack_nibbles(&nibbles, &mut out);
+    (out, ints.iter().map(|&i| i as f64).collect())
+}
+
+pub fn numpress_slof(values: &[f64], fp: f64) -> (Vec<u8>, Vec<f64>) {
+    let ints: Vec<u16> = values
+        .iter()
+        .map(|v| ((v + 1.0).ln() * fp + 0.5) as u16)
+        .collect();
+    let mut out = fp.to_be_bytes().to_vec();
+    out.extend(ints.iter().flat_map(|i| i.to_le_bytes()));
+    (
+        out,
+        ints.iter().map(|&i| (i as f64 / fp).exp() - 1.0).collect(),
+    )
+}
+
+pub fn numpress_array(raw: &[u8], zlib: bool, method: &str, accession: &str, name: &str) -> String {
+    let (payload, compression) = if zlib {
+        (
+            compress_to_vec_zlib(raw, 6),
+            format!("MS-Numpress {method} compression followed by zlib compression"),
+        )
+    } else {
+        (raw.to_vec(), format!("MS-Numpress {method} compression"))
+    };
+    let text = STANDARD.encode(payload);
+    format!(
+        "<binaryDataArray encodedLength=\"{}\">\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000523\" name=\"64-bit float\" value=\"\"/>\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1002312\" name=\"{compression}\" value=\"\"/>\n\
+         <cvParam cvRef=\"MS\" accession=\"{accession}\" name=\"{name}\" value=\"\"/>\n\
+         <binary>{text}</binary>\n</binaryDataArray>\n",
+        text.len()
+    )
+}
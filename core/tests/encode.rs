@@ -0,0 +1,50 @@
+mod common;
+
+use common::f32_intensity_mzml;
+use msut::utilities::calculate_eic::{EicOptions, calculate_eic_from_bin1};
+use msut::utilities::parse::decode::{decode, decode_native};
+use msut::utilities::parse::encode;
+use msut::utilities::parse::parse_mzml::{parse_mzml, parse_mzml_native};
+use msut::utilities::structs::FromTo;
+
+#[test]
+fn native_mode_writes_f32_intensity_columns() {
+    let xml = f32_intensity_mzml(40, 64);
+    let wide = parse_mzml(xml.as_bytes(), true, 1).unwrap();
+    let native = parse_mzml_native(xml.as_bytes(), true, 1).unwrap();
+
+    let run = native.run.as_ref().unwrap();
+    assert!(run.spectra.iter().all(|s| s.intensity_array.is_none()));
+    assert!(run.spectra.iter().all(|s| s.intensity_array_f32.is_some()));
+    assert!(run.chromatograms[0].intensity_array_f32.is_some());
+
+    let bin_wide = encode(&wide);
+    let bin = encode(&native);
+    assert_eq!(bin_wide[12..16], [2, 2, 2, 2]);
+    assert_eq!(bin[12..16], [2, 1, 2, 1]);
+    assert!(bin.len() < bin_wide.len());
+
+    let a = serde_json::to_value(decode(&bin_wide).unwrap()).unwrap();
+    let b = serde_json::to_value(decode(&bin).unwrap()).unwrap();
+    assert_eq!(a, b);
+
+    let kept = decode_native(&bin).unwrap();
+    let spectra = &kept.run.as_ref().unwrap().spectra;
+    for (k, w) in spectra.iter().zip(&wide.run.as_ref().unwrap().spectra) {
+        let k = k.intensity_array_f32.as_ref().unwrap();
+        let w = w.intensity_array.as_ref().unwrap();
+        assert!(k.iter().zip(w).all(|(&x, &y)| x as f64 == y));
+    }
+
+    let window = FromTo {
+        from: 0.0,
+        to: 10.0,
+    };
+    for target in [150.0, 160.5, 181.0] {
+        let x =
+            calculate_eic_from_bin1(&bin_wide, &target, window, EicOptions::default(), 1).unwrap();
+        let y = calculate_eic_from_bin1(&bin, &target, window, EicOptions::default(), 1).unwrap();
+        assert_eq!(x.x, y.x);
+        assert_eq!(x.y, y.y);
+    }
+}
@@ -0,0 +1,45 @@
+mod common;
+
+use common::f32_intensity_mzml;
+use msut::utilities::find_features::{
+    FeatureEngine, FindFeaturesOptions, MzScanGrid, SweepStats, find_features,
+    find_features_with_stats,
+};
+use msut::utilities::parse::parse_mzml::parse_mzml_native;
+use msut::utilities::progress::Progress;
+use msut::utilities::structs::FromTo;
+
+#[test]
+fn grid_sweep_reports_reused_rows() {
+    let xml = f32_intensity_mzml(40, 16);
+    let mzml = parse_mzml_native(xml.as_bytes(), true, 1).unwrap();
+    let window = FromTo {
+        from: 0.0,
+        to: 10.0,
+    };
+    let grid = || FindFeaturesOptions {
+        mz_scan_grid: Some(MzScanGrid {
+            mz_min: 149.9,
+            mz_max: 152.1,
+            step_size: 0.001,
+        }),
+        ..Default::default()
+    };
+
+    let (features, stats) =
+        find_features_with_stats(&mzml, window, Some(grid()), 1, &Progress::new());
+    assert!(stats.rows > 0);
+    assert!(stats.reused > 0 && stats.reused < stats.rows);
+    let plain = find_features(&mzml, window, Some(grid()), 1, &Progress::new());
+    assert_eq!(features.len(), plain.len());
+    for (a, b) in features.iter().zip(&plain) {
+        assert_eq!((a.mz, a.rt, a.intensity), (b.mz, b.rt, b.intensity));
+    }
+
+    let traces = FindFeaturesOptions {
+        engine: Some(FeatureEngine::MassTrace),
+        ..Default::default()
+    };
+    let (_, stats) = find_features_with_stats(&mzml, window, Some(traces), 1, &Progress::new());
+    assert_eq!(stats, SweepStats::default());
+}
@@ -0,0 +1,36 @@
+mod common;
+
+use common::f32_intensity_mzml;
+use msut::utilities::get_peaks_from_eic::get_peaks_from_eic;
+use msut::utilities::parse::encode;
+use msut::utilities::parse::parse_mzml::parse_mzml_native;
+use msut::utilities::progress::Progress;
+use msut::utilities::structs::{EicRoi, FromTo};
+
+#[test]
+fn per_roi_windows_match_narrow_global_window() {
+    let xml = f32_intensity_mzml(80, 128);
+    let bin = encode(&parse_mzml_native(xml.as_bytes(), true, 1).unwrap());
+    let wide = FromTo {
+        from: 0.0,
+        to: 100.0,
+    };
+    let targets = [
+        (1.5, 155.0, 0.8, 2.2),
+        (2.5, 170.5, 1.9, 3.4),
+        (4.0, 179.0, 3.0, 3.05),
+    ];
+    let rois: Vec<EicRoi> = targets
+        .iter()
+        .map(|&(rt, mz, from, to)| {
+            EicRoi::new(format!("{mz}"), rt, mz, 0.5).with_from_to(FromTo { from, to })
+        })
+        .collect();
+    let batched = get_peaks_from_eic(&bin, wide, &rois, None, 1, &Progress::new()).unwrap();
+    for (&(rt, mz, from, to), got) in targets.iter().zip(&batched) {
+        let roi = EicRoi::new(format!("{mz}"), rt, mz, 0.5);
+        let one = get_peaks_from_eic(&bin, FromTo { from, to }, &[roi], None, 1, &Progress::new())
+            .unwrap();
+        assert_eq!(format!("{:?}", one[0]), format!("{got:?}"));
+    }
+}
@@ -0,0 +1,51 @@
+mod common;
+
+use common::f32_intensity_mzml;
+use msut::utilities::calculate_eic::collect_ms1_scans;
+use msut::utilities::find_features::{FeatureEngine, FindFeaturesOptions, find_features};
+use msut::utilities::mass_traces::{MassTraceOptions, build_mass_traces};
+use msut::utilities::parse::parse_mzml::parse_mzml_native;
+use msut::utilities::progress::Progress;
+use msut::utilities::structs::FromTo;
+
+#[test]
+fn mass_traces_follow_constant_masses() {
+    let xml = f32_intensity_mzml(40, 16);
+    let mzml = parse_mzml_native(xml.as_bytes(), true, 1).unwrap();
+    let window = FromTo {
+        from: 0.0,
+        to: 10.0,
+    };
+    let (rts, scans) = collect_ms1_scans(&mzml, window);
+    let traces = build_mass_traces(&scans, MassTraceOptions::default());
+    assert_eq!(traces.len(), 16);
+    for (k, t) in traces.iter().enumerate() {
+        assert!((t.mz - (150.0 + k as f64 * 0.5)).abs() < 1e-9);
+        assert!(t.points >= rts.len() - 1);
+    }
+
+    let strict = MassTraceOptions {
+        max_gap: 0,
+        min_length: 1,
+        ..Default::default()
+    };
+    let gaps = scans
+        .iter()
+        .flat_map(|s| (0..s.mz.len()).map(|j| s.intensity.get(j)))
+        .filter(|&v| v <= 0.0)
+        .count();
+    assert!(gaps > 0);
+    assert!(build_mass_traces(&scans, strict).len() > 16);
+
+    let opts = FindFeaturesOptions {
+        engine: Some(FeatureEngine::MassTrace),
+        ..Default::default()
+    };
+    let features = find_features(&mzml, window, Some(opts), 1, &Progress::new());
+    assert!(!features.is_empty());
+    for f in features {
+        let k = ((f.mz - 150.0) / 0.5).round();
+        assert!((0.0..16.0).contains(&k));
+        assert!((f.mz - (150.0 + k * 0.5)).abs() < 1e-9);
+    }
+}
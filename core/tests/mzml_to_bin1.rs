@@ -0,0 +1,144 @@
+mod common;
+
+use common::{
+    array, f32_intensity_mzml, numpress_array, numpress_linear, numpress_pic, zlib_array,
+};
+use msut::utilities::parse::decode::decode_native;
+use msut::utilities::parse::encode;
+use msut::utilities::parse::mzml_to_bin1::parse_mzml_to_bin1;
+use msut::utilities::parse::parse_mzml::parse_mzml_native;
+
+const ACTUAL: usize = 61;
+
+fn mzml(spectra: &[(usize, String, String)]) -> String {
+    let mut body = String::new();
+    for (i, (declared, mz, int)) in spectra.iter().enumerate() {
+        body.push_str(&format!(
+            "<spectrum index=\"{i}\" id=\"scan={}\" defaultArrayLength=\"{declared}\">\n\
+             <cvParam cvRef=\"MS\" accession=\"MS:1000511\" name=\"ms level\" value=\"1\"/>\n\
+             <cvParam cvRef=\"MS\" accession=\"MS:1000016\" name=\"scan start time\" value=\"{}\" unitName=\"minute\"/>\n\
+             <binaryDataArrayList count=\"2\">\n{mz}{int}</binaryDataArrayList>\n</spectrum>\n",
+            i + 1,
+            i as f64 * 0.05,
+        ));
+    }
+    format!(
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<mzML>\n<run id=\"r\">\n\
+         <spectrumList count=\"{}\">\n{body}</spectrumList>\n</run>\n</mzML>\n",
+        spectra.len()
+    )
+}
+
+fn values(i: usize) -> (Vec<f64>, Vec<f64>) {
+    let mz = (0..ACTUAL)
+        .map(|k| 200.0 + k as f64 * 0.37 + i as f64 * 1e-3)
+        .collect();
+    let int = (0..ACTUAL)
+        .map(|k| ((k * 13 + i * 5) % 89) as f64)
+        .collect();
+    (mz, int)
+}
+
+fn declared(i: usize) -> usize {
+    match i % 3 {
+        0 => 100,
+        1 => ACTUAL,
+        _ => 40,
+    }
+}
+
+fn assert_matches_encode(xml: &str, short: bool) {
+    for cores in [1, 4] {
+        let native = parse_mzml_native(xml.as_bytes(), true, cores).unwrap();
+        let fused = parse_mzml_to_bin1(xml.as_bytes(), cores).unwrap();
+        assert_eq!(fused, encode(&native), "cores={cores}");
+    }
+    let fused = parse_mzml_to_bin1(xml.as_bytes(), 1).unwrap();
+    let spectra = decode_native(&fused).unwrap().run.unwrap().spectra;
+    for (i, s) in spectra.iter().enumerate() {
+        let want = if short {
+            ACTUAL.min(declared(i))
+        } else {
+            ACTUAL
+        };
+        assert_eq!(
+            s.mz_array.as_ref().map(Vec::len),
+            Some(want),
+            "spectrum {i}"
+        );
+    }
+}
+
+#[test]
+fn fused_writer_matches_parse_then_encode() {
+    let xml = f32_intensity_mzml(40, 64);
+    for cores in [1, 4] {
+        let native = parse_mzml_native(xml.as_bytes(), true, cores).unwrap();
+        let fused = parse_mzml_to_bin1(xml.as_bytes(), cores).unwrap();
+        assert_eq!(fused, encode(&native));
+    }
+
+    let unsized_xml = xml.replace("defaultArrayLength=\"64\"", "defaultArrayLength=\"0\"");
+    let native = parse_mzml_native(unsized_xml.as_bytes(), true, 1).unwrap();
+    let fused = parse_mzml_to_bin1(unsized_xml.as_bytes(), 1).unwrap();
+    assert_eq!(fused, encode(&native));
+}
+
+#[test]
+fn wrong_declared_length_uncompressed() {
+    let spectra: Vec<_> = (0..12)
+        .map(|i| {
+            let (mz, int) = values(i);
+            let mz = mz.iter().flat_map(|v| v.to_le_bytes()).collect();
+            let int = int.iter().flat_map(|&v| (v as f32).to_le_bytes()).collect();
+            (
+                declared(i),
+                array(mz, "64-bit float", "m/z array"),
+                array(int, "32-bit float", "intensity array"),
+            )
+        })
+        .collect();
+    assert_matches_encode(&mzml(&spectra), true);
+}
+
+#[test]
+fn wrong_declared_length_zlib() {
+    for f32_int in [true, false] {
+        let spectra: Vec<_> = (0..12)
+            .map(|i| {
+                let (mz, int) = values(i);
+                (
+                    declared(i),
+                    zlib_array(&mz, false, "MS:1000514", "m/z array"),
+                    zlib_array(&int, f32_int, "MS:1000515", "intensity array"),
+                )
+            })
+            .collect();
+        assert_matches_encode(&mzml(&spectra), true);
+    }
+}
+
+#[test]
+fn wrong_declared_length_numpress() {
+    for zlib in [false, true] {
+        let spectra: Vec<_> = (0..12)
+            .map(|i| {
+                let (mz, int) = values(i);
+                let (lin, _) = numpress_linear(&mz, 2f64.powi(20));
+                let (pic, _) = numpress_pic(&int);
+                (
+                    declared(i),
+                    numpress_array(&lin, zlib, "linear prediction", "MS:1000514", "m/z array"),
+                    numpress_array(
+                        &pic,
+                        zlib,
+                        "positive integer",
+                        "MS:1000515",
+                        "intensity array",
+                    ),
+                )
+            })
+            .collect();
+        assert_matches_encode(&mzml(&spectra), false);
+    }
+}
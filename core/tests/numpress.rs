@@ -0,0 +1,45 @@
+mod common;
+
+use common::{numpress_array, numpress_linear, numpress_pic, numpress_slof};
+use msut::utilities::parse::parse_mzml::parse_mzml;
+
+#[test]
+fn decodes_numpress_arrays() {
+    let mz: Vec<f64> = (0..257)
+        .map(|k| 150.0 + k as f64 * 0.731 + (k % 5) as f64 * 1e-3)
+        .collect();
+    let inten: Vec<f64> = (0..257)
+        .map(|k| ((k * 7919) % 100_003) as f64 * 1.5)
+        .collect();
+    let (lin, lin_expected) = numpress_linear(&mz, 2f64.powi(20));
+    let (pic, pic_expected) = numpress_pic(&inten);
+    let (slof, slof_expected) = numpress_slof(&inten, 5000.0);
+
+    for (zlib, int_raw, int_method, int_expected) in [
+        (false, &pic, "positive integer", &pic_expected),
+        (true, &pic, "positive integer", &pic_expected),
+        (false, &slof, "short logged float", &slof_expected),
+        (true, &slof, "short logged float", &slof_expected),
+    ] {
+        let xml = format!(
+            "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<mzML>\n<run id=\"r\">\n\
+             <spectrumList count=\"1\">\n\
+             <spectrum index=\"0\" id=\"scan=1\" defaultArrayLength=\"{}\">\n\
+             <cvParam cvRef=\"MS\" accession=\"MS:1000511\" name=\"ms level\" value=\"1\"/>\n\
+             <binaryDataArrayList count=\"2\">\n{}{}</binaryDataArrayList>\n</spectrum>\n\
+             </spectrumList>\n</run>\n</mzML>\n",
+            mz.len(),
+            numpress_array(&lin, zlib, "linear prediction", "MS:1000514", "m/z array"),
+            numpress_array(int_raw, zlib, int_method, "MS:1000515", "intensity array"),
+        );
+        let mzml = parse_mzml(xml.as_bytes(), false, 1).unwrap();
+        let s = &mzml.run.unwrap().spectra[0];
+        let got_mz = s.mz_array.as_ref().unwrap();
+        let got_int = s.intensity_array.as_ref().unwrap();
+        assert_eq!(got_mz.len(), lin_expected.len(), "{int_method} zlib={zlib}");
+        for (a, b) in got_mz.iter().zip(&lin_expected) {
+            assert!((a - b).abs() < 1e-9, "{a} != {b}");
+        }
+        assert_eq!(got_int, int_expected, "{int_method} zlib={zlib}");
+    }
+}
@@ -0,0 +1,88 @@
+use base64::Engine;
+use base64::engine::general_purpose::STANDARD;
+use msut::utilities::parse::parse_mzml::{ChromatogramSummary, parse_mzml};
+
+fn array(raw: Vec<u8>, name: &str) -> String {
+    format!(
+        "<binaryDataArray>\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000523\" name=\"64-bit float\" value=\"\"/>\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000576\" name=\"no compression\" value=\"\"/>\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000000\" name=\"{name}\" value=\"\"/>\n\
+         <binary>{}</binary>\n</binaryDataArray>\n",
+        STANDARD.encode(raw)
+    )
+}
+
+fn srm_mzml(transitions: usize, points: usize, indexed: bool) -> String {
+    let mut xml = format!(
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<indexedmzML>\n<mzML>\n<run id=\"r\">\n\
+         <chromatogramList count=\"{transitions}\">\n"
+    );
+    let mut offsets = Vec::with_capacity(transitions);
+    for i in 0..transitions {
+        let time: Vec<u8> = (0..points)
+            .flat_map(|k| (k as f64 * 0.01).to_le_bytes())
+            .collect();
+        let inten: Vec<u8> = (0..points)
+            .flat_map(|k| (((k * 13 + i * 5) % 97) as f64).to_le_bytes())
+            .collect();
+        offsets.push(xml.len());
+        xml.push_str(&format!(
+            "<chromatogram index=\"{i}\" id=\"SRM Q1={i} Q3={}\" defaultArrayLength=\"{points}\">\n\
+             <binaryDataArrayList count=\"2\">\n{}{}</binaryDataArrayList>\n</chromatogram>\n",
+            i + 1,
+            array(time, "time array"),
+            array(inten, "intensity array"),
+        ));
+    }
+    xml.push_str("</chromatogramList>\n</run>\n</mzML>\n");
+    if indexed {
+        let list = xml.len();
+        xml.push_str("<indexList count=\"1\">\n<index name=\"chromatogram\">\n");
+        for (i, off) in offsets.iter().enumerate() {
+            xml.push_str(&format!("<offset idRef=\"c{i}\">{off}</offset>\n"));
+        }
+        xml.push_str(&format!(
+            "</index>\n</indexList>\n<indexListOffset>{list}</indexListOffset>\n"
+        ));
+    }
+    xml.push_str("</indexedmzML>\n");
+    xml
+}
+
+fn chromatograms(xml: &str, cores: usize) -> Vec<ChromatogramSummary> {
+    parse_mzml(xml.as_bytes(), true, cores)
+        .unwrap()
+        .run
+        .unwrap()
+        .chromatograms
+}
+
+fn assert_same(a: &[ChromatogramSummary], b: &[ChromatogramSummary]) {
+    assert_eq!(a.len(), b.len());
+    for (x, y) in a.iter().zip(b) {
+        assert_eq!(x.index, y.index);
+        assert_eq!(x.id, y.id);
+        assert_eq!(x.time_array, y.time_array);
+        assert_eq!(x.intensity_array, y.intensity_array);
+    }
+}
+
+#[test]
+fn indexed_chromatograms_match_linear_scan() {
+    let linear = chromatograms(&srm_mzml(64, 50, false), 1);
+    assert_eq!(linear.len(), 64);
+    assert_eq!(linear[63].id, "SRM Q1=63 Q3=64");
+    assert_eq!(linear[5].intensity_array.as_ref().unwrap()[1], 38.0);
+
+    let indexed = srm_mzml(64, 50, true);
+    assert_same(&chromatograms(&indexed, 1), &linear);
+    assert_same(&chromatograms(&indexed, 4), &linear);
+
+    let stale = indexed.replacen(
+        "<chromatogramList count",
+        "<!-- shifted -->\n<chromatogramList count",
+        1,
+    );
+    assert_same(&chromatograms(&stale, 4), &linear);
+}
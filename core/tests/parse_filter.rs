@@ -0,0 +1,162 @@
+use base64::Engine;
+use base64::engine::general_purpose::STANDARD;
+use msut::utilities::parse::decode::{decode_native, decode_native_filtered};
+use msut::utilities::parse::encode;
+use msut::utilities::parse::parse_mzml::{
+    ParseFilter, SpectrumSummary, parse_mzml, parse_mzml_filtered,
+};
+use msut::utilities::structs::FromTo;
+
+fn array(raw: Vec<u8>, name: &str) -> String {
+    format!(
+        "<binaryDataArray>\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000523\" name=\"64-bit float\" value=\"\"/>\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000576\" name=\"no compression\" value=\"\"/>\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000000\" name=\"{name}\" value=\"\"/>\n\
+         <binary>{}</binary>\n</binaryDataArray>\n",
+        STANDARD.encode(raw)
+    )
+}
+
+fn dda_mzml(spectra: usize) -> String {
+    let mut body = String::new();
+    for i in 0..spectra {
+        let level = if i % 3 == 0 { 1 } else { 2 };
+        let polarity = if i % 2 == 0 { "positive" } else { "negative" };
+        let mz: Vec<u8> = (0..8)
+            .flat_map(|k| (100.0 + k as f64 + i as f64).to_le_bytes())
+            .collect();
+        let inten: Vec<u8> = (0..8)
+            .flat_map(|k| ((k * 7 + i) as f64).to_le_bytes())
+            .collect();
+        body.push_str(&format!(
+            "<spectrum index=\"{i}\" id=\"scan={}\" defaultArrayLength=\"8\">\n\
+             <cvParam cvRef=\"MS\" accession=\"MS:1000511\" name=\"ms level\" value=\"{level}\"/>\n\
+             <cvParam cvRef=\"MS\" accession=\"MS:1000000\" name=\"{polarity} scan\" value=\"\"/>\n\
+             <cvParam cvRef=\"MS\" accession=\"MS:1000016\" name=\"scan start time\" value=\"{}\" unitName=\"minute\"/>\n\
+             <binaryDataArrayList count=\"2\">\n{}{}</binaryDataArrayList>\n</spectrum>\n",
+            i + 1,
+            i as f64 * 0.1,
+            array(mz, "m/z array"),
+            array(inten, "intensity array"),
+        ));
+    }
+    format!(
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<mzML>\n<run id=\"r\">\n\
+         <spectrumList count=\"{spectra}\">\n{body}</spectrumList>\n</run>\n</mzML>\n"
+    )
+}
+
+fn spectra(mzml: msut::utilities::parse::parse_mzml::MzML) -> Vec<SpectrumSummary> {
+    mzml.run.unwrap().spectra
+}
+
+#[test]
+fn filter_skips_spectra_and_arrays() {
+    let xml = dda_mzml(60);
+    let window = FromTo { from: 1.0, to: 3.0 };
+    let all = spectra(parse_mzml(xml.as_bytes(), true, 1).unwrap());
+    let expected: Vec<&SpectrumSummary> = all
+        .iter()
+        .filter(|s| s.ms_level == Some(1))
+        .filter(|s| s.retention_time.is_some_and(|t| t >= 1.0 && t <= 3.0))
+        .collect();
+    assert!(!expected.is_empty());
+
+    for cores in [1, 4] {
+        let got = spectra(
+            parse_mzml_filtered(xml.as_bytes(), true, cores, &ParseFilter::ms1_in(window)).unwrap(),
+        );
+        assert_eq!(got.len(), expected.len());
+        for (g, e) in got.iter().zip(&expected) {
+            assert_eq!(g.index, e.index);
+            assert_eq!(g.mz_array, e.mz_array);
+            assert_eq!(g.intensity_array, e.intensity_array);
+        }
+    }
+
+    let negative_mz_only = ParseFilter {
+        polarity: Some(1),
+        intensity_array: false,
+        ..ParseFilter::ALL
+    };
+    let got = spectra(parse_mzml_filtered(xml.as_bytes(), true, 1, &negative_mz_only).unwrap());
+    assert_eq!(got.len(), 30);
+    assert!(got.iter().all(|s| s.polarity == Some(1)));
+    assert!(
+        got.iter()
+            .all(|s| s.mz_array.is_some() && s.intensity_array.is_none())
+    );
+}
+
+#[test]
+fn bin1_decode_applies_filter() {
+    let xml = dda_mzml(60);
+    let parsed = parse_mzml(xml.as_bytes(), true, 1).unwrap();
+    let bin = encode::encode(&parsed);
+    let filter = ParseFilter::ms1_in(FromTo { from: 1.0, to: 3.0 });
+    let all = spectra(decode_native(&bin).unwrap());
+    let got = spectra(decode_native_filtered(&bin, &filter).unwrap());
+    let expected: Vec<&SpectrumSummary> = all
+        .iter()
+        .filter(|s| filter.accepts(s.ms_level, s.retention_time, s.polarity))
+        .collect();
+    assert_eq!(got.len(), expected.len());
+    for (g, e) in got.iter().zip(&expected) {
+        assert_eq!(g.index, e.index);
+        assert_eq!(g.mz_array, e.mz_array);
+        assert_eq!(g.intensity_array, e.intensity_array);
+    }
+}
+
+#[test]
+fn ffi_parse_mzml_filtered_writes_filtered_bin1() {
+    let xml = dda_mzml(60);
+    let levels = [1u8];
+    let filter = msut::CParseFilter {
+        ms_levels: levels.as_ptr(),
+        ms_levels_len: levels.len(),
+        rt_from: 1.0,
+        rt_to: f64::NAN,
+        polarity: 0,
+        mz_array: 1,
+        intensity_array: 0,
+        chromatograms: 0,
+    };
+    let mut out = msut::Buf {
+        ptr: std::ptr::null_mut(),
+        len: 0,
+    };
+    let rc = unsafe { msut::parse_mzml_filtered(xml.as_ptr(), xml.len(), 2, &filter, &mut out) };
+    assert_eq!(rc, 0);
+    let bin = unsafe { std::slice::from_raw_parts(out.ptr, out.len) }.to_vec();
+    unsafe { msut::free_(out.ptr, out.len) };
+
+    let expected = ParseFilter {
+        ms_levels: Some(vec![1]),
+        rt_range: Some(FromTo {
+            from: 1.0,
+            to: f64::INFINITY,
+        }),
+        polarity: Some(0),
+        intensity_array: false,
+        chromatograms: false,
+        ..ParseFilter::ALL
+    };
+    let want = spectra(parse_mzml_filtered(xml.as_bytes(), true, 1, &expected).unwrap());
+    let got = spectra(decode_native(&bin).unwrap());
+    assert!(!want.is_empty());
+    assert_eq!(got.len(), want.len());
+    for (g, w) in got.iter().zip(&want) {
+        assert_eq!(g.index, w.index);
+        assert_eq!(g.mz_array, w.mz_array);
+        assert!(g.intensity_array.is_none());
+    }
+
+    let bad = msut::CParseFilter {
+        polarity: 7,
+        ..filter
+    };
+    let rc = unsafe { msut::parse_mzml_filtered(xml.as_ptr(), xml.len(), 1, &bad, &mut out) };
+    assert_eq!(rc, 1);
+}
@@ -0,0 +1,88 @@
+mod common;
+
+use common::{array, f32_intensity_mzml};
+use msut::utilities::parse::parse_mzml::{
+    SpectrumSummary, load_spectra, load_spectrum, parse_mzml, parse_mzml_lazy,
+};
+
+fn comparable(spectra: &[SpectrumSummary]) -> String {
+    let spectra: Vec<SpectrumSummary> = spectra
+        .iter()
+        .cloned()
+        .map(|mut s| {
+            s.array_spans = None;
+            s
+        })
+        .collect();
+    serde_json::to_string(&spectra).unwrap()
+}
+
+fn duplicate_intensity_mzml(points: usize) -> String {
+    let mz: Vec<u8> = (0..points)
+        .flat_map(|k| (300.0 + k as f64).to_le_bytes())
+        .collect();
+    let inten: Vec<u8> = (0..points)
+        .flat_map(|k| (k as f64 * 2.0).to_le_bytes())
+        .collect();
+    let good = array(inten, "64-bit float", "intensity array");
+    let broken = good.replacen("<binary>", "<binary>@@@@", 1);
+    format!(
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<mzML>\n<run id=\"r\">\n\
+         <spectrumList count=\"1\">\n\
+         <spectrum index=\"0\" id=\"scan=1\" defaultArrayLength=\"{points}\">\n\
+         <cvParam cvRef=\"MS\" accession=\"MS:1000511\" name=\"ms level\" value=\"1\"/>\n\
+         <binaryDataArrayList count=\"3\">\n{}{}{}</binaryDataArrayList>\n</spectrum>\n\
+         </spectrumList>\n</run>\n</mzML>\n",
+        array(mz, "64-bit float", "m/z array"),
+        good,
+        broken,
+    )
+}
+
+#[test]
+fn lazy_parse_then_load_matches_eager() {
+    let xml = f32_intensity_mzml(12, 40);
+    let bytes = xml.as_bytes();
+    let eager = parse_mzml(bytes, false, 1).unwrap();
+    let eager = &eager.run.unwrap().spectra;
+
+    let mut one = parse_mzml_lazy(bytes, false, 1)
+        .unwrap()
+        .run
+        .unwrap()
+        .spectra;
+    assert!(
+        one.iter()
+            .all(|s| s.mz_array.is_none() && s.array_spans.is_some())
+    );
+    for s in &mut one {
+        assert!(load_spectrum(bytes, s));
+    }
+    assert_eq!(comparable(&one), comparable(eager));
+
+    let mut all = parse_mzml_lazy(bytes, false, 4)
+        .unwrap()
+        .run
+        .unwrap()
+        .spectra;
+    assert_eq!(load_spectra(bytes, &mut all, 4), all.len());
+    assert_eq!(comparable(&all), comparable(eager));
+}
+
+#[test]
+fn corrupt_duplicate_array_keeps_earlier_good_one() {
+    let xml = duplicate_intensity_mzml(8);
+    let bytes = xml.as_bytes();
+    let expected: Vec<f64> = (0..8).map(|k| k as f64 * 2.0).collect();
+
+    let eager = parse_mzml(bytes, false, 1).unwrap().run.unwrap().spectra;
+    assert_eq!(eager[0].intensity_array.as_deref(), Some(&expected[..]));
+
+    let mut lazy = parse_mzml_lazy(bytes, false, 1)
+        .unwrap()
+        .run
+        .unwrap()
+        .spectra;
+    assert!(load_spectrum(bytes, &mut lazy[0]));
+    assert_eq!(comparable(&lazy), comparable(&eager));
+}
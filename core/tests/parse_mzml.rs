@@ -0,0 +1,58 @@
+mod common;
+
+use common::zlib_array;
+use msut::utilities::parse::parse_mzml::parse_mzml;
+
+fn synthetic_mzml(spectra: usize, points: usize) -> (String, Vec<Vec<f64>>) {
+    let mut body = String::new();
+    let mut mzs = Vec::with_capacity(spectra);
+    for i in 0..spectra {
+        let n = points + (i * 7) % 31;
+        let mz: Vec<f64> = (0..n)
+            .map(|k| 100.0 + k as f64 * 0.25 + i as f64 * 1e-4)
+            .collect();
+        let inten: Vec<f64> = (0..n).map(|k| ((k * 13 + i) % 97) as f64).collect();
+        body.push_str(&format!(
+            "<spectrum index=\"{i}\" id=\"scan={}\" defaultArrayLength=\"{n}\">\n\
+             <cvParam cvRef=\"MS\" accession=\"MS:1000511\" name=\"ms level\" value=\"1\"/>\n\
+             <scanList count=\"1\">\n<scan>\n\
+             <cvParam cvRef=\"MS\" accession=\"MS:1000016\" name=\"scan start time\" value=\"{}\" unitCvRef=\"UO\" unitAccession=\"UO:0000031\" unitName=\"minute\"/>\n\
+             </scan>\n</scanList>\n<binaryDataArrayList count=\"2\">\n{}{}</binaryDataArrayList>\n</spectrum>\n",
+            i + 1,
+            i as f64 * 0.01,
+            zlib_array(&mz, false, "MS:1000514", "m/z array"),
+            zlib_array(&inten, true, "MS:1000515", "intensity array"),
+        ));
+        mzs.push(mz);
+    }
+    let xml = format!(
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<mzML>\n<run id=\"r\">\n\
+         <spectrumList count=\"{spectra}\">\n{body}</spectrumList>\n</run>\n</mzML>\n"
+    );
+    (xml, mzs)
+}
+
+#[test]
+fn zlib_arrays_decode_through_shared_scratch() {
+    let (xml, mzs) = synthetic_mzml(400, 200);
+    let mzml = parse_mzml(xml.as_bytes(), false, 1).unwrap();
+
+    let spectra = &mzml.run.unwrap().spectra;
+    assert_eq!(spectra.len(), mzs.len());
+    for (s, mz) in spectra.iter().zip(&mzs) {
+        assert_eq!(s.mz_array.as_deref(), Some(mz.as_slice()));
+        let inten = s.intensity_array.as_ref().unwrap();
+        assert_eq!(inten.len(), mz.len());
+    }
+}
+
+#[test]
+fn zlib_array_longer_than_declared_keeps_declared_prefix() {
+    let (xml, mzs) = synthetic_mzml(1, 50);
+    let xml = xml.replace("defaultArrayLength=\"50\"", "defaultArrayLength=\"20\"");
+    let mzml = parse_mzml(xml.as_bytes(), false, 1).unwrap();
+
+    let s = &mzml.run.unwrap().spectra[0];
+    assert_eq!(s.mz_array.as_deref(), Some(&mzs[0][..20]));
+    assert_eq!(s.intensity_array.as_ref().map(Vec::len), Some(20));
+}
@@ -0,0 +1,73 @@
+mod common;
+
+use common::f32_intensity_mzml;
+use msut::utilities::parse::parse_mzml::parse_mzml;
+
+const XML: &str = r#"<?xml version="1.0" encoding="utf-8"?>
+<indexedmzML>
+<mzML version="1.1.0">
+<!-- <softwareList count="9"><software id="decoy"/></softwareList> -->
+<cvList count="1">
+<cv id="MS" fullName="Proteomics Standards Initiative Mass Spectrometry Ontology" version="4.1.0" URI="https://example.org/psi-ms.obo"/>
+</cvList>
+<fileDescription>
+<fileContent>
+<cvParam cvRef="MS" accession="MS:1000579" name="MS1 spectrum" value=""/>
+</fileContent>
+</fileDescription>
+<referenceableParamGroupList count="0"/>
+<softwareList count="1">
+<software id="conv" version="1.0">
+<cvParam cvRef="MS" accession="MS:1000615" name="ProteoWizard software" value=""/>
+</software>
+</softwareList>
+<run id="r1" startTimeStamp="2024-01-01T00:00:00Z">
+<spectrumList count="0">
+</spectrumList>
+<chromatogramList count="0">
+</chromatogramList>
+</run>
+</mzML>
+<indexList count="1">
+<index name="chromatogram">
+</index>
+</indexList>
+<indexListOffset>0</indexListOffset>
+<fileChecksum>abc</fileChecksum>
+</indexedmzML>
+"#;
+
+#[test]
+fn full_parse_reads_sections_in_one_pass() {
+    let full = parse_mzml(XML.as_bytes(), false, 1).unwrap();
+    assert_eq!(full.cv_list.len(), 1);
+    assert_eq!(full.cv_list[0].id, "MS");
+    assert_eq!(full.software_list.len(), 1);
+    assert_eq!(full.software_list[0].id, "conv");
+    assert!(full.referenceable_param_groups.is_empty());
+    assert!(full.file_description.is_some());
+
+    let run = full.run.as_ref().unwrap();
+    assert_eq!(run.id, "r1");
+    assert_eq!(run.spectrum_list_count, Some(0));
+    assert_eq!(run.chromatogram_list_count, Some(0));
+
+    let slim = parse_mzml(XML.as_bytes(), true, 4).unwrap();
+    assert!(slim.cv_list.is_empty() && slim.software_list.is_empty());
+    assert_eq!(slim.run.unwrap().id, "r1");
+}
+
+#[test]
+fn malformed_header_still_finds_run() {
+    let xml = f32_intensity_mzml(6, 10);
+    let cv = "<cvList count=\"1\">\n<cv id=\"MS\" fullName=\"PSI-MS\"/>\n</cvList>\n";
+    for junk in ["<vendorBlob kind=\"raw\">\n", "<!-- unterminated\n", "<"] {
+        let broken = xml.replacen("<mzML>\n", &format!("<mzML>\n{junk}{cv}"), 1);
+        let mzml = parse_mzml(broken.as_bytes(), false, 1).unwrap();
+        assert_eq!(mzml.cv_list.len(), 1, "{junk:?}");
+        let run = mzml.run.unwrap();
+        assert_eq!(run.id, "r");
+        assert_eq!(run.spectra.len(), 6, "{junk:?}");
+        assert_eq!(run.chromatograms.len(), 1, "{junk:?}");
+    }
+}
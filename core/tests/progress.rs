@@ -0,0 +1,55 @@
+mod common;
+
+use common::f32_intensity_mzml;
+use msut::utilities::find_features::{FindFeaturesOptions, MzScanGrid, find_features};
+use msut::utilities::get_peaks_from_eic::get_peaks_from_eic;
+use msut::utilities::parse::encode;
+use msut::utilities::parse::parse_mzml::parse_mzml_native;
+use msut::utilities::progress::Progress;
+use msut::utilities::structs::{EicRoi, FromTo};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+
+#[test]
+fn progress_reports_and_cancels() {
+    let xml = f32_intensity_mzml(40, 16);
+    let mzml = parse_mzml_native(xml.as_bytes(), true, 1).unwrap();
+    let bin = encode(&mzml);
+    let window = FromTo {
+        from: 0.0,
+        to: 10.0,
+    };
+    let rois: Vec<EicRoi> = (0..16)
+        .map(|k| EicRoi::new(format!("{k}"), 2.0, 150.0 + k as f64 * 0.5, 1.0))
+        .collect();
+
+    let seen = Arc::new(Mutex::new(Vec::new()));
+    let log = seen.clone();
+    let progress = Progress::new()
+        .with_report(move |f, stage| log.lock().unwrap().push((f, stage.to_string())));
+    let peaks = get_peaks_from_eic(&bin, window, &rois, None, 2, &progress).unwrap();
+    assert_eq!(peaks.len(), rois.len());
+    let seen = seen.lock().unwrap();
+    assert!(seen.iter().all(|(_, stage)| stage == "peaks"));
+    assert!(seen.windows(2).all(|w| w[0].0 <= w[1].0));
+    assert_eq!(seen.last().map(|s| s.0), Some(1.0));
+
+    let stopped = Progress::new();
+    stopped.cancel();
+    assert!(get_peaks_from_eic(&bin, window, &rois, None, 2, &stopped).is_none());
+
+    let calls = Arc::new(AtomicUsize::new(0));
+    let polled = calls.clone();
+    let progress = Progress::new().with_cancel(move || polled.fetch_add(1, Ordering::Relaxed) > 3);
+    let opts = FindFeaturesOptions {
+        mz_scan_grid: Some(MzScanGrid {
+            mz_min: 149.0,
+            mz_max: 158.0,
+            step_size: 0.01,
+        }),
+        ..Default::default()
+    };
+    assert!(find_features(&mzml, window, Some(opts), 1, &progress).is_empty());
+    assert!(progress.cancelled());
+    assert!(calls.load(Ordering::Relaxed) < 100);
+}
@@ -0,0 +1,37 @@
+use msut::utilities::calculate_eic::{lower_bound, upper_bound};
+use msut::utilities::search::SkipTable;
+
+fn sorted_mzs(n: usize, seed: u32) -> Vec<f64> {
+    let mut x = seed;
+    let mut m = 100.0;
+    (0..n)
+        .map(|_| {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            if x % 7 != 0 {
+                m += (x as f64 / u32::MAX as f64) * 0.05;
+            }
+            m
+        })
+        .collect()
+}
+
+#[test]
+fn branchless_and_skip_searches_match_linear_scan() {
+    for n in [0, 1, 2, 63, 64, 65, 127, 128, 129, 1000, 5003] {
+        let a = sorted_mzs(n, 2463534242 + n as u32);
+        let skip = SkipTable::new(&a);
+        let mut queries = vec![f64::NEG_INFINITY, 0.0, 100.0, f64::INFINITY];
+        queries.extend(a.iter().step_by(7).copied());
+        queries.extend(a.iter().step_by(11).map(|m| m + 1e-4));
+        for x in queries {
+            let lo = a.iter().take_while(|&&v| v < x).count();
+            let hi = a.iter().take_while(|&&v| v <= x).count();
+            assert_eq!(lower_bound(&a, x), lo, "n={n} x={x}");
+            assert_eq!(upper_bound(&a, x), hi, "n={n} x={x}");
+            assert_eq!(skip.lower_bound(&a, x), lo, "n={n} x={x}");
+            assert_eq!(skip.upper_bound(&a, x), hi, "n={n} x={x}");
+        }
+    }
+}
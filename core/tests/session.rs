@@ -0,0 +1,59 @@
+mod common;
+
+use common::f32_intensity_mzml;
+use msut::utilities::calculate_eic::{EicOptions, calculate_eic_from_bin1};
+use msut::utilities::get_peaks_from_chrom::get_peaks_from_chrom;
+use msut::utilities::get_peaks_from_eic::get_peaks_from_eic;
+use msut::utilities::parse::bin1_view::Bin1View;
+use msut::utilities::parse::encode;
+use msut::utilities::parse::parse_mzml::parse_mzml_native;
+use msut::utilities::progress::Progress;
+use msut::utilities::session::Session;
+use msut::utilities::structs::{ChromRoi, EicRoi, FromTo};
+
+#[test]
+fn session_matches_one_shot_queries() {
+    let xml = f32_intensity_mzml(120, 64);
+    let bin = encode(&parse_mzml_native(xml.as_bytes(), true, 1).unwrap());
+    let session = Session::open(&bin).unwrap();
+    assert_eq!(session.scan_count(), 120);
+    assert_eq!(session.chromatogram_count(), 1);
+    assert_eq!(session.chromatogram_id(0), Some("TIC"));
+
+    for (from, to) in [(0.0, 10.0), (1.02, 3.5), (4.0, 2.0)] {
+        let window = FromTo { from, to };
+        for target in [150.0, 160.5, 181.0] {
+            let x =
+                calculate_eic_from_bin1(&bin, &target, window, EicOptions::default(), 1).unwrap();
+            let y = session
+                .calculate_eic(&target, window, EicOptions::default())
+                .unwrap();
+            assert_eq!(x.x, y.x);
+            assert_eq!(x.y, y.y);
+        }
+    }
+
+    let window = FromTo { from: 0.5, to: 5.0 };
+    let rois: Vec<EicRoi> = [(1.5, 155.0), (2.5, 170.5), (4.0, 179.0)]
+        .iter()
+        .map(|&(rt, mz)| EicRoi::new(format!("{mz}"), rt, mz, 0.5))
+        .collect();
+    for cores in [1, 4] {
+        let a = get_peaks_from_eic(&bin, window, &rois, None, cores, &Progress::new()).unwrap();
+        let b = session
+            .get_peaks_from_eic(window, &rois, None, cores, &Progress::new())
+            .unwrap();
+        assert_eq!(format!("{a:?}"), format!("{b:?}"));
+    }
+
+    let items = vec![ChromRoi {
+        id: "TIC".into(),
+        idx: 0,
+        rt: 3.0,
+        window: 1.0,
+    }];
+    let view = Bin1View::new(&bin).unwrap();
+    let a = get_peaks_from_chrom(&view, &items, None, 1).unwrap();
+    let b = session.get_peaks_from_chrom(&items, None, 1).unwrap();
+    assert_eq!(format!("{a:?}"), format!("{b:?}"));
+}
@@ -0,0 +1,41 @@
+mod common;
+
+use common::f32_intensity_mzml;
+use msut::utilities::parse::bin1_view::Bin1View;
+use msut::utilities::parse::decode::decode;
+use msut::utilities::parse::encode;
+use msut::utilities::parse::parse_mzml::parse_mzml;
+use msut::utilities::parse::stream_bin1::convert_mzml_to_bin1;
+use std::io::Cursor;
+
+#[test]
+fn streaming_converter_round_trips_through_encode() {
+    let xml = f32_intensity_mzml(25, 48);
+    let want = encode(&parse_mzml(xml.as_bytes(), true, 1).unwrap());
+    let expected = Bin1View::new(&want).unwrap();
+    assert!(xml.find("</binaryDataArray>").unwrap() > 64);
+
+    for window in [7, 64, 333, 1 << 20] {
+        let mut out = Cursor::new(Vec::new());
+        let stats = convert_mzml_to_bin1(xml.as_bytes(), &mut out, window).unwrap();
+        let got = out.into_inner();
+        assert_eq!(stats.spectra, 25);
+        assert_eq!(stats.chromatograms, 1);
+        assert_eq!(stats.bytes_written as usize, got.len());
+        assert_eq!(encode(&decode(&got).unwrap()), want, "window={window}");
+
+        let view = Bin1View::new(&got).unwrap();
+        for i in 0..view.spectrum_count() {
+            assert_eq!(view.retention_time(i), expected.retention_time(i));
+            assert_eq!(view.spectrum_mz(i), expected.spectrum_mz(i));
+            let a = view.spectrum_intensity(i).unwrap().into_f64();
+            let b = expected.spectrum_intensity(i).unwrap().into_f64();
+            assert_eq!(a, b);
+        }
+        assert_eq!(view.chromatogram_id(0), expected.chromatogram_id(0));
+        assert_eq!(view.chromatogram_time(0), expected.chromatogram_time(0));
+    }
+
+    let cut = &xml.as_bytes()[..xml.len() / 2];
+    assert!(convert_mzml_to_bin1(cut, Cursor::new(Vec::new()), 64).is_err());
+}
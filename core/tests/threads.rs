@@ -0,0 +1,56 @@
+use std::sync::Arc;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::time::Duration;
+
+use msut::utilities::threads::{WithCores, in_pool, set_threads, thread_pool};
+use rayon::prelude::*;
+
+fn peak_workers(calls: &[usize]) -> usize {
+    let active = AtomicUsize::new(0);
+    let peak = AtomicUsize::new(0);
+    let work = |cores: usize| {
+        in_pool(cores, || {
+            (0..64usize)
+                .into_par_iter()
+                .with_cores(cores)
+                .for_each(|_| {
+                    let now = active.fetch_add(1, Ordering::SeqCst) + 1;
+                    peak.fetch_max(now, Ordering::SeqCst);
+                    std::thread::sleep(Duration::from_millis(2));
+                    active.fetch_sub(1, Ordering::SeqCst);
+                })
+        })
+    };
+    std::thread::scope(|s| {
+        for &cores in calls {
+            s.spawn(move || work(cores));
+        }
+    });
+    peak.load(Ordering::SeqCst)
+}
+
+#[test]
+fn one_pool_is_shared_and_capped() {
+    set_threads(3, &[]);
+    let pool = thread_pool().unwrap();
+    assert_eq!(pool.current_num_threads(), 3);
+    assert!(Arc::ptr_eq(&pool, &thread_pool().unwrap()));
+    assert_eq!(in_pool(8, || 6 * 7), 42);
+
+    assert!(peak_workers(&[3, 2]) <= 3);
+    assert!(peak_workers(&[8, 2, 2]) <= 3);
+    assert!(peak_workers(&[2]) <= 2);
+    assert_eq!(peak_workers(&[1]), 1);
+
+    set_threads(2, &[0]);
+    let pinned = thread_pool().unwrap();
+    assert_eq!(pinned.current_num_threads(), 2);
+    assert!(!Arc::ptr_eq(&pool, &pinned));
+    assert!(peak_workers(&[2, 2]) <= 2);
+
+    set_threads(0, &[]);
+    assert_eq!(
+        thread_pool().unwrap().current_num_threads(),
+        std::thread::available_parallelism().map_or(1, |n| n.get())
+    );
+}
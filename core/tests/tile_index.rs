@@ -0,0 +1,99 @@
+mod common;
+
+use std::borrow::Cow;
+
+use common::f32_intensity_mzml;
+use msut::utilities::calculate_eic::{
+    CentroidScan, EicOptions, collect_ms1_scans, compute_eic_for_mz, compute_eic_for_mz_tiled,
+    eic_window,
+};
+use msut::utilities::parse::bin1_view::Values;
+use msut::utilities::parse::parse_mzml::parse_mzml_native;
+use msut::utilities::structs::FromTo;
+use msut::utilities::tile_index::TileIndex;
+
+#[test]
+fn tile_index_matches_scan_kernel() {
+    let xml = f32_intensity_mzml(30, 512);
+    let mzml = parse_mzml_native(xml.as_bytes(), true, 1).unwrap();
+    let window = FromTo {
+        from: 0.0,
+        to: 10.0,
+    };
+    let (rts, scans) = collect_ms1_scans(&mzml, window);
+    let n = rts.len();
+    let opts = EicOptions {
+        ppm_tolerance: 2000.0,
+        mz_tolerance: 0.0,
+    };
+    for tiles in [
+        TileIndex::new(&scans),
+        TileIndex::with_tiles(&scans, 4, 0.37),
+    ] {
+        for target in [10.0, 150.0, 175.25, 200.0, 260.0, 300.0, 500.0, 5000.0] {
+            let full = compute_eic_for_mz(&scans, n, &target, opts);
+            assert_eq!(
+                compute_eic_for_mz_tiled(&tiles, &scans, 0..n, &target, opts),
+                full
+            );
+            assert_eq!(
+                compute_eic_for_mz_tiled(&tiles, &scans, 5..n - 7, &target, opts),
+                &full[5..n - 7]
+            );
+
+            let (lo, hi) = eic_window(&target, opts);
+            let points = scans[3..n - 2].iter().flat_map(|s| {
+                s.mz.iter()
+                    .enumerate()
+                    .filter(|&(_, m)| *m >= lo && *m <= hi)
+                    .map(|(j, _)| s.intensity.get(j))
+            });
+            let max = points
+                .clone()
+                .fold(None, |b: Option<f64>, v| Some(b.map_or(v, |b| b.max(v))));
+            assert_eq!(tiles.max_intensity(&scans, lo, hi, 3..n - 2), max);
+            let sum: f64 = points.sum();
+            assert!((tiles.sum(&scans, lo, hi, 3..n - 2) - sum).abs() <= 1e-9 * sum.max(1.0));
+        }
+    }
+}
+
+#[test]
+fn outlier_mz_range_stays_queryable() {
+    let scans: Vec<CentroidScan> = (0..40)
+        .map(|i| {
+            let mz = vec![1e-3, 150.0, 150.5 + i as f64 * 1e-3, 1e12];
+            let int = vec![1.0, 2.0, 3.0 + i as f64, 4.0];
+            CentroidScan {
+                rt: i as f64,
+                mz: Cow::Owned(mz),
+                intensity: Values::F64(Cow::Owned(int)),
+                cumulative: None,
+                skip: None,
+            }
+        })
+        .collect();
+    let n = scans.len();
+    let opts = EicOptions {
+        ppm_tolerance: 0.0,
+        mz_tolerance: 0.6,
+    };
+    for tiles in [
+        TileIndex::new(&scans),
+        TileIndex::with_tiles(&scans, 4, 1e-6),
+    ] {
+        for target in [1e-3, 150.2, 1e12] {
+            let full = compute_eic_for_mz(&scans, n, &target, opts);
+            assert_eq!(
+                compute_eic_for_mz_tiled(&tiles, &scans, 0..n, &target, opts),
+                full
+            );
+        }
+        let (lo, hi) = eic_window(&150.2, opts);
+        assert_eq!(
+            tiles.max_intensity(&scans, lo, hi, 0..n),
+            Some(3.0 + (n - 1) as f64)
+        );
+        assert_eq!(tiles.max_intensity(&scans, 5e5, 6e5, 0..n), None);
+    }
+}
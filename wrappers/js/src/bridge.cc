@@ -7,6 +7,10 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -49,7 +53,35 @@ typedef struct
 
 static_assert(sizeof(CPeakPOptions) == 64, "CPeakPOptions must be 64 bytes");
 
-typedef int32_t (*fn_parse_mzml)(const unsigned char *, size_t, Buf *);
+typedef struct
+{
+  const uint8_t *ms_levels;
+  size_t ms_levels_len;
+  double rt_from;
+  double rt_to;
+  int32_t polarity;
+  int32_t mz_array;
+  int32_t intensity_array;
+  int32_t chromatograms;
+} CParseFilter;
+
+static_assert(sizeof(CParseFilter) == 48, "CParseFilter must be 48 bytes");
+
+typedef struct
+{
+  void (*report)(void *, double, const char *);
+  void *user_data;
+  const int32_t *cancel;
+} CProgress;
+
+static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t), "cancel flag must be a plain int32");
+
+typedef int32_t (*fn_parse_mzml)(const unsigned char *, size_t, size_t, Buf *);
+typedef int32_t (*fn_parse_mzml_path)(const char *, size_t, Buf *);
+typedef int32_t (*fn_parse_mzml_filtered)(
+    const unsigned char *, size_t, size_t, const CParseFilter *, Buf *);
+typedef int32_t (*fn_parse_mzml_path_filtered)(const char *, size_t, const CParseFilter *, Buf *);
+typedef int32_t (*fn_convert_mzml_to_bin1)(const char *, const char *, size_t);
 typedef int32_t (*fn_bin_to_json)(const unsigned char *, size_t, Buf *);
 typedef int32_t (*fn_get_peak)(
     const double *, const double *, size_t, double, double, const CPeakPOptions *, Buf *);
@@ -57,13 +89,21 @@ typedef int32_t (*fn_calculate_eic)(
     const unsigned char *, size_t,
     double,
     double, double, double, double,
+    size_t,
+    Buf *, Buf *);
+typedef int32_t (*fn_calculate_eics)(
+    const unsigned char *, size_t,
+    const double *, size_t,
+    const double *, const double *, size_t,
+    double, double,
     Buf *, Buf *);
 typedef double (*fn_find_noise_level)(const double *, size_t);
 typedef int32_t (*fn_get_peaks_from_eic)(
     const unsigned char *, size_t,
     const double *, const double *, const double *,
+    const double *, const double *,
     const uint32_t *, const uint32_t *, const unsigned char *, size_t,
-    size_t, double, double, const CPeakPOptions *, size_t, Buf *);
+    size_t, double, double, const CPeakPOptions *, size_t, const CProgress *, Buf *);
 typedef int32_t (*fn_get_peaks_from_chrom)(
     const unsigned char *, size_t,
     const uint32_t *, const double *, const double *, size_t,
@@ -77,22 +117,68 @@ typedef int32_t (*fn_find_features)(
     double, double,
     double, double,
     double, double, double,
+    int32_t, double,
+    const CPeakPOptions *, int32_t,
+    const CProgress *, Buf *);
+typedef int32_t (*fn_find_features_path)(
+    const char *,
+    double, double,
+    double, double,
+    double, double, double,
+    int32_t, double,
     const CPeakPOptions *, int32_t,
-    Buf *);
+    const CProgress *, Buf *);
+typedef int32_t (*fn_session_open)(const unsigned char *, size_t, void **);
+typedef void (*fn_session_close)(void *);
+typedef int32_t (*fn_set_threads)(int32_t, const int32_t *, size_t);
+typedef int32_t (*fn_session_calculate_eic)(
+    const void *,
+    double,
+    double, double, double, double,
+    Buf *, Buf *);
+typedef int32_t (*fn_session_calculate_eics)(
+    const void *,
+    const double *, size_t,
+    const double *, const double *, size_t,
+    double, double,
+    Buf *, Buf *);
+typedef int32_t (*fn_session_get_peaks_from_eic)(
+    const void *,
+    const double *, const double *, const double *,
+    const double *, const double *,
+    const uint32_t *, const uint32_t *, const unsigned char *, size_t,
+    size_t, double, double, const CPeakPOptions *, size_t, const CProgress *, Buf *);
+typedef int32_t (*fn_session_get_peaks_from_chrom)(
+    const void *,
+    const uint32_t *, const double *, const double *, size_t,
+    const CPeakPOptions *, size_t, Buf *);
 typedef void (*fn_free_)(unsigned char *, size_t);
 
 typedef struct
 {
   fn_parse_mzml parse_mzml;
+  fn_parse_mzml_path parse_mzml_path;
+  fn_parse_mzml_filtered parse_mzml_filtered;
+  fn_parse_mzml_path_filtered parse_mzml_path_filtered;
+  fn_convert_mzml_to_bin1 convert_mzml_to_bin1;
   fn_bin_to_json bin_to_json;
   fn_get_peak get_peak;
   fn_calculate_eic calculate_eic;
+  fn_calculate_eics calculate_eics;
   fn_find_noise_level find_noise_level;
   fn_get_peaks_from_eic C_get_peaks_from_eic;
   fn_get_peaks_from_chrom C_get_peaks_from_chrom;
   fn_find_peaks find_peaks;
   fn_calculate_baseline calculate_baseline;
   fn_find_features find_features;
+  fn_find_features_path find_features_path;
+  fn_session_open session_open;
+  fn_session_close session_close;
+  fn_session_calculate_eic session_calculate_eic;
+  fn_session_calculate_eics session_calculate_eics;
+  fn_session_get_peaks_from_eic session_get_peaks_from_eic;
+  fn_session_get_peaks_from_chrom session_get_peaks_from_chrom;
+  fn_set_threads set_threads;
   fn_free_ free_;
 } msabi_t;
 
@@ -157,7 +243,25 @@ static int abi_load(const char *path, const char **err)
   if (resolve_required((void **)&ABI.find_features, "find_features"))
     goto fail;
 
+  ABI.parse_mzml_path = (fn_parse_mzml_path)DLSYM(LIB_HANDLE, "parse_mzml_path");
+  ABI.parse_mzml_filtered = (fn_parse_mzml_filtered)DLSYM(LIB_HANDLE, "parse_mzml_filtered");
+  ABI.parse_mzml_path_filtered =
+      (fn_parse_mzml_path_filtered)DLSYM(LIB_HANDLE, "parse_mzml_path_filtered");
+  ABI.find_features_path = (fn_find_features_path)DLSYM(LIB_HANDLE, "find_features_path");
+  ABI.convert_mzml_to_bin1 = (fn_convert_mzml_to_bin1)DLSYM(LIB_HANDLE, "convert_mzml_to_bin1");
   ABI.find_noise_level = (fn_find_noise_level)DLSYM(LIB_HANDLE, "find_noise_level");
+  ABI.calculate_eics = (fn_calculate_eics)DLSYM(LIB_HANDLE, "calculate_eics");
+  ABI.session_open = (fn_session_open)DLSYM(LIB_HANDLE, "msut_session_open");
+  ABI.session_close = (fn_session_close)DLSYM(LIB_HANDLE, "msut_session_close");
+  ABI.session_calculate_eic =
+      (fn_session_calculate_eic)DLSYM(LIB_HANDLE, "msut_session_calculate_eic");
+  ABI.session_calculate_eics =
+      (fn_session_calculate_eics)DLSYM(LIB_HANDLE, "msut_session_calculate_eics");
+  ABI.session_get_peaks_from_eic =
+      (fn_session_get_peaks_from_eic)DLSYM(LIB_HANDLE, "msut_session_get_peaks_from_eic");
+  ABI.session_get_peaks_from_chrom =
+      (fn_session_get_peaks_from_chrom)DLSYM(LIB_HANDLE, "msut_session_get_peaks_from_chrom");
+  ABI.set_threads = (fn_set_threads)DLSYM(LIB_HANDLE, "msut_set_threads");
   ABI.free_ = (fn_free_)DLSYM(LIB_HANDLE, "free_");
   if (!ABI.free_)
     goto fail;
@@ -194,8 +298,12 @@ static const char *CodeMessage(int32_t code)
     return "invalid arguments";
   if (code == 2)
     return "panic inside Rust";
+  if (code == 3)
+    return "i/o error";
   if (code == 4)
     return "parse error";
+  if (code == 5)
+    return "cancelled";
   return "unknown";
 }
 
@@ -232,6 +340,309 @@ static void ThrowIfMissing(Napi::Env env, void *fn_ptr, const char *name)
   }
 }
 
+static size_t ReadCores(const Napi::CallbackInfo &info, size_t i)
+{
+  size_t cores = 1;
+  if (info.Length() > i && info[i].IsNumber())
+  {
+    int64_t v = info[i].As<Napi::Number>().Int64Value();
+    if (v > 0)
+      cores = (size_t)v;
+  }
+  return cores;
+}
+
+static const double *OptionalDoubles(const Napi::CallbackInfo &info, size_t i, size_t count)
+{
+  if (info.Length() <= i || !info[i].IsTypedArray())
+    return nullptr;
+  Napi::Float64Array arr = info[i].As<Napi::Float64Array>();
+  if (arr.ElementLength() != count)
+    return nullptr;
+  return (const double *)((uint8_t *)arr.ArrayBuffer().Data() + arr.ByteOffset());
+}
+
+typedef struct
+{
+  std::vector<uint32_t> offs;
+  std::vector<uint32_t> lens;
+  std::vector<unsigned char> buf;
+} PackedIds;
+
+static bool PackIds(const Napi::CallbackInfo &info, size_t i, size_t count, PackedIds *out)
+{
+  if (info.Length() <= i || info[i].IsUndefined() || info[i].IsNull())
+    return false;
+  Napi::Array ids = info[i].As<Napi::Array>();
+  out->offs.assign(count, 0);
+  out->lens.assign(count, 0);
+  std::vector<std::string> tmp;
+  tmp.reserve(count);
+  size_t total = 0;
+  for (size_t k = 0; k < count; k++)
+  {
+    Napi::Value v = ids.Get((uint32_t)k);
+    if (v.IsString())
+    {
+      std::string s = v.As<Napi::String>().Utf8Value();
+      total += s.size();
+      tmp.push_back(std::move(s));
+    }
+    else
+    {
+      tmp.emplace_back();
+    }
+  }
+  out->buf.resize(total);
+  size_t cur = 0;
+  for (size_t k = 0; k < count; k++)
+  {
+    const std::string &s = tmp[k];
+    out->offs[k] = (uint32_t)cur;
+    out->lens[k] = (uint32_t)s.size();
+    if (!s.empty())
+    {
+      memcpy(out->buf.data() + cur, s.data(), s.size());
+      cur += s.size();
+    }
+  }
+  return true;
+}
+
+typedef struct
+{
+  std::vector<double> ppm;
+  std::vector<double> mz;
+} Tolerances;
+
+static std::vector<double> ReadDoubles(Napi::Value value)
+{
+  if (value.IsNumber())
+    return std::vector<double>(1, value.As<Napi::Number>().DoubleValue());
+  Napi::Float64Array arr = value.As<Napi::Float64Array>();
+  const double *p = (const double *)((uint8_t *)arr.ArrayBuffer().Data() + arr.ByteOffset());
+  return std::vector<double>(p, p + arr.ElementLength());
+}
+
+static bool ReadTolerances(Napi::Env env, Napi::Value ppm, Napi::Value mz, Tolerances *t)
+{
+  t->ppm = ReadDoubles(ppm);
+  t->mz = ReadDoubles(mz);
+  size_t n = t->ppm.size() > t->mz.size() ? t->ppm.size() : t->mz.size();
+  if ((t->ppm.size() != n && t->ppm.size() != 1) || (t->mz.size() != n && t->mz.size() != 1))
+  {
+    Napi::TypeError::New(env, "ppm and mz tolerances must have the same length, or one of them a single value")
+        .ThrowAsJavaScriptException();
+    return false;
+  }
+  if (t->ppm.size() == 1)
+    t->ppm.resize(n, t->ppm[0]);
+  if (t->mz.size() == 1)
+    t->mz.resize(n, t->mz[0]);
+  return true;
+}
+
+static Napi::Value TakeJson(Napi::Env env, int32_t rc, Buf *out, const char *name)
+{
+  if (rc != 0)
+  {
+    if (out->ptr && ABI.free_)
+      ABI.free_(out->ptr, out->len);
+    std::string msg = name;
+    msg += ": ";
+    msg += CodeMessage(rc);
+    Napi::Error::New(env, msg).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  std::string json_text((const char *)out->ptr, out->len);
+  if (ABI.free_)
+    ABI.free_(out->ptr, out->len);
+  return Napi::String::New(env, json_text);
+}
+
+typedef std::function<int32_t(const CProgress *, Buf *)> NativeCall;
+
+typedef struct
+{
+  double fraction;
+  std::string stage;
+} ProgressEvent;
+
+class NativeWorker : public Napi::AsyncWorker
+{
+public:
+  NativeWorker(const Napi::CallbackInfo &info, const char *name, NativeCall call, Napi::Object control)
+      : Napi::AsyncWorker(info.Env(), name),
+        deferred_(Napi::Promise::Deferred::New(info.Env())),
+        name_(name),
+        call_(std::move(call)),
+        cancel_(std::make_shared<std::atomic<int32_t>>(0))
+  {
+    Napi::Env env = info.Env();
+    for (size_t i = 0; i < info.Length(); i++)
+      if (info[i].IsObject())
+        keep_.push_back(Napi::Persistent(info[i].As<Napi::Object>()));
+
+    Napi::Value on_progress = control.Get("onProgress");
+    if (on_progress.IsFunction())
+    {
+      progress_ = Napi::ThreadSafeFunction::New(env, on_progress.As<Napi::Function>(), "msut_progress", 0, 1);
+      has_progress_ = true;
+    }
+
+    Napi::Value signal = control.Get("signal");
+    if (signal.IsObject())
+    {
+      Napi::Object s = signal.As<Napi::Object>();
+      if (s.Get("aborted").ToBoolean())
+        cancel_->store(1);
+      std::shared_ptr<std::atomic<int32_t>> cancel = cancel_;
+      auto on_abort = [cancel](const Napi::CallbackInfo &info)
+      {
+        cancel->store(1);
+        return info.Env().Undefined();
+      };
+      Napi::Function listener = Napi::Function::New(env, on_abort);
+      Napi::Object once = Napi::Object::New(env);
+      once.Set("once", Napi::Boolean::New(env, true));
+      s.Get("addEventListener").As<Napi::Function>().Call(s, {Napi::String::New(env, "abort"), listener, once});
+      signal_ = Napi::Persistent(s);
+      on_abort_ = Napi::Persistent(listener);
+    }
+  }
+
+  Napi::Promise Promise() { return deferred_.Promise(); }
+
+protected:
+  void Execute() override
+  {
+    CProgress progress = {has_progress_ ? Report : nullptr, this, (const int32_t *)cancel_.get()};
+    rc_ = call_(&progress, &out_);
+  }
+
+  void OnOK() override
+  {
+    Napi::Env env = Env();
+    Finish();
+    if (rc_ != 0)
+    {
+      if (out_.ptr && ABI.free_)
+        ABI.free_(out_.ptr, out_.len);
+      std::string msg = name_;
+      msg += ": ";
+      msg += CodeMessage(rc_);
+      deferred_.Reject(Napi::Error::New(env, msg).Value());
+      return;
+    }
+    std::string json_text((const char *)out_.ptr, out_.len);
+    if (ABI.free_)
+      ABI.free_(out_.ptr, out_.len);
+    deferred_.Resolve(Napi::String::New(env, json_text));
+  }
+
+  void OnError(const Napi::Error &e) override
+  {
+    Finish();
+    deferred_.Reject(e.Value());
+  }
+
+private:
+  void Finish()
+  {
+    if (has_progress_)
+      progress_.Release();
+    has_progress_ = false;
+    if (signal_.IsEmpty())
+      return;
+    Napi::Object s = signal_.Value();
+    Napi::Value remove = s.Get("removeEventListener");
+    if (remove.IsFunction())
+      remove.As<Napi::Function>().Call(s, {Napi::String::New(Env(), "abort"), on_abort_.Value()});
+    signal_.Reset();
+    on_abort_.Reset();
+  }
+
+  static void Report(void *self, double fraction, const char *stage)
+  {
+    NativeWorker *worker = (NativeWorker *)self;
+    auto emit = [](Napi::Env env, Napi::Function cb, ProgressEvent *e)
+    {
+      cb.Call({Napi::Number::New(env, e->fraction), Napi::String::New(env, e->stage)});
+      delete e;
+    };
+    ProgressEvent *event = new ProgressEvent{fraction, stage};
+    if (worker->progress_.NonBlockingCall(event, emit) != napi_ok)
+      delete event;
+  }
+
+  Napi::Promise::Deferred deferred_;
+  std::string name_;
+  NativeCall call_;
+  std::shared_ptr<std::atomic<int32_t>> cancel_;
+  std::vector<Napi::ObjectReference> keep_;
+  Napi::ObjectReference signal_;
+  Napi::FunctionReference on_abort_;
+  Napi::ThreadSafeFunction progress_;
+  bool has_progress_ = false;
+  int32_t rc_ = 0;
+  Buf out_ = {nullptr, 0};
+};
+
+static Napi::Value RunNative(const Napi::CallbackInfo &info, size_t i, const char *name, NativeCall call)
+{
+  Napi::Env env = info.Env();
+  if (info.Length() <= i || !info[i].IsObject())
+  {
+    Buf out = {nullptr, 0};
+    int32_t rc = call(nullptr, &out);
+    return TakeJson(env, rc, &out, name);
+  }
+  Napi::Object control = info[i].As<Napi::Object>();
+  Napi::Value signal = control.Get("signal");
+  if (signal.IsObject() && !signal.As<Napi::Object>().Get("addEventListener").IsFunction())
+  {
+    Napi::TypeError::New(env, "signal must be an AbortSignal").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  NativeWorker *worker = new NativeWorker(info, name, std::move(call), control);
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+static Napi::Value TakeEic(Napi::Env env, int32_t rc, Buf *x_buf, Buf *y_buf, const char *name)
+{
+  if (rc != 0)
+  {
+    if (x_buf->ptr && ABI.free_)
+      ABI.free_(x_buf->ptr, x_buf->len);
+    if (y_buf->ptr && ABI.free_)
+      ABI.free_(y_buf->ptr, y_buf->len);
+    std::string msg = name;
+    msg += ": ";
+    msg += CodeMessage(rc);
+    Napi::Error::New(env, msg).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  size_t nx = x_buf->len / 8, ny = y_buf->len / 8;
+  Napi::ArrayBuffer abx = Napi::ArrayBuffer::New(env, nx * 8);
+  Napi::ArrayBuffer aby = Napi::ArrayBuffer::New(env, ny * 8);
+  memcpy(abx.Data(), x_buf->ptr, nx * 8);
+  memcpy(aby.Data(), y_buf->ptr, ny * 8);
+  if (ABI.free_)
+  {
+    ABI.free_(x_buf->ptr, x_buf->len);
+    ABI.free_(y_buf->ptr, y_buf->len);
+  }
+  Napi::Float64Array X = Napi::Float64Array::New(env, nx, abx, 0);
+  Napi::Float64Array Y = Napi::Float64Array::New(env, ny, aby, 0);
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("x", X);
+  out.Set("y", Y);
+  return out;
+}
+
 static Napi::Value Bind(const Napi::CallbackInfo &info)
 {
   Napi::Env env = info.Env();
@@ -253,14 +664,112 @@ static Napi::Value Bind(const Napi::CallbackInfo &info)
   return env.Undefined();
 }
 
+static bool ReadParseFilter(Napi::Env env, Napi::Object o, CParseFilter *f, std::vector<uint8_t> *levels)
+{
+  const double open = std::numeric_limits<double>::quiet_NaN();
+  *f = {nullptr, 0, open, open, -1, 1, 1, 1};
+  Napi::Value ms = o.Get("msLevels");
+  if (!ms.IsUndefined() && !ms.IsNull())
+  {
+    if (!ms.IsArray())
+    {
+      Napi::TypeError::New(env, "msLevels must be an array of numbers").ThrowAsJavaScriptException();
+      return false;
+    }
+    Napi::Array arr = ms.As<Napi::Array>();
+    for (uint32_t k = 0; k < arr.Length(); k++)
+    {
+      Napi::Value v = arr.Get(k);
+      int32_t level = v.IsNumber() ? v.As<Napi::Number>().Int32Value() : -1;
+      if (level < 1 || level > 255)
+      {
+        Napi::TypeError::New(env, "msLevels must hold integers in 1..255").ThrowAsJavaScriptException();
+        return false;
+      }
+      levels->push_back((uint8_t)level);
+    }
+    f->ms_levels = levels->data();
+    f->ms_levels_len = levels->size();
+  }
+  Napi::Value ft = o.Get("fromTo");
+  if (ft.IsObject())
+  {
+    Napi::Object w = ft.As<Napi::Object>();
+    if (w.Get("from").IsNumber())
+      f->rt_from = w.Get("from").As<Napi::Number>().DoubleValue();
+    if (w.Get("to").IsNumber())
+      f->rt_to = w.Get("to").As<Napi::Number>().DoubleValue();
+  }
+  Napi::Value pol = o.Get("polarity");
+  if (pol.IsString())
+  {
+    std::string p = pol.As<Napi::String>();
+    if (p == "positive")
+      f->polarity = 0;
+    else if (p == "negative")
+      f->polarity = 1;
+    else
+    {
+      Napi::TypeError::New(env, "polarity must be \"positive\" or \"negative\"").ThrowAsJavaScriptException();
+      return false;
+    }
+  }
+  if (o.Has("mzArray"))
+    f->mz_array = o.Get("mzArray").ToBoolean() ? 1 : 0;
+  if (o.Has("intensityArray"))
+    f->intensity_array = o.Get("intensityArray").ToBoolean() ? 1 : 0;
+  if (o.Has("chromatograms"))
+    f->chromatograms = o.Get("chromatograms").ToBoolean() ? 1 : 0;
+  return true;
+}
+
 static Napi::Value ParseMzML(const Napi::CallbackInfo &info)
 {
   Napi::Env env = info.Env();
-  ThrowIfMissing(env, (void *)ABI.parse_mzml, "parse_mzml");
   ThrowIfMissing(env, (void *)ABI.free_, "free_");
-  Napi::Buffer<uint8_t> input = info[0].As<Napi::Buffer<uint8_t>>();
+
+  size_t cores = ReadCores(info, 1);
+
+  CParseFilter filter;
+  std::vector<uint8_t> levels;
+  const CParseFilter *fp = nullptr;
+  if (info.Length() > 2 && info[2].IsObject())
+  {
+    if (!ReadParseFilter(env, info[2].As<Napi::Object>(), &filter, &levels))
+      return env.Undefined();
+    fp = &filter;
+  }
+
   Buf out = {nullptr, 0};
-  int32_t rc = ABI.parse_mzml(input.Data(), (size_t)input.Length(), &out);
+  int32_t rc;
+  if (info[0].IsString())
+  {
+    std::string path = info[0].As<Napi::String>();
+    if (fp)
+    {
+      ThrowIfMissing(env, (void *)ABI.parse_mzml_path_filtered, "parse_mzml_path_filtered");
+      rc = ABI.parse_mzml_path_filtered(path.c_str(), cores, fp, &out);
+    }
+    else
+    {
+      ThrowIfMissing(env, (void *)ABI.parse_mzml_path, "parse_mzml_path");
+      rc = ABI.parse_mzml_path(path.c_str(), cores, &out);
+    }
+  }
+  else
+  {
+    Napi::Buffer<uint8_t> input = info[0].As<Napi::Buffer<uint8_t>>();
+    if (fp)
+    {
+      ThrowIfMissing(env, (void *)ABI.parse_mzml_filtered, "parse_mzml_filtered");
+      rc = ABI.parse_mzml_filtered(input.Data(), (size_t)input.Length(), cores, fp, &out);
+    }
+    else
+    {
+      ThrowIfMissing(env, (void *)ABI.parse_mzml, "parse_mzml");
+      rc = ABI.parse_mzml(input.Data(), (size_t)input.Length(), cores, &out);
+    }
+  }
   if (rc != 0)
   {
     if (out.ptr && ABI.free_)
@@ -273,6 +782,37 @@ static Napi::Value ParseMzML(const Napi::CallbackInfo &info)
   return TakeBuffer(env, &out);
 }
 
+static Napi::Value ConvertMzMLToBin1(const Napi::CallbackInfo &info)
+{
+  Napi::Env env = info.Env();
+  ThrowIfMissing(env, (void *)ABI.convert_mzml_to_bin1, "convert_mzml_to_bin1");
+  if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString())
+  {
+    Napi::TypeError::New(env, "expected: (string src, string dst, number windowBytes?)")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  std::string src = info[0].As<Napi::String>();
+  std::string dst = info[1].As<Napi::String>();
+
+  size_t window = 0;
+  if (info.Length() > 2 && info[2].IsNumber())
+  {
+    int64_t v = info[2].As<Napi::Number>().Int64Value();
+    if (v > 0)
+      window = (size_t)v;
+  }
+
+  int32_t rc = ABI.convert_mzml_to_bin1(src.c_str(), dst.c_str(), window);
+  if (rc != 0)
+  {
+    std::string msg = "convert_mzml_to_bin1: ";
+    msg += CodeMessage(rc);
+    Napi::Error::New(env, msg).ThrowAsJavaScriptException();
+  }
+  return env.Undefined();
+}
+
 static Napi::Value BinToJson(const Napi::CallbackInfo &info)
 {
   Napi::Env env = info.Env();
@@ -345,6 +885,7 @@ static Napi::Value CalculateEic(const Napi::CallbackInfo &info)
   double to_rt = info[3].As<Napi::Number>().DoubleValue();
   double ppm_tol = info[4].As<Napi::Number>().DoubleValue();
   double mz_tol = info[5].As<Napi::Number>().DoubleValue();
+  size_t cores = ReadCores(info, 6);
 
   Buf x_buf = {nullptr, 0};
   Buf y_buf = {nullptr, 0};
@@ -352,35 +893,36 @@ static Napi::Value CalculateEic(const Napi::CallbackInfo &info)
       bin.Data(), (size_t)bin.Length(),
       targets,
       from_rt, to_rt, ppm_tol, mz_tol,
+      cores,
       &x_buf, &y_buf);
-  if (rc != 0)
-  {
-    if (x_buf.ptr && ABI.free_)
-      ABI.free_(x_buf.ptr, x_buf.len);
-    if (y_buf.ptr && ABI.free_)
-      ABI.free_(y_buf.ptr, y_buf.len);
-    std::string msg = "calculate_eic: ";
-    msg += CodeMessage(rc);
-    Napi::Error::New(env, msg).ThrowAsJavaScriptException();
+  return TakeEic(env, rc, &x_buf, &y_buf, "calculate_eic");
+}
+
+static Napi::Value CalculateEics(const Napi::CallbackInfo &info)
+{
+  Napi::Env env = info.Env();
+  ThrowIfMissing(env, (void *)ABI.calculate_eics, "calculate_eics");
+  ThrowIfMissing(env, (void *)ABI.free_, "free_");
+
+  Napi::Buffer<uint8_t> bin = info[0].As<Napi::Buffer<uint8_t>>();
+  Napi::Float64Array targets_arr = info[1].As<Napi::Float64Array>();
+  double from_rt = info[2].As<Napi::Number>().DoubleValue();
+  double to_rt = info[3].As<Napi::Number>().DoubleValue();
+  Tolerances tol;
+  if (!ReadTolerances(env, info[4], info[5], &tol))
     return env.Undefined();
-  }
 
-  size_t nx = x_buf.len / 8, ny = y_buf.len / 8;
-  Napi::ArrayBuffer abx = Napi::ArrayBuffer::New(env, nx * 8);
-  Napi::ArrayBuffer aby = Napi::ArrayBuffer::New(env, ny * 8);
-  memcpy(abx.Data(), x_buf.ptr, nx * 8);
-  memcpy(aby.Data(), y_buf.ptr, ny * 8);
-  if (ABI.free_)
-  {
-    ABI.free_(x_buf.ptr, x_buf.len);
-    ABI.free_(y_buf.ptr, y_buf.len);
-  }
-  Napi::Float64Array X = Napi::Float64Array::New(env, nx, abx, 0);
-  Napi::Float64Array Y = Napi::Float64Array::New(env, ny, aby, 0);
-  Napi::Object out = Napi::Object::New(env);
-  out.Set("x", X);
-  out.Set("y", Y);
-  return out;
+  const double *targets = (const double *)((uint8_t *)targets_arr.ArrayBuffer().Data() + targets_arr.ByteOffset());
+
+  Buf x_buf = {nullptr, 0};
+  Buf y_buf = {nullptr, 0};
+  int32_t rc = ABI.calculate_eics(
+      bin.Data(), (size_t)bin.Length(),
+      targets, targets_arr.ElementLength(),
+      tol.ppm.data(), tol.mz.data(), tol.ppm.size(),
+      from_rt, to_rt,
+      &x_buf, &y_buf);
+  return TakeEic(env, rc, &x_buf, &y_buf, "calculate_eics");
 }
 
 static Napi::Value FindNoiseLevel(const Napi::CallbackInfo &info)
@@ -393,6 +935,38 @@ static Napi::Value FindNoiseLevel(const Napi::CallbackInfo &info)
   return Napi::Number::New(env, value);
 }
 
+static Napi::Value SetThreads(const Napi::CallbackInfo &info)
+{
+  Napi::Env env = info.Env();
+  ThrowIfMissing(env, (void *)ABI.set_threads, "msut_set_threads");
+
+  if (info.Length() < 1 || !info[0].IsNumber())
+  {
+    Napi::TypeError::New(env, "expected: (number threads, Int32Array? cpus)")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  int32_t threads = info[0].As<Napi::Number>().Int32Value();
+
+  const int32_t *cpus = nullptr;
+  size_t n_cpus = 0;
+  if (info.Length() > 1 && info[1].IsTypedArray())
+  {
+    Napi::Int32Array arr = info[1].As<Napi::Int32Array>();
+    cpus = (const int32_t *)((uint8_t *)arr.ArrayBuffer().Data() + arr.ByteOffset());
+    n_cpus = arr.ElementLength();
+  }
+
+  int32_t rc = ABI.set_threads(threads, cpus, n_cpus);
+  if (rc != 0)
+  {
+    std::string msg = "msut_set_threads: ";
+    msg += CodeMessage(rc);
+    Napi::Error::New(env, msg).ThrowAsJavaScriptException();
+  }
+  return env.Undefined();
+}
+
 static Napi::Value GetPeaksFromEic(const Napi::CallbackInfo &info)
 {
   Napi::Env env = info.Env();
@@ -408,96 +982,35 @@ static Napi::Value GetPeaksFromEic(const Napi::CallbackInfo &info)
   const double *mzs = (const double *)((uint8_t *)mzs_arr.ArrayBuffer().Data() + mzs_arr.ByteOffset());
   const double *rng = (const double *)((uint8_t *)rng_arr.ArrayBuffer().Data() + rng_arr.ByteOffset());
   size_t count = rts_arr.ElementLength();
+  const double *froms = OptionalDoubles(info, 4, count);
+  const double *tos = OptionalDoubles(info, 5, count);
 
-  const uint32_t *offs_ptr = nullptr;
-  const uint32_t *lens_ptr = nullptr;
-  const unsigned char *ids_buf_ptr = nullptr;
-  size_t ids_buf_len = 0;
+  PackedIds ids;
+  bool has_ids = PackIds(info, 6, count, &ids);
 
-  Napi::Buffer<uint32_t> offs_js;
-  Napi::Buffer<uint32_t> lens_js;
-  Napi::Buffer<unsigned char> ids_js;
+  double from_left = info[7].As<Napi::Number>().DoubleValue();
+  double to_right = info[8].As<Napi::Number>().DoubleValue();
 
-  if (info.Length() > 4 && !info[4].IsUndefined() && !info[4].IsNull())
-  {
-    Napi::Array ids = info[4].As<Napi::Array>();
-    std::vector<uint32_t> offs(count, 0);
-    std::vector<uint32_t> lens(count, 0);
-    size_t total = 0;
-    std::vector<std::string> tmp;
-    tmp.reserve(count);
-    for (size_t i = 0; i < count; i++)
-    {
-      Napi::Value v = ids.Get((uint32_t)i);
-      if (v.IsString())
-      {
-        std::string s = v.As<Napi::String>().Utf8Value();
-        total += s.size();
-        tmp.push_back(std::move(s));
-      }
-      else
-      {
-        tmp.emplace_back();
-      }
-    }
-    std::vector<unsigned char> ids_buf;
-    ids_buf.resize(total);
-    size_t cur = 0;
-    for (size_t i = 0; i < count; i++)
-    {
-      const std::string &s = tmp[i];
-      offs[i] = (uint32_t)cur;
-      lens[i] = (uint32_t)s.size();
-      if (!s.empty())
-      {
-        memcpy(ids_buf.data() + cur, s.data(), s.size());
-        cur += s.size();
-      }
-    }
-    offs_js = Napi::Buffer<uint32_t>::Copy(env, offs.data(), offs.size());
-    lens_js = Napi::Buffer<uint32_t>::Copy(env, lens.data(), lens.size());
-    ids_js = Napi::Buffer<unsigned char>::Copy(env, ids_buf.data(), ids_buf.size());
-    offs_ptr = (const uint32_t *)offs_js.Data();
-    lens_ptr = (const uint32_t *)lens_js.Data();
-    ids_buf_ptr = (const unsigned char *)ids_js.Data();
-    ids_buf_len = ids_js.Length();
-  }
-
-  double from_left = info[5].As<Napi::Number>().DoubleValue();
-  double to_right = info[6].As<Napi::Number>().DoubleValue();
+  CPeakPOptions opts = {};
+  bool has_opts = info.Length() > 9 && ReadOptionsBuf(info[9], &opts) != nullptr;
 
-  CPeakPOptions opts;
-  const CPeakPOptions *p_opts = nullptr;
-  if (info.Length() > 7)
-    p_opts = ReadOptionsBuf(info[7], &opts);
+  size_t cores = ReadCores(info, 10);
 
-  size_t cores = 1;
-  if (info.Length() > 8 && info[8].IsNumber())
-  {
-    int64_t v = info[8].As<Napi::Number>().Int64Value();
-    if (v > 0)
-      cores = (size_t)v;
-  }
-
-  Buf out = {nullptr, 0};
-  int32_t rc = ABI.C_get_peaks_from_eic(
-      bin.Data(), (size_t)bin.Length(),
-      rts, mzs, rng,
-      offs_ptr, lens_ptr, ids_buf_ptr, ids_buf_len,
-      count, from_left, to_right, p_opts, cores, &out);
-  if (rc != 0)
+  const uint8_t *data = bin.Data();
+  size_t len = (size_t)bin.Length();
+  NativeCall call = [=](const CProgress *progress, Buf *out)
   {
-    if (out.ptr && ABI.free_)
-      ABI.free_(out.ptr, out.len);
-    std::string msg = "get_peaks_from_eic: ";
-    msg += CodeMessage(rc);
-    Napi::Error::New(env, msg).ThrowAsJavaScriptException();
-    return env.Undefined();
-  }
-  std::string json_text((const char *)out.ptr, out.len);
-  if (ABI.free_)
-    ABI.free_(out.ptr, out.len);
-  return Napi::String::New(env, json_text);
+    return ABI.C_get_peaks_from_eic(
+        data, len,
+        rts, mzs, rng,
+        froms, tos,
+        has_ids ? ids.offs.data() : nullptr,
+        has_ids ? ids.lens.data() : nullptr,
+        has_ids ? ids.buf.data() : nullptr,
+        ids.buf.size(),
+        count, from_left, to_right, has_opts ? &opts : nullptr, cores, progress, out);
+  };
+  return RunNative(info, 11, "get_peaks_from_eic", call);
 }
 
 static Napi::Value GetPeaksFromChrom(const Napi::CallbackInfo &info)
@@ -521,32 +1034,14 @@ static Napi::Value GetPeaksFromChrom(const Napi::CallbackInfo &info)
   if (info.Length() > 4)
     p_opts = ReadOptionsBuf(info[4], &opts);
 
-  size_t cores = 1;
-  if (info.Length() > 5 && info[5].IsNumber())
-  {
-    int64_t v = info[5].As<Napi::Number>().Int64Value();
-    if (v > 0)
-      cores = (size_t)v;
-  }
+  size_t cores = ReadCores(info, 5);
 
   Buf out = {nullptr, 0};
   int32_t rc = ABI.C_get_peaks_from_chrom(
       bin.Data(), (size_t)bin.Length(),
       idx, rts, rng, count,
       p_opts, cores, &out);
-  if (rc != 0)
-  {
-    if (out.ptr && ABI.free_)
-      ABI.free_(out.ptr, out.len);
-    std::string msg = "get_peaks_from_chrom: ";
-    msg += CodeMessage(rc);
-    Napi::Error::New(env, msg).ThrowAsJavaScriptException();
-    return env.Undefined();
-  }
-  std::string json_text((const char *)out.ptr, out.len);
-  if (ABI.free_)
-    ABI.free_(out.ptr, out.len);
-  return Napi::String::New(env, json_text);
+  return TakeJson(env, rc, &out, "get_peaks_from_chrom");
 }
 
 static Napi::Value FindPeaks(const Napi::CallbackInfo &info)
@@ -642,19 +1137,18 @@ static Napi::Value CalculateBaseline(const Napi::CallbackInfo &info)
 static Napi::Value FindFeatures(const Napi::CallbackInfo &info)
 {
   Napi::Env env = info.Env();
-  ThrowIfMissing(env, (void *)ABI.find_features, "find_features");
   ThrowIfMissing(env, (void *)ABI.free_, "free_");
 
-  if (info.Length() < 10)
+  if (info.Length() < 12)
   {
     Napi::TypeError::New(env,
-                         "expected: (Buffer data, number from, number to, number eicPpm, number eicMz, "
-                         "number gridStart, number gridEnd, number gridStepPpm, Buffer|null options, number cores)")
+                         "expected: (Buffer|string data, number from, number to, number eicPpm, number eicMz, "
+                         "number gridStart, number gridEnd, number gridStepPpm, number engine, number tracePpm, "
+                         "Buffer|null options, number cores, {onProgress, signal}?)")
         .ThrowAsJavaScriptException();
     return env.Undefined();
   }
 
-  Napi::Buffer<uint8_t> data = info[0].As<Napi::Buffer<uint8_t>>();
   double from_time = info[1].As<Napi::Number>().DoubleValue();
   double to_time = info[2].As<Napi::Number>().DoubleValue();
   double eic_ppm = info[3].As<Napi::Number>().DoubleValue();
@@ -662,18 +1156,20 @@ static Napi::Value FindFeatures(const Napi::CallbackInfo &info)
   double grid_start = info[5].As<Napi::Number>().DoubleValue();
   double grid_end = info[6].As<Napi::Number>().DoubleValue();
   double grid_step = info[7].As<Napi::Number>().DoubleValue();
+  int32_t engine = info[8].As<Napi::Number>().Int32Value();
+  double trace_ppm = info[9].As<Napi::Number>().DoubleValue();
 
-  CPeakPOptions opts;
+  CPeakPOptions opts = {};
   const CPeakPOptions *p_opts = nullptr;
-  if (!info[8].IsUndefined() && !info[8].IsNull())
+  if (!info[10].IsUndefined() && !info[10].IsNull())
   {
-    if (!info[8].IsBuffer())
+    if (!info[10].IsBuffer())
     {
       Napi::TypeError::New(env, "options must be a Buffer, null, or undefined")
           .ThrowAsJavaScriptException();
       return env.Undefined();
     }
-    p_opts = ReadOptionsBuf(info[8], &opts);
+    p_opts = ReadOptionsBuf(info[10], &opts);
     if (p_opts == nullptr)
     {
       Napi::TypeError::New(env, "options Buffer must be exactly 64 bytes")
@@ -682,56 +1178,267 @@ static Napi::Value FindFeatures(const Napi::CallbackInfo &info)
     }
   }
 
-  if (!info[9].IsNumber())
+  if (!info[11].IsNumber())
   {
     Napi::TypeError::New(env, "cores must be a positive integer")
         .ThrowAsJavaScriptException();
     return env.Undefined();
   }
-  int32_t cores = info[9].As<Napi::Number>().Int32Value();
+  int32_t cores = info[11].As<Napi::Number>().Int32Value();
   if (cores <= 0)
   {
     Napi::TypeError::New(env, "cores must be > 0").ThrowAsJavaScriptException();
     return env.Undefined();
   }
 
-  Buf out = {nullptr, 0};
-  int32_t rc = ABI.find_features(
-      data.Data(), (size_t)data.Length(),
-      from_time, to_time,
-      eic_ppm, eic_mz,
-      grid_start, grid_end, grid_step,
-      p_opts, cores, &out);
+  bool has_opts = p_opts != nullptr;
+  NativeCall call;
+  if (info[0].IsString())
+  {
+    ThrowIfMissing(env, (void *)ABI.find_features_path, "find_features_path");
+    std::string path = info[0].As<Napi::String>();
+    call = [=](const CProgress *progress, Buf *out)
+    {
+      return ABI.find_features_path(
+          path.c_str(),
+          from_time, to_time,
+          eic_ppm, eic_mz,
+          grid_start, grid_end, grid_step,
+          engine, trace_ppm,
+          has_opts ? &opts : nullptr, cores, progress, out);
+    };
+  }
+  else
+  {
+    ThrowIfMissing(env, (void *)ABI.find_features, "find_features");
+    Napi::Buffer<uint8_t> data = info[0].As<Napi::Buffer<uint8_t>>();
+    const uint8_t *ptr = data.Data();
+    size_t len = (size_t)data.Length();
+    call = [=](const CProgress *progress, Buf *out)
+    {
+      return ABI.find_features(
+          ptr, len,
+          from_time, to_time,
+          eic_ppm, eic_mz,
+          grid_start, grid_end, grid_step,
+          engine, trace_ppm,
+          has_opts ? &opts : nullptr, cores, progress, out);
+    };
+  }
+  return RunNative(info, 12, "find_features", call);
+}
 
-  if (rc != 0)
+class Session : public Napi::ObjectWrap<Session>
+{
+public:
+  static Napi::Function Define(Napi::Env env)
   {
-    if (out.ptr && ABI.free_)
-      ABI.free_(out.ptr, out.len);
-    std::string msg = "find_features: ";
-    msg += CodeMessage(rc);
-    Napi::Error::New(env, msg).ThrowAsJavaScriptException();
-    return env.Undefined();
+    return DefineClass(env, "Session",
+                       {InstanceMethod("calculateEic", &Session::CalculateEic),
+                        InstanceMethod("calculateEics", &Session::CalculateEics),
+                        InstanceMethod("getPeaksFromEic", &Session::GetPeaksFromEic),
+                        InstanceMethod("getPeaksFromChrom", &Session::GetPeaksFromChrom),
+                        InstanceMethod("close", &Session::Close)});
   }
 
-  std::string json_text((const char *)out.ptr, out.len);
-  if (ABI.free_)
-    ABI.free_(out.ptr, out.len);
-  return Napi::String::New(env, json_text);
-}
+  Session(const Napi::CallbackInfo &info) : Napi::ObjectWrap<Session>(info)
+  {
+    Napi::Env env = info.Env();
+    if (!ABI.session_open || !ABI.session_close)
+    {
+      Napi::Error::New(env, "native symbol not exported: msut_session_open")
+          .ThrowAsJavaScriptException();
+      return;
+    }
+    if (info.Length() < 1 || !info[0].IsBuffer())
+    {
+      Napi::TypeError::New(env, "expected: Buffer bin").ThrowAsJavaScriptException();
+      return;
+    }
+    Napi::Buffer<uint8_t> bin = info[0].As<Napi::Buffer<uint8_t>>();
+    int32_t rc = ABI.session_open(bin.Data(), (size_t)bin.Length(), &handle_);
+    if (rc != 0)
+    {
+      handle_ = nullptr;
+      std::string msg = "session_open: ";
+      msg += CodeMessage(rc);
+      Napi::Error::New(env, msg).ThrowAsJavaScriptException();
+    }
+  }
+
+  ~Session() { Release(); }
+
+private:
+  void *handle_ = nullptr;
+
+  void Release()
+  {
+    if (handle_ && ABI.session_close)
+      ABI.session_close(handle_);
+    handle_ = nullptr;
+  }
+
+  bool Ready(Napi::Env env, void *fn_ptr, const char *name)
+  {
+    if (!handle_)
+    {
+      Napi::Error::New(env, "session is closed").ThrowAsJavaScriptException();
+      return false;
+    }
+    if (!fn_ptr || !ABI.free_)
+    {
+      ThrowIfMissing(env, fn_ptr, name);
+      ThrowIfMissing(env, (void *)ABI.free_, "free_");
+      return false;
+    }
+    return true;
+  }
+
+  Napi::Value CalculateEic(const Napi::CallbackInfo &info)
+  {
+    Napi::Env env = info.Env();
+    if (!Ready(env, (void *)ABI.session_calculate_eic, "msut_session_calculate_eic"))
+      return env.Undefined();
+
+    double target = info[0].As<Napi::Number>().DoubleValue();
+    double from_rt = info[1].As<Napi::Number>().DoubleValue();
+    double to_rt = info[2].As<Napi::Number>().DoubleValue();
+    double ppm_tol = info[3].As<Napi::Number>().DoubleValue();
+    double mz_tol = info[4].As<Napi::Number>().DoubleValue();
+
+    Buf x_buf = {nullptr, 0};
+    Buf y_buf = {nullptr, 0};
+    int32_t rc = ABI.session_calculate_eic(
+        handle_,
+        target,
+        from_rt, to_rt, ppm_tol, mz_tol,
+        &x_buf, &y_buf);
+    return TakeEic(env, rc, &x_buf, &y_buf, "session_calculate_eic");
+  }
+
+  Napi::Value CalculateEics(const Napi::CallbackInfo &info)
+  {
+    Napi::Env env = info.Env();
+    if (!Ready(env, (void *)ABI.session_calculate_eics, "msut_session_calculate_eics"))
+      return env.Undefined();
+
+    Napi::Float64Array targets_arr = info[0].As<Napi::Float64Array>();
+    double from_rt = info[1].As<Napi::Number>().DoubleValue();
+    double to_rt = info[2].As<Napi::Number>().DoubleValue();
+    Tolerances tol;
+    if (!ReadTolerances(env, info[3], info[4], &tol))
+      return env.Undefined();
+
+    const double *targets = (const double *)((uint8_t *)targets_arr.ArrayBuffer().Data() + targets_arr.ByteOffset());
+
+    Buf x_buf = {nullptr, 0};
+    Buf y_buf = {nullptr, 0};
+    int32_t rc = ABI.session_calculate_eics(
+        handle_,
+        targets, targets_arr.ElementLength(),
+        tol.ppm.data(), tol.mz.data(), tol.ppm.size(),
+        from_rt, to_rt,
+        &x_buf, &y_buf);
+    return TakeEic(env, rc, &x_buf, &y_buf, "session_calculate_eics");
+  }
+
+  Napi::Value GetPeaksFromEic(const Napi::CallbackInfo &info)
+  {
+    Napi::Env env = info.Env();
+    if (!Ready(env, (void *)ABI.session_get_peaks_from_eic, "msut_session_get_peaks_from_eic"))
+      return env.Undefined();
+
+    Napi::Float64Array rts_arr = info[0].As<Napi::Float64Array>();
+    Napi::Float64Array mzs_arr = info[1].As<Napi::Float64Array>();
+    Napi::Float64Array rng_arr = info[2].As<Napi::Float64Array>();
+
+    const double *rts = (const double *)((uint8_t *)rts_arr.ArrayBuffer().Data() + rts_arr.ByteOffset());
+    const double *mzs = (const double *)((uint8_t *)mzs_arr.ArrayBuffer().Data() + mzs_arr.ByteOffset());
+    const double *rng = (const double *)((uint8_t *)rng_arr.ArrayBuffer().Data() + rng_arr.ByteOffset());
+    size_t count = rts_arr.ElementLength();
+    const double *froms = OptionalDoubles(info, 3, count);
+    const double *tos = OptionalDoubles(info, 4, count);
+
+    PackedIds ids;
+    bool has_ids = PackIds(info, 5, count, &ids);
+
+    double from_left = info[6].As<Napi::Number>().DoubleValue();
+    double to_right = info[7].As<Napi::Number>().DoubleValue();
+
+    CPeakPOptions opts;
+    const CPeakPOptions *p_opts = nullptr;
+    if (info.Length() > 8)
+      p_opts = ReadOptionsBuf(info[8], &opts);
+
+    size_t cores = ReadCores(info, 9);
+
+    Buf out = {nullptr, 0};
+    int32_t rc = ABI.session_get_peaks_from_eic(
+        handle_,
+        rts, mzs, rng,
+        froms, tos,
+        has_ids ? ids.offs.data() : nullptr,
+        has_ids ? ids.lens.data() : nullptr,
+        has_ids ? ids.buf.data() : nullptr,
+        ids.buf.size(),
+        count, from_left, to_right, p_opts, cores, nullptr, &out);
+    return TakeJson(env, rc, &out, "session_get_peaks_from_eic");
+  }
+
+  Napi::Value GetPeaksFromChrom(const Napi::CallbackInfo &info)
+  {
+    Napi::Env env = info.Env();
+    if (!Ready(env, (void *)ABI.session_get_peaks_from_chrom, "msut_session_get_peaks_from_chrom"))
+      return env.Undefined();
+
+    Napi::Uint32Array idxs_arr = info[0].As<Napi::Uint32Array>();
+    Napi::Float64Array rts_arr = info[1].As<Napi::Float64Array>();
+    Napi::Float64Array rng_arr = info[2].As<Napi::Float64Array>();
+
+    const uint32_t *idx = (const uint32_t *)((uint8_t *)idxs_arr.ArrayBuffer().Data() + idxs_arr.ByteOffset());
+    const double *rts = (const double *)((uint8_t *)rts_arr.ArrayBuffer().Data() + rts_arr.ByteOffset());
+    const double *rng = (const double *)((uint8_t *)rng_arr.ArrayBuffer().Data() + rng_arr.ByteOffset());
+    size_t count = rts_arr.ElementLength();
+
+    CPeakPOptions opts;
+    const CPeakPOptions *p_opts = nullptr;
+    if (info.Length() > 3)
+      p_opts = ReadOptionsBuf(info[3], &opts);
+
+    size_t cores = ReadCores(info, 4);
+
+    Buf out = {nullptr, 0};
+    int32_t rc = ABI.session_get_peaks_from_chrom(
+        handle_,
+        idx, rts, rng, count,
+        p_opts, cores, &out);
+    return TakeJson(env, rc, &out, "session_get_peaks_from_chrom");
+  }
+
+  Napi::Value Close(const Napi::CallbackInfo &info)
+  {
+    Release();
+    return info.Env().Undefined();
+  }
+};
 
 static Napi::Object Init(Napi::Env env, Napi::Object exports)
 {
   exports.Set("bind", Napi::Function::New(env, Bind));
   exports.Set("parseMzML", Napi::Function::New(env, ParseMzML));
+  exports.Set("convertMzMLToBin1", Napi::Function::New(env, ConvertMzMLToBin1));
   exports.Set("binToJson", Napi::Function::New(env, BinToJson));
   exports.Set("getPeak", Napi::Function::New(env, GetPeak));
   exports.Set("calculateEic", Napi::Function::New(env, CalculateEic));
+  exports.Set("calculateEics", Napi::Function::New(env, CalculateEics));
   exports.Set("findNoiseLevel", Napi::Function::New(env, FindNoiseLevel));
   exports.Set("getPeaksFromEic", Napi::Function::New(env, GetPeaksFromEic));
   exports.Set("getPeaksFromChrom", Napi::Function::New(env, GetPeaksFromChrom));
   exports.Set("findPeaks", Napi::Function::New(env, FindPeaks));
   exports.Set("calculateBaseline", Napi::Function::New(env, CalculateBaseline));
   exports.Set("findFeatures", Napi::Function::New(env, FindFeatures));
+  exports.Set("setThreads", Napi::Function::New(env, SetThreads));
+  exports.Set("Session", Session::Define(env));
   return exports;
 }
 
@@ -87,6 +87,8 @@ export type Target = {
   rt: number;
   mz: number;
   ranges: number;
+  from?: number;
+  to?: number;
 };
 
 export type ChromItem = {
@@ -109,13 +111,36 @@ export type ChromPeak = {
   integral: number;
 };
 
+export type FeatureEngine = "grid" | "massTrace";
+
 export type FindFeaturesOptions = {
+  engine?: FeatureEngine;
   eic?: { ppmTolerance?: number; mzTolerance?: number };
   grid?: { start?: number; end?: number; stepSize?: number };
+  massTrace?: { ppmTolerance?: number };
   findPeak?: PeakOptions;
   cores?: number;
 };
 
+export type RunControl = {
+  signal?: AbortSignal;
+  onProgress?: (fraction: number, stage: string) => void;
+};
+
+async function runControlled(
+  control: RunControl,
+  call: (control: RunControl) => Promise<string>
+): Promise<string> {
+  const { signal, onProgress } = control;
+  signal?.throwIfAborted();
+  try {
+    return await call({ signal, onProgress });
+  } catch (err) {
+    if (signal?.aborted) throw signal.reason;
+    throw err;
+  }
+}
+
 export function packPeakOptions(opts?: PeakOptions): Buffer | undefined {
   if (!opts) return undefined;
   const b = Buffer.alloc(64);
@@ -152,10 +177,31 @@ function toBuffer(v: Uint8Array | ArrayBuffer): Buffer {
     : Buffer.from(new Uint8Array(v));
 }
 
-export function parseMzML(data: Uint8Array | ArrayBuffer): Buffer {
-  const buf = toBuffer(data);
+export type ParseFilter = {
+  msLevels?: number[];
+  fromTo?: { from?: number; to?: number };
+  polarity?: "positive" | "negative";
+  mzArray?: boolean;
+  intensityArray?: boolean;
+  chromatograms?: boolean;
+};
+
+export function parseMzML(
+  data: Uint8Array | ArrayBuffer | string,
+  cores = 1,
+  filter?: ParseFilter
+): Buffer {
+  const input = typeof data === "string" ? data : toBuffer(data);
   const fn = native.parseMzml || native.parseMzML;
-  return fn(buf) as Buffer;
+  return fn(input, cores | 0, filter) as Buffer;
+}
+
+export function convertMzMLToBin1(
+  src: string,
+  dst: string,
+  windowBytes = 0
+): void {
+  native.convertMzMLToBin1(src, dst, windowBytes);
 }
 
 export function binToJson(bin: Uint8Array | ArrayBuffer): string {
@@ -169,16 +215,61 @@ export function calculateEic(
   from: number,
   to: number,
   ppmTol = 20,
-  mzTol = 0.005
+  mzTol = 0.005,
+  cores = 1
 ) {
   const b = toBuffer(bin);
   const fn = native.calculateEic;
-  return fn(b, +targets, from, to, ppmTol, mzTol) as {
+  return fn(b, +targets, from, to, ppmTol, mzTol, cores) as {
     x: Float64Array;
     y: Float64Array;
   };
 }
 
+export type Eics = {
+  x: Float64Array;
+  y: Float64Array[];
+};
+
+function splitRows(
+  res: { x: Float64Array; y: Float64Array },
+  n: number
+): Eics {
+  const w = res.x.length;
+  const y = new Array<Float64Array>(n);
+  for (let i = 0; i < n; i++) y[i] = res.y.subarray(i * w, (i + 1) * w);
+  return { x: res.x, y };
+}
+
+function toTolerance(v: number | ArrayLike<number>) {
+  return typeof v === "number"
+    ? v
+    : v instanceof Float64Array
+    ? v
+    : new Float64Array(v);
+}
+
+export function calculateEics(
+  bin: Uint8Array | ArrayBuffer,
+  targets: ArrayLike<number>,
+  from: number,
+  to: number,
+  ppmTol: number | ArrayLike<number> = 20,
+  mzTol: number | ArrayLike<number> = 0.005
+): Eics {
+  const t =
+    targets instanceof Float64Array ? targets : new Float64Array(targets);
+  const res = native.calculateEics(
+    toBuffer(bin),
+    t,
+    from,
+    to,
+    toTolerance(ppmTol),
+    toTolerance(mzTol)
+  );
+  return splitRows(res, t.length);
+}
+
 export function findPeaks(
   x: Float64Array,
   y: Float64Array,
@@ -203,58 +294,43 @@ export const findNoiseLevel = native.findNoiseLevel as (
   y: Float64Array
 ) => number;
 
-export function getPeaksFromEic(
-  bin: Uint8Array | ArrayBuffer,
-  targets: Target[],
-  fromLeft = 0.5,
-  toRight = 0.5,
-  options?: PeakOptions,
-  cores = 1
-) {
+export type EicPeak = {
+  id?: string;
+  mz: number;
+  ort: number;
+  rt: number;
+  from: number;
+  to: number;
+  intensity: number;
+  integral: number;
+  noise: number;
+};
+
+function packTargets(targets: Target[]) {
   const n = targets.length;
   const rts = new Float64Array(n);
   const mzs = new Float64Array(n);
   const rng = new Float64Array(n);
+  const froms = new Float64Array(n);
+  const tos = new Float64Array(n);
   const ids: string[] = new Array(n);
+  let windowed = false;
   for (let i = 0; i < n; i++) {
     const t = targets[i];
     rts[i] = +t.rt;
     mzs[i] = +t.mz;
     rng[i] = +t.ranges;
+    froms[i] = t.from ?? NaN;
+    tos[i] = t.to ?? NaN;
+    windowed ||= t.from != null || t.to != null;
     ids[i] = t.id ?? "";
   }
-  const b = toBuffer(bin);
-  const optBuf = packPeakOptions(options);
-  const json = native.getPeaksFromEic(
-    b,
-    rts,
-    mzs,
-    rng,
-    ids,
-    +fromLeft,
-    +toRight,
-    optBuf,
-    cores | 0
-  ) as string;
-  return JSON.parse(json) as Array<{
-    id?: string;
-    mz: number;
-    ort: number;
-    rt: number;
-    from: number;
-    to: number;
-    intensity: number;
-    integral: number;
-    noise: number;
-  }>;
+  return windowed
+    ? { rts, mzs, rng, froms, tos, ids }
+    : { rts, mzs, rng, froms: null, tos: null, ids };
 }
 
-export function getPeaksFromChrom(
-  bin: Uint8Array | ArrayBuffer,
-  items: ChromItem[],
-  options?: PeakOptions,
-  cores = 1
-) {
+function packChromItems(items: ChromItem[]) {
   const n = items.length;
   const idxs = new Uint32Array(n);
   const rts = new Float64Array(n);
@@ -271,6 +347,69 @@ export function getPeaksFromChrom(
     const win = it.window ?? it.range ?? 0;
     rng[i] = +win;
   }
+  return { idxs, rts, rng };
+}
+
+function eicArgs(
+  bin: Uint8Array | ArrayBuffer,
+  targets: Target[],
+  fromLeft: number,
+  toRight: number,
+  options: PeakOptions | undefined,
+  cores: number
+) {
+  const { rts, mzs, rng, froms, tos, ids } = packTargets(targets);
+  return [
+    toBuffer(bin),
+    rts,
+    mzs,
+    rng,
+    froms,
+    tos,
+    ids,
+    +fromLeft,
+    +toRight,
+    packPeakOptions(options),
+    cores | 0,
+  ];
+}
+
+export function getPeaksFromEic(
+  bin: Uint8Array | ArrayBuffer,
+  targets: Target[],
+  fromLeft = 0.5,
+  toRight = 0.5,
+  options?: PeakOptions,
+  cores = 1
+) {
+  const args = eicArgs(bin, targets, fromLeft, toRight, options, cores);
+  const json = native.getPeaksFromEic(...args) as string;
+  return JSON.parse(json) as EicPeak[];
+}
+
+export async function getPeaksFromEicAsync(
+  bin: Uint8Array | ArrayBuffer,
+  targets: Target[],
+  fromLeft = 0.5,
+  toRight = 0.5,
+  options?: PeakOptions,
+  cores = 1,
+  control: RunControl = {}
+) {
+  const args = eicArgs(bin, targets, fromLeft, toRight, options, cores);
+  const json = await runControlled(control, (c) =>
+    native.getPeaksFromEic(...args, c)
+  );
+  return JSON.parse(json) as EicPeak[];
+}
+
+export function getPeaksFromChrom(
+  bin: Uint8Array | ArrayBuffer,
+  items: ChromItem[],
+  options?: PeakOptions,
+  cores = 1
+) {
+  const { idxs, rts, rng } = packChromItems(items);
   const b = toBuffer(bin);
   const optBuf = packPeakOptions(options);
   const json = native.getPeaksFromChrom(
@@ -284,6 +423,89 @@ export function getPeaksFromChrom(
   return JSON.parse(json) as ChromPeak[];
 }
 
+export class RunSession {
+  private readonly handle: any;
+
+  constructor(bin: Uint8Array | ArrayBuffer) {
+    this.handle = new native.Session(toBuffer(bin));
+  }
+
+  calculateEic(
+    target: number,
+    from: number,
+    to: number,
+    ppmTol = 20,
+    mzTol = 0.005
+  ) {
+    return this.handle.calculateEic(+target, from, to, ppmTol, mzTol) as {
+      x: Float64Array;
+      y: Float64Array;
+    };
+  }
+
+  calculateEics(
+    targets: ArrayLike<number>,
+    from: number,
+    to: number,
+    ppmTol: number | ArrayLike<number> = 20,
+    mzTol: number | ArrayLike<number> = 0.005
+  ): Eics {
+    const t =
+      targets instanceof Float64Array ? targets : new Float64Array(targets);
+    const res = this.handle.calculateEics(
+      t,
+      from,
+      to,
+      toTolerance(ppmTol),
+      toTolerance(mzTol)
+    );
+    return splitRows(res, t.length);
+  }
+
+  getPeaksFromEic(
+    targets: Target[],
+    fromLeft = 0.5,
+    toRight = 0.5,
+    options?: PeakOptions,
+    cores = 1
+  ) {
+    const { rts, mzs, rng, froms, tos, ids } = packTargets(targets);
+    const json = this.handle.getPeaksFromEic(
+      rts,
+      mzs,
+      rng,
+      froms,
+      tos,
+      ids,
+      +fromLeft,
+      +toRight,
+      packPeakOptions(options),
+      cores | 0
+    ) as string;
+    return JSON.parse(json) as EicPeak[];
+  }
+
+  getPeaksFromChrom(items: ChromItem[], options?: PeakOptions, cores = 1) {
+    const { idxs, rts, rng } = packChromItems(items);
+    const json = this.handle.getPeaksFromChrom(
+      idxs,
+      rts,
+      rng,
+      packPeakOptions(options),
+      cores | 0
+    ) as string;
+    return JSON.parse(json) as ChromPeak[];
+  }
+
+  close(): void {
+    this.handle.close();
+  }
+}
+
+export function openSession(bin: Uint8Array | ArrayBuffer): RunSession {
+  return new RunSession(bin);
+}
+
 export function calculateBaseline(
   y: Float64Array | ArrayLike<number>,
   options?: BaselineOptions
@@ -306,20 +528,22 @@ export type Feature = {
   np: number;
 };
 
-export function findFeatures(
-  data: Uint8Array | ArrayBuffer,
+function featureArgs(
+  data: Uint8Array | ArrayBuffer | string,
   fromTo: { from: number; to: number },
-  options: FindFeaturesOptions = {}
-): Feature[] {
+  options: FindFeaturesOptions
+) {
   const {
+    engine = "grid",
     eic = { mzTolerance: 0.0025, ppmTolerance: 5.0 },
     grid = { start: 20, end: 700, stepSize: 0.005 },
+    massTrace = {},
     findPeak = {},
     cores = 1,
   } = options;
   const { from, to } = fromTo;
 
-  const b = toBuffer(data);
+  const b = typeof data === "string" ? data : toBuffer(data);
 
   const eicPpm =
     typeof eic.ppmTolerance === "number" &&
@@ -352,9 +576,16 @@ export function findFeatures(
 
   console.log("", { stepSize: grid.stepSize, gridStep });
 
+  const tracePpm =
+    typeof massTrace.ppmTolerance === "number" &&
+    Number.isFinite(massTrace.ppmTolerance) &&
+    massTrace.ppmTolerance > 0
+      ? massTrace.ppmTolerance
+      : NaN;
+
   const peakBuf = packPeakOptions(findPeak);
 
-  const s = native.findFeatures(
+  return [
     b,
     from,
     to,
@@ -363,22 +594,55 @@ export function findFeatures(
     gridStart,
     gridEnd,
     gridStep,
+    engine === "massTrace" ? 1 : 0,
+    tracePpm,
     peakBuf ?? null,
-    cores
-  ) as string;
+    cores,
+  ];
+}
+
+export function findFeatures(
+  data: Uint8Array | ArrayBuffer | string,
+  fromTo: { from: number; to: number },
+  options: FindFeaturesOptions = {}
+): Feature[] {
+  const s = native.findFeatures(...featureArgs(data, fromTo, options));
+  return JSON.parse(s as string) as Feature[];
+}
 
+export async function findFeaturesAsync(
+  data: Uint8Array | ArrayBuffer | string,
+  fromTo: { from: number; to: number },
+  options: FindFeaturesOptions = {},
+  control: RunControl = {}
+): Promise<Feature[]> {
+  const args = featureArgs(data, fromTo, options);
+  const s = await runControlled(control, (c) =>
+    native.findFeatures(...args, c)
+  );
   return JSON.parse(s) as Feature[];
 }
 
+export function setThreads(threads: number, cpus: number[] = []): void {
+  native.setThreads(threads, Int32Array.from(cpus));
+}
+
 module.exports = {
   parseMzML,
+  convertMzMLToBin1,
   binToJson,
   calculateEic,
+  calculateEics,
   getPeak,
   findPeaks,
   findNoiseLevel,
   getPeaksFromEic,
+  getPeaksFromEicAsync,
   getPeaksFromChrom,
+  openSession,
+  RunSession,
   calculateBaseline,
   findFeatures,
+  findFeaturesAsync,
+  setThreads,
 };
@@ -88,6 +88,8 @@ export interface Exports {
 
   findNoiseLevel: (y: Float32Array) => number;
 
+  setThreads: (threads: number, cpus?: number[]) => void;
+
   __debug: {
     memory: WebAssembly.Memory;
     exports: Record<string, any>;
@@ -171,6 +173,8 @@ export function makeApi(instanceOrModule: any): Exports {
     rtsPtr: number,
     mzsPtr: number,
     rangesPtr: number,
+    fromsPtr: number,
+    tosPtr: number,
     idsOffPtr: number,
     idsLenPtr: number,
     idsBufPtr: number,
@@ -180,6 +184,7 @@ export function makeApi(instanceOrModule: any): Exports {
     toRight: number,
     optionsPtr: number,
     cores: number,
+    progressPtr: number,
     outJsonBuf: number
   ) => number = pickFn(ex, ["C_get_peaks_from_eic"]);
 
@@ -538,6 +543,8 @@ export function makeApi(instanceOrModule: any): Exports {
       rtsPtr,
       mzsPtr,
       rngPtr,
+      0,
+      0,
       offPtr,
       lenPtr,
       idbPtr,
@@ -547,6 +554,7 @@ export function makeApi(instanceOrModule: any): Exports {
       window.to,
       pOpts,
       cores,
+      0,
       SCRATCH_JSON
     );
 
@@ -658,6 +666,21 @@ export function makeApi(instanceOrModule: any): Exports {
     return { x: X, y: Y };
   };
 
+  const setThreads = (threads: number, cpus: number[] = []) => {
+    const set_threads: (
+      threads: number,
+      cpusPtr: number,
+      cpusLen: number
+    ) => number = pickFn(ex, ["msut_set_threads"]);
+
+    const bytes = new Uint8Array(Int32Array.from(cpus).buffer);
+    const p = bytes.length ? alloc(bytes.length) : 0;
+    if (p) heapWrite(p, bytes);
+    const rc = set_threads(threads | 0, p, cpus.length);
+    if (p) free(p, bytes.length);
+    if (rc !== 0) throw new Error(`msut_set_threads failed: ${rc}`);
+  };
+
   return {
     parseMzML,
     calculateEic,
@@ -666,6 +689,7 @@ export function makeApi(instanceOrModule: any): Exports {
     getPeaksFromEic,
     findPeaks,
     findNoiseLevel,
+    setThreads,
     __debug: { memory, exports: ex, heapBytes: () => memory.buffer.byteLength },
   };
 }
@@ -0,0 +1,21 @@
+const { calculateEics } = require("../lib/index-node.js");
+
+const targets = [100, 200, 300];
+
+test("mismatched tolerance lengths throw a TypeError", () => {
+  expect(() =>
+    calculateEics(new Uint8Array(0), targets, 0, 10, [5, 10], [0.01, 0.02, 0.03])
+  ).toThrow(TypeError);
+  expect(() =>
+    calculateEics(new Uint8Array(0), targets, 0, 10, [5, 10, 15], [0.01, 0.02])
+  ).toThrow(TypeError);
+});
+
+test("a single tolerance broadcasts against a list", () => {
+  expect(() =>
+    calculateEics(new Uint8Array(0), targets, 0, 10, 5, [0.01, 0.02, 0.03])
+  ).not.toThrow(TypeError);
+  expect(() =>
+    calculateEics(new Uint8Array(0), targets, 0, 10, [5, 10, 15], 0.01)
+  ).not.toThrow(TypeError);
+});
@@ -43,19 +43,40 @@ typedef struct
   double sn_ratio;
 } CPeakPOptions;
 
-typedef int32_t (*fn_parse_mzml)(const unsigned char *, size_t, Buf *);
+typedef struct
+{
+  const uint8_t *ms_levels;
+  size_t ms_levels_len;
+  double rt_from;
+  double rt_to;
+  int32_t polarity;
+  int32_t mz_array;
+  int32_t intensity_array;
+  int32_t chromatograms;
+} CParseFilter;
+
+typedef int32_t (*fn_parse_mzml)(const unsigned char *, size_t, size_t, Buf *);
+typedef int32_t (*fn_parse_mzml_path)(const char *, size_t, Buf *);
+typedef int32_t (*fn_parse_mzml_filtered)(const unsigned char *, size_t, size_t, const CParseFilter *, Buf *);
+typedef int32_t (*fn_parse_mzml_path_filtered)(const char *, size_t, const CParseFilter *, Buf *);
+typedef int32_t (*fn_convert_mzml_to_bin1)(const char *, const char *, size_t);
 typedef int32_t (*fn_bin_to_json)(const unsigned char *, size_t, Buf *);
 typedef int32_t (*fn_get_peak)(const double *, const double *, size_t, double, double, const CPeakPOptions *, Buf *);
-typedef int32_t (*fn_calculate_eic)(const unsigned char *, size_t, double, double, double, double, double, Buf *, Buf *);
+typedef int32_t (*fn_calculate_eic)(const unsigned char *, size_t, double, double, double, double, double, size_t, Buf *, Buf *);
 typedef float (*fn_find_noise_level)(const float *, size_t);
-typedef int32_t (*fn_get_peaks_from_eic)(const unsigned char *, size_t, const double *, const double *, const double *, const uint32_t *, const uint32_t *, const unsigned char *, size_t, size_t, double, double, const CPeakPOptions *, size_t, Buf *);
+typedef int32_t (*fn_get_peaks_from_eic)(const unsigned char *, size_t, const double *, const double *, const double *, const double *, const double *, const uint32_t *, const uint32_t *, const unsigned char *, size_t, size_t, double, double, const CPeakPOptions *, size_t, const void *, Buf *);
 typedef int32_t (*fn_get_peaks_from_chrom)(const unsigned char *, size_t, const uint32_t *, const double *, const double *, size_t, const CPeakPOptions *, size_t, Buf *);
 typedef int32_t (*fn_find_peaks)(const double *, const double *, size_t, const CPeakPOptions *, Buf *);
+typedef int32_t (*fn_set_threads)(int32_t, const int32_t *, size_t);
 typedef void (*fn_free_)(unsigned char *, size_t);
 
 typedef struct
 {
   fn_parse_mzml parse_mzml;
+  fn_parse_mzml_path parse_mzml_path;
+  fn_parse_mzml_filtered parse_mzml_filtered;
+  fn_parse_mzml_path_filtered parse_mzml_path_filtered;
+  fn_convert_mzml_to_bin1 convert_mzml_to_bin1;
   fn_bin_to_json bin_to_json;
   fn_get_peak get_peak;
   fn_calculate_eic calculate_eic;
@@ -63,6 +84,7 @@ typedef struct
   fn_get_peaks_from_eic C_get_peaks_from_eic;
   fn_get_peaks_from_chrom C_get_peaks_from_chrom;
   fn_find_peaks find_peaks;
+  fn_set_threads set_threads;
   fn_free_ free_;
 } abi_type;
 
@@ -108,10 +130,15 @@ int abi_load(const char *path, const char **err)
     goto fail;
   if (resolve_required((void **)&ABI.calculate_eic, "calculate_eic"))
     goto fail;
+  resolve_optional2((void **)&ABI.parse_mzml_path, "parse_mzml_path", NULL);
+  resolve_optional2((void **)&ABI.parse_mzml_filtered, "parse_mzml_filtered", NULL);
+  resolve_optional2((void **)&ABI.parse_mzml_path_filtered, "parse_mzml_path_filtered", NULL);
+  resolve_optional2((void **)&ABI.convert_mzml_to_bin1, "convert_mzml_to_bin1", NULL);
   resolve_optional2((void **)&ABI.find_noise_level, "find_noise_level", NULL);
   resolve_optional2((void **)&ABI.C_get_peaks_from_eic, "C_get_peaks_from_eic", "get_peaks_from_eic");
   resolve_optional2((void **)&ABI.C_get_peaks_from_chrom, "C_get_peaks_from_chrom", "get_peaks_from_chrom");
   resolve_optional2((void **)&ABI.find_peaks, "find_peaks", "C_find_peaks");
+  resolve_optional2((void **)&ABI.set_threads, "msut_set_threads", NULL);
   ABI.free_ = (fn_free_)DLSYM(abi_handle, "free_");
   if (!ABI.free_)
     goto fail;
@@ -147,8 +174,12 @@ static void die_code(const char *fname, int code)
     msg = "invalid arguments";
   else if (code == 2)
     msg = "panic inside Rust";
+  else if (code == 3)
+    msg = "i/o error";
   else if (code == 4)
     msg = "parse error";
+  else if (code == 5)
+    msg = "cancelled";
   error("msut/%s failed: %s (code=%d)", fname, msg, code);
 }
 
@@ -237,6 +268,63 @@ static int fill_options(SEXP opts, CPeakPOptions *out)
   return 1;
 }
 
+static int fill_parse_filter(SEXP filter, CParseFilter *out)
+{
+  if (filter == R_NilValue || TYPEOF(filter) != VECSXP)
+    return 0;
+  out->ms_levels = NULL;
+  out->ms_levels_len = 0;
+  out->rt_from = NAN;
+  out->rt_to = NAN;
+  out->polarity = -1;
+  out->mz_array = 1;
+  out->intensity_array = 1;
+  out->chromatograms = 1;
+  SEXP v = R_NilValue;
+  v = list_get(filter, "ms_levels");
+  if (v != R_NilValue)
+  {
+    R_xlen_t n = XLENGTH(v);
+    uint8_t *levels = (uint8_t *)R_alloc((size_t)(n > 0 ? n : 1), 1);
+    for (R_xlen_t i = 0; i < n; i++)
+    {
+      int level = TYPEOF(v) == INTSXP ? INTEGER(v)[i] : (int)REAL(v)[i];
+      if (level < 1 || level > 255)
+        error("msut: ms_levels must hold integers in 1..255");
+      levels[i] = (uint8_t)level;
+    }
+    out->ms_levels = levels;
+    out->ms_levels_len = (size_t)n;
+  }
+  v = list_get(filter, "from");
+  if (v != R_NilValue)
+    out->rt_from = asReal(v);
+  v = list_get(filter, "to");
+  if (v != R_NilValue)
+    out->rt_to = asReal(v);
+  v = list_get(filter, "polarity");
+  if (v != R_NilValue)
+  {
+    const char *p = isString(v) && XLENGTH(v) == 1 ? CHAR(STRING_ELT(v, 0)) : "";
+    if (strcmp(p, "positive") == 0)
+      out->polarity = 0;
+    else if (strcmp(p, "negative") == 0)
+      out->polarity = 1;
+    else
+      error("msut: polarity must be \"positive\" or \"negative\"");
+  }
+  v = list_get(filter, "mz_array");
+  if (v != R_NilValue)
+    out->mz_array = (int32_t)asLogical(v);
+  v = list_get(filter, "intensity_array");
+  if (v != R_NilValue)
+    out->intensity_array = (int32_t)asLogical(v);
+  v = list_get(filter, "chromatograms");
+  if (v != R_NilValue)
+    out->chromatograms = (int32_t)asLogical(v);
+  return 1;
+}
+
 static int as_opts_ptr(SEXP options, CPeakPOptions *copy, const CPeakPOptions **out_ptr)
 {
   *out_ptr = NULL;
@@ -272,14 +360,25 @@ SEXP C_bind_rust(SEXP path_)
   return R_NilValue;
 }
 
-SEXP C_parse_mzml(SEXP data)
+SEXP C_parse_mzml(SEXP data, SEXP cores, SEXP filter)
 {
   if (TYPEOF(data) != RAWSXP)
     error("data");
   REQUIRE_BOUND(ABI.parse_mzml, "parse_mzml");
   REQUIRE_BOUND(ABI.free_, "free_");
+  size_t ncores = (cores == R_NilValue) ? 1 : (size_t)asInteger(cores);
+  if (ncores < 1)
+    ncores = 1;
+  CParseFilter f;
   Buf out = (Buf){0};
-  int code = ABI.parse_mzml((const unsigned char *)RAW(data), (size_t)XLENGTH(data), &out);
+  int code;
+  if (fill_parse_filter(filter, &f))
+  {
+    REQUIRE_BOUND(ABI.parse_mzml_filtered, "parse_mzml_filtered");
+    code = ABI.parse_mzml_filtered((const unsigned char *)RAW(data), (size_t)XLENGTH(data), ncores, &f, &out);
+  }
+  else
+    code = ABI.parse_mzml((const unsigned char *)RAW(data), (size_t)XLENGTH(data), ncores, &out);
   die_code("parse_mzml", code);
   SEXP res = PROTECT(Rf_allocVector(RAWSXP, (R_xlen_t)out.len));
   memcpy(RAW(res), out.ptr, out.len);
@@ -288,6 +387,63 @@ SEXP C_parse_mzml(SEXP data)
   return res;
 }
 
+SEXP C_parse_mzml_path(SEXP path, SEXP cores, SEXP filter)
+{
+  if (!isString(path) || XLENGTH(path) != 1)
+    error("path");
+  REQUIRE_BOUND(ABI.parse_mzml_path, "parse_mzml_path");
+  REQUIRE_BOUND(ABI.free_, "free_");
+  size_t ncores = (cores == R_NilValue) ? 1 : (size_t)asInteger(cores);
+  if (ncores < 1)
+    ncores = 1;
+  CParseFilter f;
+  Buf out = (Buf){0};
+  int code;
+  if (fill_parse_filter(filter, &f))
+  {
+    REQUIRE_BOUND(ABI.parse_mzml_path_filtered, "parse_mzml_path_filtered");
+    code = ABI.parse_mzml_path_filtered(translateCharUTF8(STRING_ELT(path, 0)), ncores, &f, &out);
+  }
+  else
+    code = ABI.parse_mzml_path(translateCharUTF8(STRING_ELT(path, 0)), ncores, &out);
+  die_code("parse_mzml_path", code);
+  SEXP res = PROTECT(Rf_allocVector(RAWSXP, (R_xlen_t)out.len));
+  memcpy(RAW(res), out.ptr, out.len);
+  ABI.free_(out.ptr, out.len);
+  UNPROTECT(1);
+  return res;
+}
+
+SEXP C_convert_mzml_to_bin1(SEXP src, SEXP dst, SEXP window)
+{
+  if (!isString(src) || XLENGTH(src) != 1)
+    error("src");
+  if (!isString(dst) || XLENGTH(dst) != 1)
+    error("dst");
+  REQUIRE_BOUND(ABI.convert_mzml_to_bin1, "convert_mzml_to_bin1");
+  double w = (window == R_NilValue) ? 0.0 : asReal(window);
+  size_t nwindow = (ISNAN(w) || w < 1.0) ? 0 : (size_t)w;
+  int code = ABI.convert_mzml_to_bin1(
+      translateCharUTF8(STRING_ELT(src, 0)),
+      translateCharUTF8(STRING_ELT(dst, 0)),
+      nwindow);
+  die_code("convert_mzml_to_bin1", code);
+  return R_NilValue;
+}
+
+SEXP C_set_threads(SEXP threads, SEXP cpus)
+{
+  if (!isInteger(cpus))
+    error("cpus");
+  REQUIRE_BOUND(ABI.set_threads, "msut_set_threads");
+  int n = asInteger(threads);
+  if (n == NA_INTEGER || n < 0)
+    error("threads");
+  int code = ABI.set_threads((int32_t)n, (const int32_t *)INTEGER(cpus), (size_t)XLENGTH(cpus));
+  die_code("msut_set_threads", code);
+  return R_NilValue;
+}
+
 SEXP C_bin_to_json(SEXP bin)
 {
   if (TYPEOF(bin) != RAWSXP)
@@ -322,7 +478,7 @@ SEXP C_get_peak(SEXP x, SEXP y, SEXP rt, SEXP range, SEXP options)
   return res;
 }
 
-SEXP C_get_peaks_from_eic(SEXP bin, SEXP rts, SEXP mzs, SEXP ranges, SEXP ids, SEXP from_left, SEXP to_right, SEXP options, SEXP cores)
+SEXP C_get_peaks_from_eic(SEXP bin, SEXP rts, SEXP mzs, SEXP ranges, SEXP froms, SEXP tos, SEXP ids, SEXP from_left, SEXP to_right, SEXP options, SEXP cores)
 {
   if (TYPEOF(bin) != RAWSXP || TYPEOF(rts) != REALSXP || TYPEOF(mzs) != REALSXP || TYPEOF(ranges) != REALSXP)
     error("bad args");
@@ -331,6 +487,14 @@ SEXP C_get_peaks_from_eic(SEXP bin, SEXP rts, SEXP mzs, SEXP ranges, SEXP ids, S
   REQUIRE_BOUND(ABI.C_get_peaks_from_eic, "get_peaks_from_eic");
   REQUIRE_BOUND(ABI.free_, "free_");
   R_xlen_t n = XLENGTH(rts);
+  const double *from_ptr = NULL, *to_ptr = NULL;
+  if (froms != R_NilValue && tos != R_NilValue)
+  {
+    if (TYPEOF(froms) != REALSXP || TYPEOF(tos) != REALSXP || XLENGTH(froms) != n || XLENGTH(tos) != n)
+      error("from/to must be numeric with one value per target");
+    from_ptr = REAL(froms);
+    to_ptr = REAL(tos);
+  }
   uint32_t *offs = NULL, *lens = NULL;
   unsigned char *ids_buf = NULL;
   size_t ids_len = 0;
@@ -378,10 +542,11 @@ SEXP C_get_peaks_from_eic(SEXP bin, SEXP rts, SEXP mzs, SEXP ranges, SEXP ids, S
   int code = ABI.C_get_peaks_from_eic(
       (const unsigned char *)RAW(bin), (size_t)XLENGTH(bin),
       REAL(rts), REAL(mzs), REAL(ranges),
+      from_ptr, to_ptr,
       (const uint32_t *)offs, (const uint32_t *)lens,
       (const unsigned char *)ids_buf, (size_t)ids_len,
       (size_t)n, asReal(from_left), asReal(to_right),
-      opt_ptr, ncores, &out);
+      opt_ptr, ncores, NULL, &out);
   die_code("get_peaks_from_eic", code);
   SEXP res = mk_string_len(out.ptr, out.len);
   ABI.free_(out.ptr, out.len);
@@ -439,7 +604,7 @@ SEXP C_get_peaks_from_chrom(SEXP bin, SEXP idxs, SEXP rts, SEXP ranges, SEXP opt
   return res;
 }
 
-SEXP C_calculate_eic(SEXP bin, SEXP targets, SEXP from, SEXP to, SEXP ppm_tol, SEXP mz_tol)
+SEXP C_calculate_eic(SEXP bin, SEXP targets, SEXP from, SEXP to, SEXP ppm_tol, SEXP mz_tol, SEXP cores)
 {
   if (TYPEOF(bin) != RAWSXP)
     error("bin");
@@ -448,12 +613,16 @@ SEXP C_calculate_eic(SEXP bin, SEXP targets, SEXP from, SEXP to, SEXP ppm_tol, S
   REQUIRE_BOUND(ABI.calculate_eic, "calculate_eic");
   REQUIRE_BOUND(ABI.free_, "free_");
   double t = asReal(targets);
+  size_t ncores = (cores == R_NilValue) ? 1 : (size_t)asInteger(cores);
+  if (ncores < 1)
+    ncores = 1;
   Buf bx = (Buf){0}, by = (Buf){0};
   int code = ABI.calculate_eic(
       (const unsigned char *)RAW(bin), (size_t)XLENGTH(bin),
       t,
       asReal(from), asReal(to),
       asReal(ppm_tol), asReal(mz_tol),
+      ncores,
       &bx, &by);
   die_code("calculate_eic", code);
   size_t nx = bx.len / 8;